@@ -0,0 +1,312 @@
+#ifndef TRILATERATION_MULTILATERATE_HPP_INCLUDED
+#define TRILATERATION_MULTILATERATE_HPP_INCLUDED
+
+/*
+  least squares position from N >= 3 spheres
+  seeded from the closed form trilateration of the triple of the spheres, or its mirror, best fitting all of them
+  then refined by Levenberg-Marquardt on the range residuals |p - centre| - radius.
+  a solve that does not converge, or leaves a residual norm over max_residual, is no_fit.
+  with few spheres two separate positions can both fit within the noise, 
+  with 4 spheres in a random 20 km cube and 10 m noise about 1 in 100.
+  if max_residual is set the best seed further than max_residual from the fix is refined too
+  and if it also fits, further than max_residual away, the solve is ambiguous
+
+  the normal equations are accumulated per sphere so no storage per sphere is needed
+  and nothing is allocated
+
+  the functions taking Count work with a runtime std::size_t 
+  or a std::integral_constant for the fixed size path
+*/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include "trilaterate_batch.hpp"
+#include "trilaterate_prepared.hpp"
+
+namespace {
+
+   struct multilaterate_options{
+      int max_iterations = 20;
+      // stop when the step is smaller than this
+      quan::length::km tolerance = 1.e-9_km;
+      // initial Levenberg-Marquardt damping, 0 for Gauss-Newton
+      double lambda = 1.e-3;
+      // a larger residual norm is no_fit, 0 for no limit and no ambiguity check
+      // for ranges out by at most e the least squares residual norm is at most e * sqrt(N)
+      quan::length::km max_residual = 0_km;
+   };
+
+   struct multilaterate_result{
+      point position;
+      // sqrt of the sum of squared range residuals
+      quan::length::km residual_norm;
+      int iterations;
+      bool converged;
+   };
+
+   // sqrt of sum of squared range residuals at p
+   template <typename Count>
+   inline quan::length::km range_residual_norm(sphere const * spheres, Count num_spheres, point const & p)
+   {
+      auto sum = quan::pow<2>(0_km);
+      for ( std::size_t n = 0; n < num_spheres; ++n){
+         sum += quan::pow<2>(magnitude(p - spheres[n].centre) - spheres[n].radius);
+      }
+      return sqrt(sum);
+   }
+
+   // the best fitting seeds, by range residual norm
+   struct multilaterate_seeds{
+      static constexpr std::size_t capacity = 8;
+      point position[capacity];
+      quan::length::km residual[capacity];
+      std::size_t size = 0;
+
+      void add(point const & p, quan::length::km const & r)
+      {
+         std::size_t n = (size < capacity) ? size++ : capacity;
+         for ( ; (n > 0) && (r < residual[n - 1]); --n){
+            if ( n < capacity){
+               position[n] = position[n - 1];
+               residual[n] = residual[n - 1];
+            }
+         }
+         if ( n < capacity){
+            position[n] = p;
+            residual[n] = r;
+         }
+      }
+   };
+
+   // the closed form solutions of every triple of the spheres and their mirrors in the plane of the triple,
+   // best fitting all spheres first, so a seed near a wrong local minimum of the residual loses
+   // if noisy ranges mean no triple has a solution, the only seed is the centroid of the centres
+   // returns false only if all the centres are on one line
+   template <typename Count>
+   inline bool multilaterate_seed(sphere const * spheres, Count num_spheres, multilaterate_seeds & seeds)
+   {
+      bool have_valid_triple = false;
+      seeds.size = 0;
+      auto try_seed = [&](point const & p){
+         seeds.add(p,range_residual_norm(spheres,num_spheres,p));
+      };
+      for ( std::size_t a = 0; a < num_spheres; ++a){
+         for ( std::size_t b = a + 1; b < num_spheres; ++b){
+            for ( std::size_t c = b + 1; c < num_spheres; ++c){
+               prepared_anchor_triple const triple{spheres[a].centre,spheres[b].centre,spheres[c].centre};
+               if ( !triple.is_valid()){
+                  continue;
+               }
+               have_valid_triple = true;
+               point ip;
+               if ( triple.trilaterate(spheres[a].radius,spheres[b].radius,spheres[c].radius,ip) == trilaterate_status::solved){
+                  point const ip_norm = triple.to_norm(ip);
+                  try_seed(ip);
+                  try_seed(triple.to_world(point{ip_norm.x,ip_norm.y,-ip_norm.z}));
+               }
+            }
+         }
+      }
+      if ( !have_valid_triple){
+         return false;
+      }
+      if ( seeds.size == 0){
+         point sum{0_km,0_km,0_km};
+         for ( std::size_t n = 0; n < num_spheres; ++n){
+            sum = sum + spheres[n].centre;
+         }
+         try_seed(sum / static_cast<double>(num_spheres));
+      }
+      return true;
+   }
+
+   // whether a refined result converged within the residual limit
+   inline bool multilaterate_fits(multilaterate_options const & options, multilaterate_result const & result)
+   {
+      return result.converged
+         && ( (options.max_residual <= 0_km) || (result.residual_norm <= options.max_residual));
+   }
+
+   // solve the symmetric 3x3 system m * x = v by Cramer's rule
+   inline bool solve_3x3(double const (&m)[3][3], point const & v, point & x)
+   {
+      double const det = 
+           m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) 
+         - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) 
+         + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+      if ( std::abs(det) < 1.e-15){
+         return false;
+      }
+      x.x = ( v.x * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+            - v.y * (m[0][1] * m[2][2] - m[0][2] * m[2][1])
+            + v.z * (m[0][1] * m[1][2] - m[0][2] * m[1][1]) ) / det;
+      x.y = ( - v.x * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+            + v.y * (m[0][0] * m[2][2] - m[0][2] * m[2][0])
+            - v.z * (m[0][0] * m[1][2] - m[0][2] * m[1][0]) ) / det;
+      x.z = ( v.x * (m[1][0] * m[2][1] - m[1][1] * m[2][0])
+            - v.y * (m[0][0] * m[2][1] - m[0][1] * m[2][0])
+            + v.z * (m[0][0] * m[1][1] - m[0][1] * m[1][0]) ) / det;
+      return true;
+   }
+
+   // refine position by Levenberg-Marquardt
+   template <typename Count>
+   inline void multilaterate_refine(sphere const * spheres, Count num_spheres, 
+      multilaterate_options const & options, multilaterate_result & result)
+   {
+      double lambda = options.lambda;
+      result.residual_norm = range_residual_norm(spheres,num_spheres,result.position);
+      result.iterations = 0;
+      result.converged = false;
+      while ( result.iterations < options.max_iterations){
+         ++result.iterations;
+         // normal equations J^T J and -J^T r
+         double jtj[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
+         point jtr{0_km,0_km,0_km};
+         for ( std::size_t n = 0; n < num_spheres; ++n){
+            auto const v = result.position - spheres[n].centre;
+            auto const dist = magnitude(v);
+            if ( dist < epsilon_km){
+               continue;
+            }
+            auto const g = v / dist;
+            double const row[3] = {g.x,g.y,g.z};
+            for ( int r = 0; r < 3; ++r){
+               for ( int c = 0; c < 3; ++c){
+                  jtj[r][c] += row[r] * row[c];
+               }
+            }
+            jtr = jtr - g * (dist - spheres[n].radius);
+         }
+         double damped[3][3];
+         for ( int r = 0; r < 3; ++r){
+            for ( int c = 0; c < 3; ++c){
+               damped[r][c] = jtj[r][c];
+            }
+            damped[r][r] *= (1.0 + lambda);
+         }
+         point step;
+         if ( !solve_3x3(damped,jtr,step)){
+            return;
+         }
+         point const candidate = result.position + step;
+         auto const candidate_residual = range_residual_norm(spheres,num_spheres,candidate);
+         if ( candidate_residual <= result.residual_norm){
+            // actual over linearised reduction of the squared residual
+            // a poor ratio is Gauss-Newton zigzagging across a narrow valley, so damp more
+            quan::length::km const s[3] = {step.x,step.y,step.z};
+            auto s_jtj_s = quan::pow<2>(0_km);
+            for ( int r = 0; r < 3; ++r){
+               for ( int c = 0; c < 3; ++c){
+                  s_jtj_s += s[r] * jtj[r][c] * s[c];
+               }
+            }
+            auto const predicted = 2 * (step.x * jtr.x + step.y * jtr.y + step.z * jtr.z) - s_jtj_s;
+            auto const actual = quan::pow<2>(result.residual_norm) - quan::pow<2>(candidate_residual);
+            result.position = candidate;
+            result.residual_norm = candidate_residual;
+            if ( magnitude(step) < options.tolerance){
+               result.converged = true;
+               return;
+            }
+            if ( !(actual < 0.25 * predicted)){
+               lambda /= 10;
+            }else if ( lambda != 0){
+               // lambda may have been divided down to nothing by earlier good steps
+               lambda = std::max(lambda,options.lambda) * 10;
+            }
+         }else{
+            if ( lambda == 0){
+               // Gauss-Newton step made things worse
+               return;
+            }
+            lambda *= 10;
+         }
+      }
+   }
+
+   // refine the best seed, then if max_residual is set each seed further than that from the fix
+   // until one refines to another fit further than that from the fix
+   // result is the better fitting of the two
+   template <typename Count>
+   inline trilaterate_status multilaterate_solve(sphere const * spheres, Count num_spheres,
+      multilaterate_seeds const & seeds, multilaterate_options const & options, multilaterate_result & result)
+   {
+      result.position = seeds.position[0];
+      multilaterate_refine(spheres,num_spheres,options,result);
+      if ( !multilaterate_fits(options,result)){
+         return trilaterate_status::no_fit;
+      }
+      if ( options.max_residual <= 0_km){
+         return trilaterate_status::solved;
+      }
+      for ( std::size_t n = 1; n < seeds.size; ++n){
+         if ( !(magnitude(seeds.position[n] - result.position) > options.max_residual)){
+            continue;
+         }
+         multilaterate_result other;
+         other.position = seeds.position[n];
+         multilaterate_refine(spheres,num_spheres,options,other);
+         if ( multilaterate_fits(options,other)
+               && (magnitude(other.position - result.position) > options.max_residual)){
+            if ( other.residual_norm < result.residual_norm){
+               result = other;
+            }
+            return trilaterate_status::ambiguous;
+         }
+      }
+      return trilaterate_status::solved;
+   }
+
+   // least squares position from num_spheres >= 3 spheres
+   // degenerate_C if there are less than 3 spheres or the centres are all on one line
+   // no_fit if the refinement did not converge or left a residual over options.max_residual
+   // ambiguous if another position further than max_residual away fits too
+   // result holds the refined position unless degenerate_C
+   // no diagnostic output
+   inline trilaterate_status multilaterate(sphere const * spheres, std::size_t num_spheres, multilaterate_result & result,
+      multilaterate_options const & options = multilaterate_options{})
+   {
+      multilaterate_seeds seeds;
+      if ( (num_spheres < 3) || !multilaterate_seed(spheres,num_spheres,seeds)){
+         return trilaterate_status::degenerate_C;
+      }
+      return multilaterate_solve(spheres,num_spheres,seeds,options,result);
+   }
+
+   // num_sets sets of num_spheres spheres, set n starting at spheres + n * num_spheres
+   // status[n] is set to the status of multilaterate for set n
+   // returns the number of sets solved
+   inline std::size_t multilaterate_batch(sphere const * spheres, std::size_t num_spheres, std::size_t num_sets,
+      multilaterate_result * results, trilaterate_status * status,
+      multilaterate_options const & options = multilaterate_options{})
+   {
+      std::size_t num_solved = 0;
+      for ( std::size_t n = 0; n < num_sets; ++n){
+         status[n] = multilaterate(spheres + n * num_spheres,num_spheres,results[n],options);
+         num_solved += (status[n] == trilaterate_status::solved);
+      }
+      return num_solved;
+   }
+
+   // fixed small N, the loops have constant trip count
+   template <std::size_t N>
+   inline trilaterate_status multilaterate(std::array<sphere,N> const & spheres, multilaterate_result & result,
+      multilaterate_options const & options = multilaterate_options{})
+   {
+      static_assert( (N >= 3) && (N <= 8), "fixed size multilaterate is for 3 to 8 spheres");
+      std::integral_constant<std::size_t,N> constexpr num_spheres{};
+      multilaterate_seeds seeds;
+      if ( !multilaterate_seed(spheres.data(),num_spheres,seeds)){
+         return trilaterate_status::degenerate_C;
+      }
+      return multilaterate_solve(spheres.data(),num_spheres,seeds,options,result);
+   }
+
+} // namespace
+
+#endif // TRILATERATION_MULTILATERATE_HPP_INCLUDED
@@ -0,0 +1,165 @@
+#ifndef TRILATERATION_MULTILATERATE_LINEAR_HPP_INCLUDED
+#define TRILATERATION_MULTILATERATE_LINEAR_HPP_INCLUDED
+
+/*
+  linear least squares position from a fixed constellation of N >= 4 spheres
+
+  subtracting the equation of sphere 0 from sphere k gives the linear equation
+     2 * (centre_k - centre_0) . p = r_0^2 - r_k^2 + |centre_k|^2 - |centre_0|^2
+  The matrix of the N-1 equations depends only on the centres, so its 
+  pseudo inverse is found once from a QR factorisation,
+  after which each position is one 3 x (N-1) matrix vector product on the squared radii
+
+  unlike multilaterate the result is not refined, so with noisy ranges it is a little biased
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "trilaterate_batch.hpp"
+
+namespace {
+
+   class anchor_constellation{
+   public:
+      typedef decltype(1 / 1_km) per_km;
+      typedef decltype(quan::pow<2>(1_km)) km2;
+
+      // the centres must not all be on one plane
+      anchor_constellation(point const * centres, std::size_t num_centres)
+      : m_num_centres{num_centres}, m_valid{false}
+      {
+         if ( num_centres < 4){
+            return;
+         }
+         std::size_t const m = num_centres - 1;
+         // columns of the matrix as numeric km 
+         std::vector<double> a[3];
+         for ( int c = 0; c < 3; ++c){
+            a[c].resize(m);
+         }
+         m_b_offset.resize(m);
+         auto const c0 = centres[0];
+         for ( std::size_t k = 0; k < m; ++k){
+            auto const v = 2 * (centres[k+1] - c0);
+            a[0][k] = v.x.numeric_value();
+            a[1][k] = v.y.numeric_value();
+            a[2][k] = v.z.numeric_value();
+            m_b_offset[k] = dot_product(centres[k+1],centres[k+1]) - dot_product(c0,c0);
+         }
+         // the centres are coplanar if a column has nothing left after orthogonalising
+         // relative to the largest column, so the test is the same at any scale
+         double max_norm = 0;
+         for ( int c = 0; c < 3; ++c){
+            double norm = 0;
+            for ( std::size_t k = 0; k < m; ++k){
+               norm += a[c][k] * a[c][k];
+            }
+            max_norm = std::max(max_norm,std::sqrt(norm));
+         }
+         // about the square root of the double epsilon
+         double const min_norm = 1.e-8 * max_norm;
+         // modified Gram-Schmidt QR, columns of a are replaced by Q
+         double r[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
+         for ( int c = 0; c < 3; ++c){
+            for ( int p = 0; p < c; ++p){
+               double dot = 0;
+               for ( std::size_t k = 0; k < m; ++k){
+                  dot += a[p][k] * a[c][k];
+               }
+               r[p][c] = dot;
+               for ( std::size_t k = 0; k < m; ++k){
+                  a[c][k] -= dot * a[p][k];
+               }
+            }
+            double norm = 0;
+            for ( std::size_t k = 0; k < m; ++k){
+               norm += a[c][k] * a[c][k];
+            }
+            r[c][c] = std::sqrt(norm);
+            // coplanar centres
+            if ( !(r[c][c] > min_norm)){
+               return;
+            }
+            for ( std::size_t k = 0; k < m; ++k){
+               a[c][k] /= r[c][c];
+            }
+         }
+         // pseudo inverse R^-1 Q^T by back substitution
+         for ( int row = 0; row < 3; ++row){
+            m_pinv[row].resize(m);
+         }
+         for ( std::size_t k = 0; k < m; ++k){
+            double x[3];
+            for ( int row = 2; row >= 0; --row){
+               double sum = a[row][k];
+               for ( int c = row + 1; c < 3; ++c){
+                  sum -= r[row][c] * x[c];
+               }
+               x[row] = sum / r[row][row];
+            }
+            for ( int row = 0; row < 3; ++row){
+               m_pinv[row][k] = per_km{x[row]};
+            }
+         }
+         m_valid = true;
+      }
+
+      bool is_valid() const { return m_valid;}
+      std::size_t num_centres() const { return m_num_centres;}
+
+      // radii holds the radius of each sphere in the order of the centres
+      // degenerate_C, with out not written, if the constellation is not valid
+      trilaterate_status solve(quan::length::km const * radii, point & out) const
+      {
+         if ( !is_valid()){
+            return trilaterate_status::degenerate_C;
+         }
+         out = position(radii);
+         return trilaterate_status::solved;
+      }
+
+      // radii for tag n start at radii + n * num_centres()
+      // returns the number solved, num_tags or 0 with out not written if the constellation is not valid
+      std::size_t solve_batch(quan::length::km const * radii, std::size_t num_tags, point_soa const & out) const
+      {
+         if ( !is_valid()){
+            return 0;
+         }
+         for ( std::size_t n = 0; n < num_tags; ++n){
+            point const p = position(radii + n * m_num_centres);
+            out.x[n] = p.x;
+            out.y[n] = p.y;
+            out.z[n] = p.z;
+         }
+         return num_tags;
+      }
+
+   private:
+
+      point position(quan::length::km const * radii) const
+      {
+         auto const r0_2 = quan::pow<2>(radii[0]);
+         point p{0_km,0_km,0_km};
+         for ( std::size_t k = 0; k < m_num_centres - 1; ++k){
+            auto const b = r0_2 - quan::pow<2>(radii[k+1]) + m_b_offset[k];
+            p.x += m_pinv[0][k] * b;
+            p.y += m_pinv[1][k] * b;
+            p.z += m_pinv[2][k] * b;
+         }
+         return p;
+      }
+
+      std::size_t m_num_centres;
+      bool m_valid;
+      // |centre_k|^2 - |centre_0|^2 
+      std::vector<km2> m_b_offset;
+      // rows of the pseudo inverse
+      std::vector<per_km> m_pinv[3];
+   };
+
+} // namespace
+
+#endif // TRILATERATION_MULTILATERATE_LINEAR_HPP_INCLUDED
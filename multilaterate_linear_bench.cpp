@@ -0,0 +1,97 @@
+/*
+  anchor_constellation against calling trilaterate per tag
+  tags at random positions, ranges to a fixed constellation of random anchors
+
+  usage : multilaterate_linear_bench.exe [num_tags] [noise_km]
+*/
+
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "multilaterate_linear.hpp"
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_tags = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+   double const noise = (argc > 2) ? std::strtod(argv[2],nullptr) : 0.0;
+
+   std::mt19937_64 gen{2};
+   std::uniform_real_distribution<double> pos{0.0,20.0};
+   std::uniform_real_distribution<double> err{-noise,noise};
+
+   bool success = true;
+   for ( std::size_t num_anchors : {4,8}){
+      std::vector<point> anchors(num_anchors);
+      for ( auto & a : anchors){
+         a = point{quan::length::km{pos(gen)},quan::length::km{pos(gen)},quan::length::km{pos(gen)}};
+      }
+      auto const tags = make_random_triples(num_tags).tag;
+      std::vector<quan::length::km> radii(num_tags * num_anchors);
+      for ( std::size_t n = 0; n < num_tags; ++n){
+         for ( std::size_t k = 0; k < num_anchors; ++k){
+            radii[n * num_anchors + k] = magnitude(tags[n] - anchors[k]) + quan::length::km{err(gen)};
+         }
+      }
+
+      // per tag trilaterate on the first 3 anchors
+      std::size_t scalar_solved = 0;
+      double const scalar_ns = ns_per_item(num_tags,[&]{
+         for ( std::size_t n = 0; n < num_tags; ++n){
+            quan::length::km const * r = &radii[n * num_anchors];
+            point ip;
+            scalar_solved += (trilaterate(sphere{anchors[0],r[0]},sphere{anchors[1],r[1]},sphere{anchors[2],r[2]},ip) == trilaterate_status::solved);
+         }
+      });
+
+      anchor_constellation const constellation{anchors.data(),num_anchors};
+      if (!constellation.is_valid()){
+         std::cout << "coplanar anchors\n";
+         return EXIT_FAILURE;
+      }
+      // the coplanar test is relative, so the same anchors shrunk to a fraction of a mm are still valid
+      // and the anchors flattened onto z = 0 are not
+      std::vector<point> shrunk(num_anchors);
+      std::vector<point> flat(num_anchors);
+      for ( std::size_t k = 0; k < num_anchors; ++k){
+         shrunk[k] = anchors[k] * 1.e-8;
+         flat[k] = point{anchors[k].x,anchors[k].y,0_km};
+      }
+      if ( !anchor_constellation{shrunk.data(),num_anchors}.is_valid() 
+            || anchor_constellation{flat.data(),num_anchors}.is_valid()){
+         std::cout << "coplanar test depends on scale\n";
+         success = false;
+      }
+
+      point_arrays result{num_tags};
+      double const single_ns = ns_per_item(num_tags,[&]{
+         for ( std::size_t n = 0; n < num_tags; ++n){
+            point p;
+            constellation.solve(&radii[n * num_anchors],p);
+            result.x[n] = p.x;
+            result.y[n] = p.y;
+            result.z[n] = p.z;
+         }
+      });
+      double const batch_ns = ns_per_item(num_tags,[&]{
+         constellation.solve_batch(radii.data(),num_tags,result.soa());
+      });
+
+      auto max_error = 0_km;
+      for ( std::size_t n = 0; n < num_tags; ++n){
+         auto const error = magnitude(result.get(n) - tags[n]);
+         if ( error > max_error){
+            max_error = error;
+         }
+      }
+      std::cout << num_anchors << " anchors : trilaterate ns/solve = " << scalar_ns 
+         << " ( solved " << scalar_solved << ")"
+         << ", constellation ns/solve = " << single_ns
+         << ", constellation batch ns/solve = " << batch_ns 
+         << ", max error = " << max_error << '\n';
+      if ( (noise == 0.0) && (max_error > epsilon_km)){
+         success = false;
+      }
+   }
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
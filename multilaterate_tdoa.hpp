@@ -0,0 +1,389 @@
+#ifndef TRILATERATION_MULTILATERATE_TDOA_HPP_INCLUDED
+#define TRILATERATION_MULTILATERATE_TDOA_HPP_INCLUDED
+
+/*
+  position from time differences of arrival at N >= 4 receive only anchors
+
+  the anchors only give the time a transmission arrived, so the range to each anchor is known
+  less the unknown range r0 to anchor 0. as lengths ( time difference * propagation speed)
+     range_differences[k - 1] = |p - anchor k| - |p - anchor 0|     k = 1 .. N - 1
+  each is one sheet of a hyperboloid with foci anchor 0 and anchor k, rather than a sphere
+
+  closed form estimate, as Fang for 4 anchors and Chan for more
+  in the frame of anchors 0 1 2 ( anchor_frame, trilaterate_frame.hpp) anchor 0 is at origin so |p| = r0,
+  and |p - s_k|^2 = (r0 + d_k)^2 is linear in p given r0
+     s_k . p = (|s_k|^2 - d_k^2) / 2 - d_k * r0
+  the least squares solution is p = u - r0 * v, where the pseudo inverse of the s_k is found once per constellation,
+  and |p|^2 = r0^2 is a quadratic in r0. a root gives |p - s_k| = |r0 + d_k|, so it is on the sheets
+  measured only if r0 >= 0 and every r0 + d_k >= 0, the other sheet costing 2 |r0 + d_k| of residual.
+  each root on the sheets, to within the fit tolerance, is refined by Levenberg-Marquardt
+  on the residuals |p - s_k| - |p| - d_k, as multilaterate_refine.
+
+  with 4 anchors the 3 linear equations are square, so a root on the sheets fits exactly, noise or not.
+  when both roots are on the sheets the measurements have two exact solutions and no solver can separate them.
+  that is most tags, over 95% for anchors and tags at random in a 20 km cube, see multilaterate_tdoa_bench,
+  so 4 anchors do not give a unique fix. with more anchors the root off the true position rarely fits.
+  if both refined roots fit to within the fit tolerance, and are further apart than it, the status is ambiguous,
+  with the best fit as the position and the other as the alternative.
+  the fit tolerance is options.max_residual, at least epsilon_km * sqrt(N - 1) so exact data needs none.
+  with range noise up to e a true position has a residual norm up to 2 * e * sqrt(N - 1)
+
+  tdoa_constellation holds up to tdoa_max_anchors fixed anchors, in fixed arrays,
+  so nothing is allocated, by construction or any solve. solve_batch solves in the frame and moves
+  each run of entries with a position back to the world in one anchor_frame::to_world
+
+  anchors 0 1 2 must not be on one line, and the anchors must not all be on one plane
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "multilaterate.hpp"
+#include "trilaterate_arena.hpp"
+#include "trilaterate_frame.hpp"
+
+namespace {
+
+   std::size_t constexpr tdoa_max_anchors = 16;
+
+   class tdoa_constellation{
+   public:
+
+      tdoa_constellation(point const * anchors, std::size_t num_anchors)
+      : m_frame{make_frame(anchors,num_anchors)}, m_num_anchors{num_anchors}, m_valid{false}
+      {
+         if ( (num_anchors < 4) || (num_anchors > tdoa_max_anchors)){
+            return;
+         }
+         // as ll_trilaterate, anchor 1 on the x axis at d and anchor 2 at i,j in the xy plane
+         point const pB = m_frame.to_frame(anchors[1]);
+         point const pC = m_frame.to_frame(anchors[2]);
+         if ( !(pB.x >= epsilon_km) || !(abs(pC.y) >= epsilon_km)){
+            return;
+         }
+         std::size_t const m = num_anchors - 1;
+         double ata[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
+         for ( std::size_t k = 0; k < m; ++k){
+            point const s = m_frame.to_frame(anchors[k + 1]);
+            m_anchor[k][0] = s.x.numeric_value();
+            m_anchor[k][1] = s.y.numeric_value();
+            m_anchor[k][2] = s.z.numeric_value();
+            m_anchor_2[k] = dot_product(s,s).numeric_value();
+            for ( int r = 0; r < 3; ++r){
+               for ( int c = 0; c < 3; ++c){
+                  ata[r][c] += m_anchor[k][r] * m_anchor[k][c];
+               }
+            }
+         }
+         // pseudo inverse (A^T A)^-1 A^T, a column per anchor
+         for ( std::size_t k = 0; k < m; ++k){
+            point column;
+            if ( !solve_3x3(ata,point{quan::length::km{m_anchor[k][0]},quan::length::km{m_anchor[k][1]},quan::length::km{m_anchor[k][2]}},column)){
+               // all on one plane
+               return;
+            }
+            m_pinv[0][k] = column.x.numeric_value();
+            m_pinv[1][k] = column.y.numeric_value();
+            m_pinv[2][k] = column.z.numeric_value();
+         }
+         m_valid = true;
+      }
+
+      bool is_valid() const { return m_valid;}
+      std::size_t num_anchors() const { return m_num_anchors;}
+      anchor_frame<quan::length::km> const & frame() const { return m_frame;}
+
+      // the closed form estimates on the sheets measured, to within tolerance, in the frame, the best fit first
+      // returns the number of estimates
+      int estimate(quan::length::km const * range_differences, quan::length::km const & tolerance, point (&p)[2]) const
+      {
+         std::size_t const m = m_num_anchors - 1;
+         double u[3] = {0,0,0};
+         double v[3] = {0,0,0};
+         for ( std::size_t k = 0; k < m; ++k){
+            double const d = range_differences[k].numeric_value();
+            double const b = (m_anchor_2[k] - d * d) / 2;
+            for ( int r = 0; r < 3; ++r){
+               u[r] += m_pinv[r][k] * b;
+               v[r] += m_pinv[r][k] * d;
+            }
+         }
+         // |u - r0 v|^2 = r0^2
+         double const a = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] - 1;
+         double const h = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+         double const c = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+         double roots[2];
+         int num_roots = 0;
+         if ( std::abs(a) < 1.e-12){
+            if ( std::abs(h) > 1.e-12){
+               roots[num_roots++] = c / (2 * h);
+            }
+         }else{
+            double const disc = h * h - a * c;
+            if ( disc > 0){
+               double const root_disc = std::sqrt(disc);
+               roots[num_roots++] = (h + root_disc) / a;
+               roots[num_roots++] = (h - root_disc) / a;
+            }else{
+               // noise may leave the roots a little complex, both nearest to the one real r0
+               roots[num_roots++] = h / a;
+            }
+         }
+         double const tol = tolerance.numeric_value();
+         double residual[2] = {HUGE_VAL,HUGE_VAL};
+         int num_estimates = 0;
+         for ( int i = 0; i < num_roots; ++i){
+            double const r0 = roots[i];
+            if ( !on_sheets(range_differences,r0,tol)){
+               continue;
+            }
+            point const candidate{quan::length::km{u[0] - r0 * v[0]},quan::length::km{u[1] - r0 * v[1]},quan::length::km{u[2] - r0 * v[2]}};
+            double const candidate_residual = residual_2(range_differences,candidate);
+            int const k = ( candidate_residual < residual[0]) ? 0 : 1;
+            if ( k == 0){
+               p[1] = p[0];
+               residual[1] = residual[0];
+            }
+            p[k] = candidate;
+            residual[k] = candidate_residual;
+            ++num_estimates;
+         }
+         return num_estimates;
+      }
+
+      // the residual norm within which a position fits, options.max_residual but at least epsilon_km * sqrt(N - 1)
+      quan::length::km fit_tolerance(multilaterate_options const & options) const
+      {
+         auto const min_tolerance = epsilon_km * std::sqrt(static_cast<double>(m_num_anchors - 1));
+         return (options.max_residual > min_tolerance) ? options.max_residual : min_tolerance;
+      }
+
+      /*
+        the estimates refined, in the frame
+        solved, or ambiguous if two estimates both fit to within fit_tolerance and are further apart than it,
+        with result the best fit and alternative, if not nullptr, the other
+        negative_z_squared if there is no estimate, degenerate_C if the constellation is not valid
+        no_fit if options.max_residual is set and the best fit has a larger residual norm
+      */
+      trilaterate_status fix(quan::length::km const * range_differences, multilaterate_options const & options,
+         multilaterate_result & result, point * alternative = nullptr) const
+      {
+         if ( !m_valid){
+            return trilaterate_status::degenerate_C;
+         }
+         auto const tolerance = fit_tolerance(options);
+         point p[2];
+         int const num_estimates = estimate(range_differences,tolerance,p);
+         if ( num_estimates == 0){
+            return trilaterate_status::negative_z_squared;
+         }
+         result.position = p[0];
+         refine(range_differences,options,result);
+         multilaterate_result other;
+         if ( num_estimates == 2){
+            other.position = p[1];
+            refine(range_differences,options,other);
+            if ( other.residual_norm < result.residual_norm){
+               std::swap(result,other);
+            }
+         }
+         if ( (options.max_residual > 0_km) && (result.residual_norm > options.max_residual)){
+            return trilaterate_status::no_fit;
+         }
+         if ( (num_estimates == 1) || (other.residual_norm > tolerance)
+               || !(magnitude(other.position - result.position) > tolerance)){
+            return trilaterate_status::solved;
+         }
+         if ( alternative != nullptr){
+            *alternative = other.position;
+         }
+         return trilaterate_status::ambiguous;
+      }
+
+      // refine result.position, in the frame, by Levenberg-Marquardt
+      void refine(quan::length::km const * range_differences, multilaterate_options const & options, multilaterate_result & result) const
+      {
+         std::size_t const m = m_num_anchors - 1;
+         double lambda = options.lambda;
+         double residual = residual_2(range_differences,result.position);
+         result.iterations = 0;
+         result.converged = false;
+         while ( result.iterations < options.max_iterations){
+            ++result.iterations;
+            double const p[3] = {result.position.x.numeric_value(),result.position.y.numeric_value(),result.position.z.numeric_value()};
+            double const r0 = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            if ( r0 < epsilon_km.numeric_value()){
+               break;
+            }
+            double jtj[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
+            double jtr[3] = {0,0,0};
+            for ( std::size_t k = 0; k < m; ++k){
+               double const w[3] = {p[0] - m_anchor[k][0],p[1] - m_anchor[k][1],p[2] - m_anchor[k][2]};
+               double const dist = std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+               if ( dist < epsilon_km.numeric_value()){
+                  continue;
+               }
+               // gradient of |p - s_k| - |p|
+               double const row[3] = {w[0] / dist - p[0] / r0,w[1] / dist - p[1] / r0,w[2] / dist - p[2] / r0};
+               double const res = dist - r0 - range_differences[k].numeric_value();
+               for ( int r = 0; r < 3; ++r){
+                  for ( int c = 0; c < 3; ++c){
+                     jtj[r][c] += row[r] * row[c];
+                  }
+                  jtr[r] -= row[r] * res;
+               }
+            }
+            for ( int r = 0; r < 3; ++r){
+               jtj[r][r] *= (1.0 + lambda);
+            }
+            point step;
+            if ( !solve_3x3(jtj,point{quan::length::km{jtr[0]},quan::length::km{jtr[1]},quan::length::km{jtr[2]}},step)){
+               break;
+            }
+            point const candidate = result.position + step;
+            double const candidate_residual = residual_2(range_differences,candidate);
+            if ( candidate_residual <= residual){
+               result.position = candidate;
+               residual = candidate_residual;
+               lambda /= 10;
+               if ( magnitude(step) < options.tolerance){
+                  result.converged = true;
+                  break;
+               }
+            }else{
+               if ( lambda == 0){
+                  break;
+               }
+               lambda *= 10;
+            }
+         }
+         result.residual_norm = quan::length::km{std::sqrt(residual)};
+      }
+
+      // range_differences holds num_anchors() - 1 differences to anchor 0
+      // the status of fix, result.position and alternative are in the world
+      trilaterate_status solve(quan::length::km const * range_differences, multilaterate_result & result,
+         multilaterate_options const & options = multilaterate_options{}, point * alternative = nullptr) const
+      {
+         auto const status = fix(range_differences,options,result,alternative);
+         if ( has_position(status)){
+            result.position = m_frame.to_world(result.position);
+         }
+         if ( (status == trilaterate_status::ambiguous) && (alternative != nullptr)){
+            *alternative = m_frame.to_world(*alternative);
+         }
+         return status;
+      }
+
+      // range differences for tag n start at range_differences + n * (num_anchors() - 1)
+      // status[n] is set to the status of fix
+      // out is only written for solved and ambiguous tags, with the best fit
+      // returns the number solved
+      std::size_t solve_batch(quan::length::km const * range_differences, std::size_t num_tags,
+         point_soa const & out, trilaterate_status * status, multilaterate_options const & options = multilaterate_options{}) const
+      {
+         std::size_t const m = m_num_anchors - 1;
+         std::size_t num_solved = 0;
+         for ( std::size_t n = 0; n < num_tags; ++n){
+            multilaterate_result result;
+            status[n] = fix(range_differences + n * m,options,result);
+            if ( has_position(status[n])){
+               out.x[n] = result.position.x;
+               out.y[n] = result.position.y;
+               out.z[n] = result.position.z;
+            }
+            num_solved += (status[n] == trilaterate_status::solved);
+         }
+         // each run of written elements
+         std::size_t begin = 0;
+         for ( std::size_t n = 0; n <= num_tags; ++n){
+            if ( (n == num_tags) || !has_position(status[n])){
+               if ( n > begin){
+                  m_frame.to_world(slice(out,begin),n - begin,slice(out,begin));
+               }
+               begin = n + 1;
+            }
+         }
+         return num_solved;
+      }
+
+   private:
+
+      static anchor_frame<quan::length::km> make_frame(point const * anchors, std::size_t num_anchors)
+      {
+         if ( num_anchors < 3){
+            return anchor_frame<quan::length::km>{point{},unit_quaternion<double>::identity()};
+         }
+         return anchor_frame<quan::length::km>{anchors[0],anchors[1],anchors[2]};
+      }
+
+      static bool has_position(trilaterate_status status)
+      {
+         return (status == trilaterate_status::solved) || (status == trilaterate_status::ambiguous);
+      }
+
+      // r0 and every r0 + d_k, the ranges at the root, no more than tolerance below 0
+      bool on_sheets(quan::length::km const * range_differences, double r0, double tolerance) const
+      {
+         if ( !(r0 >= -tolerance)){
+            return false;
+         }
+         for ( std::size_t k = 0; k < m_num_anchors - 1; ++k){
+            if ( !(r0 + range_differences[k].numeric_value() >= -tolerance)){
+               return false;
+            }
+         }
+         return true;
+      }
+
+      // sum of squared range difference residuals at p in the frame
+      double residual_2(quan::length::km const * range_differences, point const & p) const
+      {
+         double const px = p.x.numeric_value(), py = p.y.numeric_value(), pz = p.z.numeric_value();
+         double const r0 = std::sqrt(px * px + py * py + pz * pz);
+         double sum = 0;
+         for ( std::size_t k = 0; k < m_num_anchors - 1; ++k){
+            double const wx = px - m_anchor[k][0], wy = py - m_anchor[k][1], wz = pz - m_anchor[k][2];
+            double const res = std::sqrt(wx * wx + wy * wy + wz * wz) - r0 - range_differences[k].numeric_value();
+            sum += res * res;
+         }
+         return sum;
+      }
+
+      anchor_frame<quan::length::km> m_frame;
+      std::size_t m_num_anchors;
+      bool m_valid;
+      // anchors 1 .. N - 1 in the frame and the squares of their distance from anchor 0, numeric km
+      double m_anchor[tdoa_max_anchors - 1][3];
+      double m_anchor_2[tdoa_max_anchors - 1];
+      // rows of the pseudo inverse
+      double m_pinv[3][tdoa_max_anchors - 1];
+   };
+
+   // tdoa position from anchors that change with every solve
+   // degenerate_C if the anchors are not valid for a tdoa_constellation, else as tdoa_constellation::solve
+   inline trilaterate_status multilaterate_tdoa(point const * anchors, std::size_t num_anchors, quan::length::km const * range_differences,
+      multilaterate_result & result, multilaterate_options const & options = multilaterate_options{}, point * alternative = nullptr)
+   {
+      tdoa_constellation const constellation{anchors,num_anchors};
+      return constellation.solve(range_differences,result,options,alternative);
+   }
+
+   // tdoa_constellation::solve_batch with the results in arena
+   // returns false, solving nothing, if there is not room
+   inline bool multilaterate_tdoa_batch(tdoa_constellation const & constellation, quan::length::km const * range_differences,
+      std::size_t num_tags, solve_arena & arena, trilaterate_batch_result & result,
+      multilaterate_options const & options = multilaterate_options{})
+   {
+      if ( !allocate_batch_result(arena,num_tags,result)){
+         return false;
+      }
+      result.num_solved = constellation.solve_batch(range_differences,num_tags,result.positions,result.status,options);
+      return true;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_MULTILATERATE_TDOA_HPP_INCLUDED
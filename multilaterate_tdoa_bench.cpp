@@ -0,0 +1,176 @@
+/*
+  tdoa_constellation against the sphere solvers on the same anchors and tags
+
+  for each number of anchors, one random constellation in a cube of side 20 km and random tags in the cube.
+  each anchor measures its range to the tag with +- noise, as if from the arrival time.
+  the sphere solvers are given the ranges, the tdoa solver only the differences of the ranges to anchor 0
+     trilaterate_batch_simd      the first 3 anchors
+     multilaterate_batch         all the anchors, Levenberg-Marquardt
+     anchor_constellation        all the anchors, linear least squares
+     tdoa closed form            tdoa_constellation::solve_batch with no refinement
+     tdoa                        tdoa_constellation::solve_batch
+
+  reports ns per solve, the number solved and the distance of the solved positions from the tag
+  as p50, p99 and max in m. the tdoa fit tolerance, max_residual, is 2 * noise * sqrt(N - 1),
+  as each range difference carries the noise of two ranges.
+
+  with 4 anchors the differences are fitted exactly by both closed form roots on the sheets measured,
+  so a tag with two such roots has two solutions and is ambiguous, over 95% of tags here.
+  for those, the tag is reported as nearest the best fit or the alternative, both often,
+  since no residual can tell them apart. ambiguous tags are not in the errors.
+
+  usage : multilaterate_tdoa_bench.exe [num_tags] [noise_km]
+     defaults 100000 tags, noise 0.001 km
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "multilaterate_linear.hpp"
+#include "multilaterate_tdoa.hpp"
+#include "trilaterate_bench.hpp"
+
+namespace {
+
+   struct result_stats{
+      std::size_t num_solved;
+      std::size_t num_ambiguous;
+      std::vector<double> errors;
+   };
+
+   void report(char const * name, double ns, result_stats & s, std::size_t num_tags)
+   {
+      std::sort(s.errors.begin(),s.errors.end());
+      std::cout << "   " << name << " : ns/solve = " << ns << ", solved = " << s.num_solved << '/' << num_tags;
+      if ( s.num_ambiguous > 0){
+         std::cout << ", ambiguous = " << s.num_ambiguous;
+      }
+      if ( !s.errors.empty()){
+         auto quantile = [&s](double q){ return s.errors[static_cast<std::size_t>(q * (s.errors.size() - 1))];};
+         std::cout << ", error (m) p50 = " << quantile(0.5) << ", p99 = " << quantile(0.99) << ", max = " << s.errors.back();
+      }
+      std::cout << '\n';
+   }
+
+   result_stats stats(point_arrays const & result, std::vector<point> const & tags)
+   {
+      result_stats s{0,0,{}};
+      for ( std::size_t n = 0; n < tags.size(); ++n){
+         if ( result.status[n] == trilaterate_status::solved){
+            ++s.num_solved;
+            s.errors.push_back(magnitude(result.get(n) - tags[n]).numeric_value() * 1000.0);
+         }else if ( result.status[n] == trilaterate_status::ambiguous){
+            ++s.num_ambiguous;
+         }
+      }
+      return s;
+   }
+
+   bool run(std::size_t num_anchors, std::size_t num_tags, quan::length::km const & noise)
+   {
+      std::mt19937_64 gen{num_anchors};
+      std::uniform_real_distribution<double> pos{0.0,20.0};
+      std::uniform_real_distribution<double> err{-noise.numeric_value(),noise.numeric_value()};
+      auto random_point = [&]{ return point{quan::length::km{pos(gen)},quan::length::km{pos(gen)},quan::length::km{pos(gen)}};};
+
+      std::vector<point> anchors(num_anchors);
+      for ( auto & a : anchors){
+         a = random_point();
+      }
+      tdoa_constellation const tdoa{anchors.data(),num_anchors};
+      anchor_constellation const linear{anchors.data(),num_anchors};
+      if ( !tdoa.is_valid() || !linear.is_valid()){
+         std::cout << num_anchors << " anchors : invalid constellation\n";
+         return false;
+      }
+
+      std::vector<point> tags(num_tags);
+      std::vector<quan::length::km> ranges(num_tags * num_anchors);
+      std::vector<quan::length::km> range_differences(num_tags * (num_anchors - 1));
+      std::vector<sphere> spheres(num_tags * num_anchors);
+      sphere_triple_arrays triples{num_tags};
+      for ( std::size_t n = 0; n < num_tags; ++n){
+         tags[n] = random_point();
+         for ( std::size_t a = 0; a < num_anchors; ++a){
+            auto const range = magnitude(tags[n] - anchors[a]) + quan::length::km{err(gen)};
+            ranges[n * num_anchors + a] = range;
+            spheres[n * num_anchors + a] = sphere{anchors[a],range};
+            if ( a > 0){
+               range_differences[n * (num_anchors - 1) + a - 1] = range - ranges[n * num_anchors];
+            }
+            if ( a < 3){
+               triples.set(a,n,spheres[n * num_anchors + a]);
+            }
+         }
+      }
+
+      std::cout << num_anchors << " anchors\n";
+      point_arrays result{num_tags};
+      double const simd_ns = ns_per_item(num_tags,[&]{ trilaterate_batch_simd(triples.soa(),result.soa(),result.status.data());});
+      auto s = stats(result,tags);
+      report("trilaterate_batch_simd, 3 anchors",simd_ns,s,num_tags);
+
+      std::vector<multilaterate_result> results(num_tags);
+      double const lm_ns = ns_per_item(num_tags,[&]{
+         multilaterate_batch(spheres.data(),num_anchors,num_tags,results.data(),result.status.data());
+      });
+      for ( std::size_t n = 0; n < num_tags; ++n){
+         result.x[n] = results[n].position.x;
+         result.y[n] = results[n].position.y;
+         result.z[n] = results[n].position.z;
+      }
+      s = stats(result,tags);
+      report("multilaterate_batch",lm_ns,s,num_tags);
+
+      double const linear_ns = ns_per_item(num_tags,[&]{ linear.solve_batch(ranges.data(),num_tags,result.soa());});
+      std::fill(result.status.begin(),result.status.end(),trilaterate_status::solved);
+      s = stats(result,tags);
+      report("anchor_constellation",linear_ns,s,num_tags);
+
+      multilaterate_options options;
+      options.max_residual = 2.0 * noise * std::sqrt(static_cast<double>(num_anchors - 1));
+      multilaterate_options closed_form = options;
+      closed_form.max_iterations = 0;
+      double const closed_ns = ns_per_item(num_tags,[&]{
+         tdoa.solve_batch(range_differences.data(),num_tags,result.soa(),result.status.data(),closed_form);
+      });
+      s = stats(result,tags);
+      report("tdoa closed form",closed_ns,s,num_tags);
+
+      double const tdoa_ns = ns_per_item(num_tags,[&]{
+         tdoa.solve_batch(range_differences.data(),num_tags,result.soa(),result.status.data(),options);
+      });
+      s = stats(result,tags);
+      report("tdoa",tdoa_ns,s,num_tags);
+
+      if ( s.num_ambiguous > 0){
+         std::size_t num_nearest_alternative = 0;
+         for ( std::size_t n = 0; n < num_tags; ++n){
+            if ( result.status[n] == trilaterate_status::ambiguous){
+               multilaterate_result fix;
+               point alternative;
+               tdoa.solve(range_differences.data() + n * (num_anchors - 1),fix,options,&alternative);
+               num_nearest_alternative += (magnitude(alternative - tags[n]) < magnitude(fix.position - tags[n]));
+            }
+         }
+         std::cout << "   tdoa ambiguous : tag nearest the best fit = " << (s.num_ambiguous - num_nearest_alternative)
+            << ", nearest the alternative = " << num_nearest_alternative << '\n';
+      }
+      return (s.num_solved + s.num_ambiguous) == num_tags;
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_tags = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 100000;
+   quan::length::km const noise{ (argc > 2) ? std::strtod(argv[2],nullptr) : 0.001};
+   std::cout << "range noise = +-" << noise << '\n';
+
+   bool success = true;
+   for ( std::size_t num_anchors : {4,6,8}){
+      success = run(num_anchors,num_tags,noise) && success;
+   }
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
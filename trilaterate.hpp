@@ -0,0 +1,659 @@
+#ifndef TRILATERATION_TRILATERATE_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_HPP_INCLUDED
+
+/*
+  Trilateration example from Wikipedia https://en.wikipedia.org/wiki/Trilateration
+
+  sphere triple solver shared by the example programs
+
+  the calc that aligns the spheres is a policy, trilaterate<matrix_calc>(A,B,C,p) etc
+  matrix_calc   use quan::fusion matrices to align the spheres
+  affine_calc   as matrix_calc with the rotations and translation as 3x4 affine_transforms
+  vect_calc     use quan::three_d rotations to align the spheres
+  basis_calc    use an orthonormal basis from the sphere centres to align the spheres ( no trig)
+  quaternion_calc  use a unit quaternion from that basis to align the spheres ( no trig)
+  see trilaterate_dispatch.hpp to choose the calc at runtime
+  pass a tracer to see the intermediate values of the calc, trilaterate(A,B,C,p,tracer)
+  basis_calc and quaternion_calc are templated on the length type, so trilaterate<basis_calc>(A,B,C,p) also solves point_<float> etc
+
+  define the options below before including this header
+
+  USE_MATRIX_CALC   trilaterate(A,B,C,p) uses matrix_calc ( the default)
+  USE_AFFINE_CALC   trilaterate(A,B,C,p) uses affine_calc
+  USE_VECT_CALC     trilaterate(A,B,C,p) uses vect_calc
+  USE_BASIS_CALC    trilaterate(A,B,C,p) uses basis_calc
+  USE_QUATERNION_CALC  trilaterate(A,B,C,p) uses quaternion_calc
+  TRILATERATE_METRICS  time each stage of trilaterate and count the status of each solve
+                       see trilaterate_metrics.hpp
+
+  requires my quan library ( headers only required)
+  https://github.com/kwikius/quan-trunk
+*/
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+#include <quan/out/angle.hpp>
+#include <quan/atan2.hpp>
+#include <quan/out/length.hpp>
+#include <quan/three_d/out/vect.hpp>
+#include <quan/three_d/rotation.hpp>
+#include <quan/three_d/sphere.hpp>
+
+#include <quan/fusion/make_matrix.hpp>
+#include <quan/fusion/matrix.hpp>
+#include <quan/fusion/make_translation_matrix.hpp>
+#include <quan/fusion/make_3d_x_rotation_matrix.hpp>
+#include <quan/fusion/make_3d_y_rotation_matrix.hpp>
+#include <quan/fusion/make_3d_z_rotation_matrix.hpp>
+#include <quan/fusion/make_row_matrix.hpp>
+#include <quan/fusion/static_value/out/static_value.hpp>
+#include <quan/fun/as_vect3d.hpp>
+
+#include "trilaterate_status.hpp"
+#include "trilaterate_metrics.hpp"
+#include "trilaterate_affine.hpp"
+#include "trilaterate_quaternion.hpp"
+
+#if ! (defined (USE_VECT_CALC) || defined(USE_MATRIX_CALC) || defined(USE_AFFINE_CALC) || defined(USE_BASIS_CALC) \
+      || defined(USE_QUATERNION_CALC))
+#define USE_MATRIX_CALC
+#endif
+
+#if (defined (USE_VECT_CALC) + defined(USE_MATRIX_CALC) + defined(USE_AFFINE_CALC) + defined(USE_BASIS_CALC) \
+      + defined(USE_QUATERNION_CALC)) > 1
+#error choose calc
+#endif
+
+namespace {
+
+   QUAN_QUANTITY_LITERAL(length,km)
+   typedef quan::three_d::vect<quan::length::km > point;
+
+   typedef quan::three_d::sphere<quan::length::km> sphere;
+
+   /*
+     km with value type T
+     the solver is templated on the length type, so point_<float> and sphere_<float>
+     solve in single precision with basis_calc
+     matrix_calc and vect_calc are double only
+   */
+   template <typename T> using km_ = typename quan::length_<T>::km;
+   template <typename T> using point_ = quan::three_d::vect<km_<T> >;
+   template <typename T> using sphere_ = quan::three_d::sphere<km_<T> >;
+
+   template <typename Length>
+   inline std::ostream & operator<< ( std::ostream & out, quan::three_d::sphere<Length> const & c)
+   {
+      return out << "sphere(centre = " << c.centre << ", radius = " << c.radius << ")";
+   }
+
+   auto constexpr epsilon_km = 1.e-6_km;
+
+   // epsilon_km as Length
+   template <typename Length>
+   inline Length epsilon()
+   {
+      return Length{static_cast<typename Length::value_type>(epsilon_km.numeric_value())};
+   }
+
+   // the normalised frame calc
+   // on the distances of the normalised frame
+   // d : distance of B along x axis
+   // i, j : x and y of C
+   template <typename Length>
+   inline trilaterate_status ll_trilaterate_calc(
+      Length const & d, Length const & i, Length const & j,
+      Length const & rA, Length const & rB, Length const & rC,
+      quan::three_d::vect<Length> & intersection_point)
+   {
+      // also catches j == nan from a unit vector of zero length
+      if ( !(j >= epsilon<Length>())){
+         return trilaterate_status::degenerate_C;
+      }
+      auto const x = (quan::pow<2>(rA) - quan::pow<2>(rB) + quan::pow<2>(d)) / ( 2 * d);
+
+      auto const y =  (
+            ( quan::pow<2>(rA) - quan::pow<2>(rC) + quan::pow<2>(i) + quan::pow<2>(j))
+                  / ( 2 * j) 
+                     ) - ( i / j) * x;
+
+      auto const z_2 = quan::pow<2>(rA) - quan::pow<2>(x) - quan::pow<2>(y);
+      if ( z_2 >= quan::pow<2>(Length{0})){
+         intersection_point = quan::three_d::vect<Length>{x,y,sqrt(z_2)};
+         return trilaterate_status::solved;
+      }else{
+         return trilaterate_status::negative_z_squared;
+      }
+   }
+
+   // A B C must be normalised as for ll_trilaterate
+   template <typename Length>
+   inline trilaterate_status ll_trilaterate_calc( quan::three_d::sphere<Length> const& A, 
+      quan::three_d::sphere<Length> const & B, quan::three_d::sphere<Length> const & C, 
+      quan::three_d::vect<Length> & intersection_point)
+   {
+      auto const ex = unit_vector(B.centre);   // direction of B to origin
+      auto const i = dot_product(ex,(C.centre));   
+      auto const ey = unit_vector(C.centre - i * ex) ;
+      auto const d = magnitude(B.centre);       // distance B to origin
+      auto const j = dot_product(ey,C.centre);
+      return ll_trilaterate_calc(d,i,j,A.radius,B.radius,C.radius,intersection_point);
+   }
+
+   // A B C must be normalised
+   // where A is centred at origin
+   // B is centred on x axis
+   // C is centred on xy plane
+   template <typename Length>
+   inline trilaterate_status ll_trilaterate( quan::three_d::sphere<Length> const& A, 
+      quan::three_d::sphere<Length> const & B, quan::three_d::sphere<Length> const & C, 
+      quan::three_d::vect<Length> & intersection_point)
+   {
+      assert( (A.centre == quan::three_d::vect<Length>{Length{0}, Length{0},Length{0}}));
+      assert(abs(B.centre.y) < epsilon<Length>()); 
+      assert(abs(B.centre.z) < epsilon<Length>());
+      assert(abs(C.centre.z) < epsilon<Length>()); 
+
+      auto const d = magnitude(B.centre);       // distance B to origin
+      if ( ( (d - A.radius) >= B.radius ) || ( B.radius >= (d + A.radius) ) ){
+         // one of A B is inside the other
+         return trilaterate_status::no_intersection_AB;
+      }
+      return ll_trilaterate_calc(A,B,C,intersection_point);
+   }
+
+   template <typename Length>
+   inline trilaterate_status trilaterate_verify(quan::three_d::sphere<Length> const& A, 
+      quan::three_d::sphere<Length> const & B, quan::three_d::sphere<Length> const & C)
+   {
+      Length const eps = epsilon<Length>();
+      auto const distAB = magnitude(A.centre-B.centre);
+      if (  distAB < eps ){
+         return trilaterate_status::coincident_AB;
+      }
+      if ( distAB >= (A.radius + B.radius) ){
+         return trilaterate_status::no_intersection_AB;
+      }
+      auto const distBC = magnitude(B.centre-C.centre);
+      if (  distBC < eps ){
+         return trilaterate_status::coincident_BC;
+      }
+      if ( distBC >= (B.radius + C.radius) ){
+         return trilaterate_status::no_intersection_BC;
+      }
+      auto const distAC = magnitude(A.centre-C.centre);
+      if ( distAC  < eps ){
+         return trilaterate_status::coincident_AC;
+      }
+      if ( distAC >= (A.radius + C.radius) ){
+         return trilaterate_status::no_intersection_AC;
+      }
+      return trilaterate_status::solved;
+   }
+
+   /*
+     tracers see the intermediate values of a solve
+     trilaterate calls tracer.trace(name,value) with the points, angles and lengths of the calc
+     and tracer.status(status) with the result
+     null_tracer is the default and does nothing, so a solve without a tracer is unchanged
+     see trilaterate_trace.hpp for tracers that print and record
+   */
+   struct null_tracer{
+      template <typename T>
+      void trace(char const * , T const &) {}
+      void status(trilaterate_status) {}
+   };
+
+   /*
+     tracer that counts the solves with each status
+     keep one per thread and merge them, then print off the hot path
+   */
+   struct trilaterate_diagnostics : null_tracer{
+
+      void status(trilaterate_status status) { ++count[static_cast<int>(status)];}
+
+      void merge(trilaterate_diagnostics const & rhs)
+      {
+         for ( int s = 0; s < num_trilaterate_status; ++s){
+            count[s] += rhs.count[s];
+         }
+      }
+
+      std::uint64_t total() const
+      {
+         std::uint64_t sum = 0;
+         for ( auto c : count){
+            sum += c;
+         }
+         return sum;
+      }
+
+      // a line per status seen
+      void print(std::ostream & out) const
+      {
+         for ( int s = 0; s < num_trilaterate_status; ++s){
+            if ( count[s] != 0){
+               out << trilaterate_status_message(static_cast<trilaterate_status>(s)) << " : " << count[s] << '\n';
+            }
+         }
+      }
+
+      std::uint64_t count[num_trilaterate_status] = {};
+   };
+
+   /*
+     calc policies for trilaterate<Calc>
+     Calc::align_and_solve aligns A B C to the normalised frame, solves there with ll_trilaterate
+     and maps the intersection point back, out is only written if solved
+     A B C must have passed trilaterate_verify
+   */
+
+   /*
+     to align for matrix calc
+     B1, C1  <- translate B,C by -A.centre
+     mt 
+     read y_angle  ( atan2(B1.z,B1.x))
+     B2, C2 <- rotate B1,C1 around y by yangle
+     my
+     read z_angle (atan2(pB2.y, pB2.x)
+     C3 <-- rotate C2 around z by z_angle
+     mz
+     read x_angle ( atan2(C3.z, C3.y)
+      
+     // that gets angles to rotate by
+     // if want matrix then make matrix mt * my * mz * mx
+     // apply to point
+   */
+   struct matrix_calc{
+
+      static constexpr char const * name = "matrix";
+
+      template <typename Tracer>
+      static trilaterate_status align_and_solve(sphere const& A, sphere const & B, sphere const & C,point & out, Tracer & tracer)
+      {
+         trilaterate_stage_timer timer;
+         auto const pA0v = quan::fusion::make_row_matrix(A.centre);
+         auto const pB0v = quan::fusion::make_row_matrix(B.centre);
+         auto const pC0v = quan::fusion::make_row_matrix(C.centre);
+
+         // translate system so that A is at origin
+         auto mt = quan::fusion::make_translation_matrix(-A.centre);
+         auto const pAv_norm = pA0v * mt   ;
+         auto const pB1v = pB0v * mt   ;
+         auto const pC1v = pC0v * mt   ;
+         timer.lap(trilaterate_stage::translate);
+         tracer.trace("pAv_norm",as_vect3d(pAv_norm));
+         tracer.trace("pB1v",as_vect3d(pB1v));
+         tracer.trace("pC1v",as_vect3d(pC1v));
+
+         // rotate around y-axis so that pB.z == 0
+         assert( (pB1v.at<0,3>()== 1) );
+         auto const y_angle = quan::atan2(pB1v.at<0,2>(), pB1v.at<0,0>());
+         auto const mry = quan::fusion::make_3d_y_rotation_matrix<quan::length::km>(-y_angle);
+         auto const pB2v = pB1v * mry;
+         auto const pC2v = pC1v * mry;
+         timer.lap(trilaterate_stage::rotate_y);
+         tracer.trace("y_angle",y_angle);
+         tracer.trace("pB2v",as_vect3d(pB2v));
+         tracer.trace("pC2v",as_vect3d(pC2v));
+
+         // rotate around z-axis so that pB.y == 0
+         assert( (pB2v.at<0,3>()== 1) );
+         auto const z_angle = quan::atan2(pB2v.at<0,1>(),pB2v.at<0,0>());
+         auto mrz = quan::fusion::make_3d_z_rotation_matrix<quan::length::km>(-z_angle);
+         auto pBv_norm = pB2v * mrz;
+         auto pC3v = pC2v * mrz;
+         timer.lap(trilaterate_stage::rotate_z);
+         tracer.trace("z_angle",z_angle);
+         tracer.trace("pBv_norm",as_vect3d(pBv_norm));
+         tracer.trace("pC3v",as_vect3d(pC3v));
+
+         // rotate around x-axis so that pC.z == 0
+         assert( (pC3v.at<0,3>()== 1) );
+         auto const x_angle = quan::atan2(pC3v.at<0,2>(),pC3v.at<0,1>());
+         auto mrx = quan::fusion::make_3d_x_rotation_matrix<quan::length::km>(-x_angle);
+         auto const pCv_norm = pC3v * mrx;
+         timer.lap(trilaterate_stage::rotate_x);
+         tracer.trace("x_angle",x_angle);
+         tracer.trace("pCv_norm",as_vect3d(pCv_norm));
+
+         point ip_norm;
+         auto const status = ll_trilaterate(
+             sphere{as_vect3d(pAv_norm),A.radius}
+            ,sphere{as_vect3d(pBv_norm),B.radius}
+            ,sphere{as_vect3d(pCv_norm),C.radius}
+            ,ip_norm
+         );
+         timer.lap(trilaterate_stage::ll_trilaterate);
+         if ( status != trilaterate_status::solved){
+            return status;
+         }
+         tracer.trace("ip_norm",ip_norm);
+
+         auto mrx_dash = quan::fusion::make_3d_x_rotation_matrix<quan::length::km>(x_angle);
+         auto mrz_dash = quan::fusion::make_3d_z_rotation_matrix<quan::length::km>(z_angle);
+         auto mry_dash = quan::fusion::make_3d_y_rotation_matrix<quan::length::km>(y_angle);
+         auto mt_dash = quan::fusion::make_translation_matrix(A.centre);
+
+         auto mxtot_dash = mrx_dash * mrz_dash * mry_dash * mt_dash;
+
+         auto ipv_norm = quan::fusion::make_row_matrix(ip_norm);
+         auto ip0v = ipv_norm * mxtot_dash;
+         out = as_vect3d(ip0v);
+         timer.lap(trilaterate_stage::inverse_transform);
+         tracer.trace("ip0v",out);
+         return trilaterate_status::solved;
+      }
+   };
+
+   /*
+     as matrix calc but with each transform a 3x4 affine_transform
+     the transform back is composed once and inverted by transposing
+   */
+   struct affine_calc{
+
+      static constexpr char const * name = "affine";
+
+      template <typename Tracer>
+      static trilaterate_status align_and_solve(sphere const& A, sphere const & B, sphere const & C,point & out, Tracer & tracer)
+      {
+         typedef affine_transform<quan::length::km> transform;
+         trilaterate_stage_timer timer;
+
+         // translate system so that A is at origin
+         auto const mt = transform::translation(-A.centre);
+         point const pB1 = mt(B.centre);
+         point const pC1 = mt(C.centre);
+         timer.lap(trilaterate_stage::translate);
+         tracer.trace("pB1",pB1);
+         tracer.trace("pC1",pC1);
+
+         // rotate around y-axis so that pB.z == 0
+         auto const y_angle = quan::atan2(pB1.z,pB1.x);
+         auto const mry = transform::y_rotation(-y_angle);
+         point const pB2 = mry(pB1);
+         point const pC2 = mry(pC1);
+         timer.lap(trilaterate_stage::rotate_y);
+         tracer.trace("y_angle",y_angle);
+         tracer.trace("pB2",pB2);
+         tracer.trace("pC2",pC2);
+
+         // rotate around z-axis so that pB.y == 0
+         auto const z_angle = quan::atan2(pB2.y,pB2.x);
+         auto const mrz = transform::z_rotation(-z_angle);
+         point const pB_norm = mrz(pB2);
+         point const pC3 = mrz(pC2);
+         timer.lap(trilaterate_stage::rotate_z);
+         tracer.trace("z_angle",z_angle);
+         tracer.trace("pB_norm",pB_norm);
+         tracer.trace("pC3",pC3);
+
+         // rotate around x-axis so that pC.z == 0
+         auto const x_angle = quan::atan2(pC3.z,pC3.y);
+         auto const mrx = transform::x_rotation(-x_angle);
+         point const pC_norm = mrx(pC3);
+         timer.lap(trilaterate_stage::rotate_x);
+         tracer.trace("x_angle",x_angle);
+         tracer.trace("pC_norm",pC_norm);
+
+         point ip_norm;
+         auto const status = ll_trilaterate(sphere{point{0_km,0_km,0_km},A.radius},sphere{pB_norm,B.radius},sphere{pC_norm,C.radius},ip_norm);
+         timer.lap(trilaterate_stage::ll_trilaterate);
+         if ( status != trilaterate_status::solved){
+            return status;
+         }
+         tracer.trace("ip_norm",ip_norm);
+
+         out = (mrx * mrz * mry * mt).inverse()(ip_norm);
+         timer.lap(trilaterate_stage::inverse_transform);
+         tracer.trace("ip0",out);
+         return trilaterate_status::solved;
+      }
+   };
+
+   // as matrix calc but aligns with quan::three_d rotations
+   struct vect_calc{
+
+      static constexpr char const * name = "vect";
+
+      template <typename Tracer>
+      static trilaterate_status align_and_solve(sphere const& A, sphere const & B, sphere const & C,point & out, Tracer & tracer)
+      {
+         trilaterate_stage_timer timer;
+
+         // translate system so that A is at origin
+         auto const pA_norm = A.centre - A.centre;
+         assert ( (pA_norm == point{0_km,0_km,0_km}) );
+         auto const pB1 = B.centre - A.centre;
+         auto const pC1 = C.centre - A.centre;
+         timer.lap(trilaterate_stage::translate);
+         tracer.trace("pA_norm",pA_norm);
+         tracer.trace("pB1",pB1);
+         tracer.trace("pC1",pC1);
+
+         // rotate around y-axis so that pB.z == 0
+         auto const y_angle = quan::atan2(pB1.z,pB1.x);
+         quan::three_d::y_rotation y_rotate{-y_angle};
+         auto const pB2 = y_rotate(pB1); 
+         auto const pC2 = y_rotate(pC1);
+         timer.lap(trilaterate_stage::rotate_y);
+         tracer.trace("y_angle",y_angle);
+         tracer.trace("pB2",pB2);
+         tracer.trace("pC2",pC2);
+
+         // rotate around z-axis so that pB.y == 0
+         auto const z_angle = quan::atan2(pB2.y,pB2.x);
+         quan::three_d::z_rotation z_rotate{-z_angle};
+         auto const pB_norm = z_rotate(pB2); 
+         assert(abs(pB_norm.z) < epsilon_km);
+         assert(abs(pB_norm.y) < epsilon_km);
+       
+         auto const pC3 = z_rotate(pC2);
+         timer.lap(trilaterate_stage::rotate_z);
+         tracer.trace("z_angle",z_angle);
+         tracer.trace("pB_norm",pB_norm);
+         tracer.trace("pC3",pC3);
+
+         // rotate around x-axis so that pC.z == 0
+         auto const x_angle = quan::atan2(pC3.z,pC3.y);
+         quan::three_d::x_rotation x_rotate{-x_angle};
+         auto const pC_norm = x_rotate(pC3);
+         assert(abs(pC_norm.z) < epsilon_km);
+         timer.lap(trilaterate_stage::rotate_x);
+         tracer.trace("x_angle",x_angle);
+         tracer.trace("pC_norm",pC_norm);
+
+         point ip_norm;
+         auto const status = ll_trilaterate(sphere{pA_norm,A.radius},sphere{pB_norm,B.radius},sphere{pC_norm,C.radius},ip_norm);
+         timer.lap(trilaterate_stage::ll_trilaterate);
+         if ( status != trilaterate_status::solved){
+            return status;
+         }
+         tracer.trace("ip_norm",ip_norm);
+
+         quan::three_d::x_rotation x_unrotate(x_angle);
+         point const ip3 = x_unrotate(ip_norm);
+         quan::three_d::z_rotation z_unrotate(z_angle);
+         point const ip2 = z_unrotate(ip3);
+         quan::three_d::y_rotation y_unrotate(y_angle);
+         point ip1 = y_unrotate(ip2);
+         out = ip1 + A.centre;
+         timer.lap(trilaterate_stage::inverse_transform);
+         tracer.trace("ip0",out);
+         return trilaterate_status::solved;
+      }
+   };
+
+   /*
+     to align for basis calc
+     B1, C1  <- translate B,C by -A.centre
+     ex = unit_vector(B1)
+     ey = unit_vector(C1 - dot_product(ex,C1) * ex)    ( Gram-Schmidt)
+     ez = ex cross ey
+     ex, ey, ez are the rows of the rotation to the normalised frame
+     so the rotation back is the transpose
+   */
+   struct basis_calc{
+
+      static constexpr char const * name = "basis";
+
+      template <typename Length, typename Tracer>
+      static trilaterate_status align_and_solve(quan::three_d::sphere<Length> const& A, 
+         quan::three_d::sphere<Length> const & B, quan::three_d::sphere<Length> const & C,
+         quan::three_d::vect<Length> & out, Tracer & tracer)
+      {
+         typedef quan::three_d::vect<Length> point;
+         typedef quan::three_d::sphere<Length> sphere;
+         trilaterate_stage_timer timer;
+         auto const pB1 = B.centre - A.centre;
+         auto const pC1 = C.centre - A.centre;
+         timer.lap(trilaterate_stage::translate);
+         tracer.trace("pB1",pB1);
+         tracer.trace("pC1",pC1);
+
+         auto const ex = unit_vector(pB1);
+         auto const i = dot_product(ex,pC1);
+         auto const ey = unit_vector(pC1 - i * ex);
+         auto const ez = decltype(ex){
+            ex.y * ey.z - ex.z * ey.y,
+            ex.z * ey.x - ex.x * ey.z,
+            ex.x * ey.y - ex.y * ey.x
+         };
+         point const pA_norm{Length{0},Length{0},Length{0}};
+         point const pB_norm{magnitude(pB1),Length{0},Length{0}};
+         point const pC_norm{i,dot_product(ey,pC1),Length{0}};
+         timer.lap(trilaterate_stage::basis);
+         tracer.trace("ex",ex);
+         tracer.trace("ey",ey);
+         tracer.trace("ez",ez);
+         tracer.trace("pB_norm",pB_norm);
+         tracer.trace("pC_norm",pC_norm);
+
+         point ip_norm;
+         auto const status = ll_trilaterate(sphere{pA_norm,A.radius},sphere{pB_norm,B.radius},sphere{pC_norm,C.radius},ip_norm);
+         timer.lap(trilaterate_stage::ll_trilaterate);
+         if ( status != trilaterate_status::solved){
+            return status;
+         }
+         tracer.trace("ip_norm",ip_norm);
+         out = A.centre + ip_norm.x * ex + ip_norm.y * ey + ip_norm.z * ez;
+         timer.lap(trilaterate_stage::inverse_transform);
+         tracer.trace("ip0",out);
+         return trilaterate_status::solved;
+      }
+   };
+
+   /*
+     as basis calc but the alignment is a unit quaternion made from the basis
+     so the normalised frame and the transform back are each a quaternion rotation
+     see anchor_frame in trilaterate_frame.hpp to transform many points to and from the frame
+   */
+   struct quaternion_calc{
+
+      static constexpr char const * name = "quaternion";
+
+      template <typename Length, typename Tracer>
+      static trilaterate_status align_and_solve(quan::three_d::sphere<Length> const& A, 
+         quan::three_d::sphere<Length> const & B, quan::three_d::sphere<Length> const & C,
+         quan::three_d::vect<Length> & out, Tracer & tracer)
+      {
+         typedef quan::three_d::vect<Length> point;
+         typedef quan::three_d::sphere<Length> sphere;
+         trilaterate_stage_timer timer;
+         auto const pB1 = B.centre - A.centre;
+         auto const pC1 = C.centre - A.centre;
+         timer.lap(trilaterate_stage::translate);
+         tracer.trace("pB1",pB1);
+         tracer.trace("pC1",pC1);
+
+         auto const ex = unit_vector(pB1);
+         auto const pC1_perp = pC1 - dot_product(ex,pC1) * ex;
+         // the quaternion of a nan basis would fail the normalised frame asserts of ll_trilaterate
+         // also catches nan
+         if ( !(magnitude(pC1_perp) >= epsilon<Length>())){
+            timer.lap(trilaterate_stage::basis);
+            return trilaterate_status::degenerate_C;
+         }
+         auto const ey = unit_vector(pC1_perp);
+         auto const ez = decltype(ex){
+            ex.y * ey.z - ex.z * ey.y,
+            ex.z * ey.x - ex.x * ey.z,
+            ex.x * ey.y - ex.y * ey.x
+         };
+         auto const q = unit_quaternion<typename Length::value_type>::from_basis(ex,ey,ez);
+         point const pA_norm{Length{0},Length{0},Length{0}};
+         point const pB_norm = q.rotate(pB1);
+         point const pC_norm = q.rotate(pC1);
+         timer.lap(trilaterate_stage::basis);
+         tracer.trace("pB_norm",pB_norm);
+         tracer.trace("pC_norm",pC_norm);
+
+         point ip_norm;
+         auto const status = ll_trilaterate(sphere{pA_norm,A.radius},sphere{pB_norm,B.radius},sphere{pC_norm,C.radius},ip_norm);
+         timer.lap(trilaterate_stage::ll_trilaterate);
+         if ( status != trilaterate_status::solved){
+            return status;
+         }
+         tracer.trace("ip_norm",ip_norm);
+         out = q.conjugate().rotate(ip_norm) + A.centre;
+         timer.lap(trilaterate_stage::inverse_transform);
+         tracer.trace("ip0",out);
+         return trilaterate_status::solved;
+      }
+   };
+
+#if defined USE_BASIS_CALC
+   typedef basis_calc default_calc;
+#elif defined USE_QUATERNION_CALC
+   typedef quaternion_calc default_calc;
+#elif defined USE_VECT_CALC
+   typedef vect_calc default_calc;
+#elif defined USE_AFFINE_CALC
+   typedef affine_calc default_calc;
+#else
+   typedef matrix_calc default_calc;
+#endif
+
+   // out is only written if solved
+   template <typename Calc, typename Length, typename Tracer>
+   inline trilaterate_status trilaterate(quan::three_d::sphere<Length> const& A, 
+      quan::three_d::sphere<Length> const & B, quan::three_d::sphere<Length> const & C,
+      quan::three_d::vect<Length> & out, Tracer & tracer)
+   {
+      trilaterate_stage_timer timer{true};
+      auto status = trilaterate_verify(A,B,C);
+      timer.lap(trilaterate_stage::verify);
+      if ( status == trilaterate_status::solved){
+         status = Calc::align_and_solve(A,B,C,out,tracer);
+      }
+      trilaterate_metrics_record(status);
+      tracer.status(status);
+      return status;
+   }
+
+   template <typename Calc, typename Length>
+   inline trilaterate_status trilaterate(quan::three_d::sphere<Length> const& A, 
+      quan::three_d::sphere<Length> const & B, quan::three_d::sphere<Length> const & C,
+      quan::three_d::vect<Length> & out)
+   {
+      null_tracer tracer;
+      return trilaterate<Calc>(A,B,C,out,tracer);
+   }
+
+   // trilaterate with the calc chosen by USE_<calc>_CALC
+   inline trilaterate_status trilaterate(sphere const& A, sphere const & B, sphere const & C,point & out)
+   {
+      return trilaterate<default_calc>(A,B,C,out);
+   }
+
+   template <typename Tracer>
+   inline trilaterate_status trilaterate(sphere const& A, sphere const & B, sphere const & C,point & out, Tracer & tracer)
+   {
+      return trilaterate<default_calc>(A,B,C,out,tracer);
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_HPP_INCLUDED
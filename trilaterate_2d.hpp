@@ -0,0 +1,209 @@
+#ifndef TRILATERATION_TRILATERATE_2D_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_2D_HPP_INCLUDED
+
+/*
+  circle triple solver for anchors in a plane, with the circles at any position
+
+     circle const A{{1_km,2_km},rA}, B{{9_km,3_km},rB}, C{{4_km,8_km},rC};
+     point_2d p;
+     if ( trilaterate_2d(A,B,C,p) == trilaterate_status::solved){ ...}
+
+  subtracting the circle equation of A from those of B and C leaves two linear equations
+  in the position relative to A, solved directly, so there is no rotation to a normalised frame
+  as in trilateration.cpp and no trig or square root
+
+  the status is that of trilaterate for the spheres with the same centres and radii,
+  except that a z_2 a little below 0 is solved where trilaterate has negative_z_squared
+  the position is the projection on the plane of the point where those spheres meet,
+  so a tag below anchors on a ceiling is solved, with z_2 the square of its height below them.
+  a tag in the plane has z_2 near 0, so z_2 may be down to -(2 * rA + range_tolerance) * range_tolerance,
+  that is the range to A may be range_tolerance short.
+  in float z_2 is a small difference of squared ranges, so allow a few mm at ranges of tens of km
+
+  trilaterate_2d_batch solves a structure of arrays of circle triples, see trilaterate_2d_simd.hpp for
+  the vectorised batch
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <quan/two_d/out/vect.hpp>
+
+#include "trilaterate_batch.hpp"
+
+namespace {
+
+   template <typename Length>
+   struct basic_circle{
+      quan::two_d::vect<Length> centre;
+      Length radius;
+   };
+
+   typedef quan::two_d::vect<quan::length::km> point_2d;
+   typedef basic_circle<quan::length::km> circle;
+
+   template <typename Length>
+   inline trilaterate_status trilaterate_2d_verify(basic_circle<Length> const & A,
+      basic_circle<Length> const & B, basic_circle<Length> const & C)
+   {
+      // as trilaterate_verify, on the squares of the distances
+      auto const eps_2 = quan::pow<2>(epsilon<Length>());
+      auto const distAB_2 = dot_product(B.centre - A.centre,B.centre - A.centre);
+      if ( distAB_2 < eps_2){
+         return trilaterate_status::coincident_AB;
+      }
+      if ( distAB_2 >= quan::pow<2>(A.radius + B.radius)){
+         return trilaterate_status::no_intersection_AB;
+      }
+      auto const distBC_2 = dot_product(C.centre - B.centre,C.centre - B.centre);
+      if ( distBC_2 < eps_2){
+         return trilaterate_status::coincident_BC;
+      }
+      if ( distBC_2 >= quan::pow<2>(B.radius + C.radius)){
+         return trilaterate_status::no_intersection_BC;
+      }
+      auto const distAC_2 = dot_product(C.centre - A.centre,C.centre - A.centre);
+      if ( distAC_2 < eps_2){
+         return trilaterate_status::coincident_AC;
+      }
+      if ( distAC_2 >= quan::pow<2>(A.radius + C.radius)){
+         return trilaterate_status::no_intersection_AC;
+      }
+      return trilaterate_status::solved;
+   }
+
+   // A B C must have passed trilaterate_2d_verify
+   template <typename Length, typename Tracer>
+   inline trilaterate_status ll_trilaterate_2d(basic_circle<Length> const & A,
+      basic_circle<Length> const & B, basic_circle<Length> const & C,
+      quan::two_d::vect<Length> & out, Length const & range_tolerance, Tracer & tracer)
+   {
+      // relative to A
+      auto const b = B.centre - A.centre;
+      auto const c = C.centre - A.centre;
+      tracer.trace("b",b);
+      tracer.trace("c",c);
+
+      // B contains A, as ll_trilaterate, rB - rA >= |b| on the signed square
+      // d >= rA + rB was rejected by verify, and A containing B is negative_z_squared below
+      auto const dr = B.radius - A.radius;
+      if ( dr * abs(dr) >= dot_product(b,b)){
+         return trilaterate_status::no_intersection_AB;
+      }
+
+      // twice the area of ABC, C is det / |b| from the line AB
+      auto const det = b.x * c.y - b.y * c.x;
+      // also catches det == nan
+      if ( !(quan::pow<2>(det) >= quan::pow<2>(epsilon<Length>()) * dot_product(b,b))){
+         return trilaterate_status::degenerate_C;
+      }
+
+      // b.p = kb, c.p = kc
+      auto const rA_2 = quan::pow<2>(A.radius);
+      auto const kb = (rA_2 - quan::pow<2>(B.radius) + dot_product(b,b)) / 2;
+      auto const kc = (rA_2 - quan::pow<2>(C.radius) + dot_product(c,c)) / 2;
+      quan::two_d::vect<Length> const p{(kb * c.y - kc * b.y) / det,(b.x * kc - c.x * kb) / det};
+      tracer.trace("p",p);
+
+      auto const z_2 = rA_2 - dot_product(p,p);
+      if ( z_2 >= -(2 * A.radius + range_tolerance) * range_tolerance){
+         out = p + A.centre;
+         return trilaterate_status::solved;
+      }else{
+         return trilaterate_status::negative_z_squared;
+      }
+   }
+
+   // out is only written if solved
+   template <typename Length, typename Tracer>
+   inline trilaterate_status trilaterate_2d(basic_circle<Length> const & A,
+      basic_circle<Length> const & B, basic_circle<Length> const & C,
+      quan::two_d::vect<Length> & out, Length const & range_tolerance, Tracer & tracer)
+   {
+      trilaterate_stage_timer timer{true};
+      auto status = trilaterate_2d_verify(A,B,C);
+      timer.lap(trilaterate_stage::verify);
+      if ( status == trilaterate_status::solved){
+         status = ll_trilaterate_2d(A,B,C,out,range_tolerance,tracer);
+         timer.lap(trilaterate_stage::ll_trilaterate);
+      }
+      trilaterate_metrics_record(status);
+      tracer.status(status);
+      return status;
+   }
+
+   template <typename Length>
+   inline trilaterate_status trilaterate_2d(basic_circle<Length> const & A,
+      basic_circle<Length> const & B, basic_circle<Length> const & C,
+      quan::two_d::vect<Length> & out, Length const & range_tolerance = epsilon<Length>())
+   {
+      null_tracer tracer;
+      return trilaterate_2d(A,B,C,out,range_tolerance,tracer);
+   }
+
+   // structure of arrays view of circle triples
+   // every array must hold at least size elements
+   template <typename Length>
+   struct basic_circle_soa{
+      Length const * x;
+      Length const * y;
+      Length const * radius;
+   };
+
+   template <typename Length>
+   struct basic_circle_triple_soa{
+      std::size_t size;
+      basic_circle_soa<Length> A;
+      basic_circle_soa<Length> B;
+      basic_circle_soa<Length> C;
+   };
+
+   template <typename Length>
+   struct basic_point_2d_soa{
+      Length * x;
+      Length * y;
+   };
+
+   typedef basic_circle_triple_soa<quan::length::km> circle_triple_soa;
+   typedef basic_point_2d_soa<quan::length::km> point_2d_soa;
+
+   template <typename Length>
+   inline basic_circle<Length> get_circle(basic_circle_soa<Length> const & in, std::size_t n)
+   {
+      return basic_circle<Length>{{in.x[n],in.y[n]},in.radius[n]};
+   }
+
+   // trilaterate_2d without diagnostic output or metrics
+   template <typename Length>
+   inline trilaterate_status trilaterate_2d_element(basic_circle<Length> const & A, basic_circle<Length> const & B,
+      basic_circle<Length> const & C, quan::two_d::vect<Length> & out, Length const & range_tolerance)
+   {
+      null_tracer tracer;
+      auto const status = trilaterate_2d_verify(A,B,C);
+      return ( status == trilaterate_status::solved) ? ll_trilaterate_2d(A,B,C,out,range_tolerance,tracer) : status;
+   }
+
+   // solve in.size circle triples
+   // status[n] is set to the trilaterate_status of each triple
+   // out is only written where the triple was solved
+   // returns the number of triples solved
+   template <typename Length>
+   inline std::size_t trilaterate_2d_batch(basic_circle_triple_soa<Length> const & in, basic_point_2d_soa<Length> const & out,
+      trilaterate_status * status, Length const & range_tolerance = epsilon<Length>())
+   {
+      std::size_t num_solved = 0;
+      for ( std::size_t n = 0; n < in.size; ++n){
+         quan::two_d::vect<Length> ip;
+         status[n] = trilaterate_2d_element(get_circle(in.A,n),get_circle(in.B,n),get_circle(in.C,n),ip,range_tolerance);
+         if ( status[n] == trilaterate_status::solved){
+            out.x[n] = ip.x;
+            out.y[n] = ip.y;
+            ++num_solved;
+         }
+      }
+      return num_solved;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_2D_HPP_INCLUDED
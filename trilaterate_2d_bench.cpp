@@ -0,0 +1,275 @@
+/*
+  trilaterate_2d_batch and trilaterate_2d_batch_simd against the 3D solvers on the same anchors
+
+  anchors at any position in a square of side 20 km on one plane
+  below anchors : the tag 0 to 3 m below the plane, exact ranges, so the 3D solvers also solve
+  in plane      : the tag in the plane, ranges with +- 1 m noise, solved with the default range_tolerance
+                  and with a range_tolerance of 1 m
+
+  reports ns per solve, the number solved and the distance of the solved position from the tag
+  as p50, p99 and max in m ( for the 3D solvers, of x y from the tag).
+  one of A B inside the other : every 4th triple has B inside A, A inside B, or A just inside B
+  the max is from the nearly collinear anchors, where range errors are much magnified
+  fails if a simd batch differs from the scalar trilaterate_2d_batch by more than epsilon_km,
+  or the status of trilaterate_2d_batch differs from the 3D trilaterate_batch, 
+  other than a z_2 a little below 0 solved in 2D
+
+  usage : trilaterate_2d_bench.exe [num_triples]
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_2d_simd.hpp"
+#include "trilaterate_bench.hpp"
+#include "trilaterate_dispatch.hpp"
+
+namespace {
+
+   // owns the arrays behind a circle_triple_soa
+   template <typename Length>
+   struct basic_circle_triple_arrays{
+
+      explicit basic_circle_triple_arrays(std::size_t n)
+      : x(9,std::vector<Length>(n)),tag(n){}
+
+      template <typename Length1>
+      explicit basic_circle_triple_arrays(basic_circle_triple_arrays<Length1> const & in)
+      : x(9,std::vector<Length>(in.size())),tag(in.tag)
+      {
+         for ( int i = 0; i < 9; ++i){
+            for ( std::size_t n = 0; n < in.size(); ++n){
+               x[i][n] = Length{static_cast<typename Length::value_type>(in.x[i][n].numeric_value())};
+            }
+         }
+      }
+
+      std::size_t size() const { return tag.size();}
+
+      basic_circle_soa<Length> circle_view(int s) const
+      {
+         return {x[3*s].data(),x[3*s+1].data(),x[3*s+2].data()};
+      }
+
+      basic_circle_triple_soa<Length> soa() const
+      {
+         return {size(),circle_view(0),circle_view(1),circle_view(2)};
+      }
+
+      void set(int s, std::size_t n, basic_circle<Length> const & in)
+      {
+         x[3*s][n] = in.centre.x;
+         x[3*s+1][n] = in.centre.y;
+         x[3*s+2][n] = in.radius;
+      }
+
+      // the same triples as spheres with z 0
+      sphere_triple_arrays spheres() const
+      {
+         sphere_triple_arrays result{size()};
+         for ( std::size_t n = 0; n < size(); ++n){
+            for ( int s = 0; s < 3; ++s){
+               result.set(s,n,sphere{{x[3*s][n],x[3*s+1][n],0_km},x[3*s+2][n]});
+            }
+            result.tag[n] = point{tag[n].x,tag[n].y,0_km};
+         }
+         return result;
+      }
+
+      // ax,ay,ar, bx .. cr
+      std::vector<std::vector<Length> > x;
+      // the projection on the plane of the point the ranges were measured from
+      std::vector<point_2d> tag;
+   };
+
+   template <typename Length>
+   struct basic_point_2d_arrays{
+      explicit basic_point_2d_arrays(std::size_t n) : x(n),y(n),status(n){}
+      basic_point_2d_soa<Length> soa() { return {x.data(),y.data()};}
+      point_2d get(std::size_t n) const
+      {
+         return {quan::length::km{x[n].numeric_value()},quan::length::km{y[n].numeric_value()}};
+      }
+      std::vector<Length> x;
+      std::vector<Length> y;
+      std::vector<trilaterate_status> status;
+   };
+
+   typedef basic_circle_triple_arrays<quan::length::km> circle_triple_arrays;
+   typedef basic_point_2d_arrays<quan::length::km> point_2d_arrays;
+
+   // tag height below the plane up to depth, range noise up to +- noise
+   circle_triple_arrays make_random_circle_triples(std::size_t n, unsigned seed,
+      quan::length::km const & depth, quan::length::km const & noise)
+   {
+      std::mt19937_64 gen{seed};
+      std::uniform_real_distribution<double> pos{0.0,20.0};
+      std::uniform_real_distribution<double> height{0.0,depth.numeric_value()};
+      std::uniform_real_distribution<double> err{-noise.numeric_value(),noise.numeric_value()};
+      auto random_point = [&]{ return point_2d{quan::length::km{pos(gen)},quan::length::km{pos(gen)}};};
+
+      circle_triple_arrays result{n};
+      for ( std::size_t i = 0; i < n; ++i){
+         point_2d const tag = random_point();
+         auto const h = quan::length::km{height(gen)};
+         result.tag[i] = tag;
+         for ( int s = 0; s < 3; ++s){
+            point_2d const centre = random_point();
+            auto const range = sqrt(dot_product(tag - centre,tag - centre) + h * h) + quan::length::km{err(gen)};
+            result.set(s,i,circle{centre,range});
+         }
+      }
+      return result;
+   }
+
+   // every 4th triple, B inside A, then A inside B, then A 1 m inside B
+   void make_containment(circle_triple_arrays & triples)
+   {
+      for ( std::size_t n = 0; n < triples.size(); n += 4){
+         quan::length::km * const ar = triples.x[2].data();
+         quan::length::km * const br = triples.x[5].data();
+         point_2d const b{triples.x[3][n] - triples.x[0][n],triples.x[4][n] - triples.x[1][n]};
+         auto const d = magnitude(b);
+         switch ( (n / 4) % 3){
+            case 0: ar[n] = d + br[n] + 1_km; break;
+            case 1: br[n] = d + ar[n] + 1_km; break;
+            default: br[n] = d + ar[n] + 0.001_km; break;
+         }
+      }
+   }
+
+   // the number solved and the errors of the solved positions from the tag in m, sorted
+   struct result_stats{
+      std::size_t num_solved;
+      std::vector<double> errors;
+   };
+
+   template <typename Result, typename Tag>
+   result_stats stats(Result const & result, std::vector<Tag> const & tag)
+   {
+      result_stats s{0,{}};
+      for ( std::size_t n = 0; n < tag.size(); ++n){
+         if ( result.status[n] == trilaterate_status::solved){
+            ++s.num_solved;
+            auto const p = result.get(n);
+            auto const error = sqrt(quan::pow<2>(p.x - tag[n].x) + quan::pow<2>(p.y - tag[n].y));
+            s.errors.push_back(error.numeric_value() * 1000.0);
+         }
+      }
+      std::sort(s.errors.begin(),s.errors.end());
+      return s;
+   }
+
+   void report(char const * name, double ns, result_stats const & s, std::size_t num_triples)
+   {
+      std::cout << "   " << name << " : ns/solve = " << ns << ", solved = " << s.num_solved << '/' << num_triples;
+      if ( !s.errors.empty()){
+         auto quantile = [&s](double q){ return s.errors[static_cast<std::size_t>(q * (s.errors.size() - 1))];};
+         std::cout << ", error (m) p50 = " << quantile(0.5) << ", p99 = " << quantile(0.99) << ", max = " << s.errors.back();
+      }
+      std::cout << '\n';
+   }
+
+   // false if the simd batches differ from the scalar 2D batch by more than epsilon_km
+   bool run(char const * name, circle_triple_arrays const & triples, quan::length::km const & range_tolerance, bool run_3d)
+   {
+      std::size_t const num_triples = triples.size();
+      std::cout << name << '\n';
+
+      std::vector<trilaterate_status> status_3d;
+      if ( run_3d){
+         auto const spheres = triples.spheres();
+         point_arrays result{num_triples};
+         double const ns = ns_per_item(num_triples,[&]{ trilaterate_batch(spheres.soa(),result.soa(),result.status.data());});
+         report("3D trilaterate_batch",ns,stats(result,triples.tag),num_triples);
+         status_3d = result.status;
+         trilaterate_dispatcher const basis{trilaterate_calc_id::basis};
+         double const basis_ns = ns_per_item(num_triples,[&]{ basis.batch(spheres.soa(),result.soa(),result.status.data());});
+         report("3D basis calc",basis_ns,stats(result,triples.tag),num_triples);
+         double const simd_ns = ns_per_item(num_triples,[&]{ trilaterate_batch_simd(spheres.soa(),result.soa(),result.status.data());});
+         report("3D trilaterate_batch_simd",simd_ns,stats(result,triples.tag),num_triples);
+      }
+
+      point_2d_arrays scalar_result{num_triples};
+      double const scalar_ns = ns_per_item(num_triples,[&]{
+         trilaterate_2d_batch(triples.soa(),scalar_result.soa(),scalar_result.status.data(),range_tolerance);
+      });
+      report("2D trilaterate_2d_batch",scalar_ns,stats(scalar_result,triples.tag),num_triples);
+
+      bool success = true;
+      if ( run_3d){
+         // z_2 within range_tolerance below 0 is solved in 2D
+         std::size_t tolerance_solved = 0;
+         std::size_t status_mismatch = 0;
+         for ( std::size_t n = 0; n < num_triples; ++n){
+            if ( scalar_result.status[n] != status_3d[n]){
+               if ( (scalar_result.status[n] == trilaterate_status::solved) 
+                     && (status_3d[n] == trilaterate_status::negative_z_squared)){
+                  ++tolerance_solved;
+               }else{
+                  ++status_mismatch;
+               }
+            }
+         }
+         std::cout << "      status against 3D trilaterate_batch : mismatches = " << status_mismatch
+            << ", solved in 2D by range_tolerance = " << tolerance_solved << '\n';
+         if ( status_mismatch != 0){
+            success = false;
+         }
+      }
+      for ( auto level : {simd_level::avx2, simd_level::avx512}){
+         if ( level > cpu_simd_level()){
+            continue;
+         }
+         point_2d_arrays result{num_triples};
+         double const ns = ns_per_item(num_triples,[&]{
+            trilaterate_2d_batch_simd(triples.soa(),result.soa(),result.status.data(),level,range_tolerance);
+         });
+         auto max_diff = 0_km;
+         std::size_t status_mismatch = 0;
+         for ( std::size_t n = 0; n < num_triples; ++n){
+            if ( scalar_result.status[n] != result.status[n]){
+               ++status_mismatch;
+            }else if ( result.status[n] == trilaterate_status::solved){
+               auto const diff = magnitude(scalar_result.get(n) - result.get(n));
+               if ( diff > max_diff){
+                  max_diff = diff;
+               }
+            }
+         }
+         report(level == simd_level::avx2 ? "2D avx2 double" : "2D avx512 double",ns,stats(result,triples.tag),num_triples);
+         std::cout << "      difference from scalar = " << max_diff << ", status mismatches = " << status_mismatch << '\n';
+         if ( max_diff > epsilon_km){
+            success = false;
+         }
+
+         basic_circle_triple_arrays<km_<float> > const triples_f{triples};
+         basic_point_2d_arrays<km_<float> > result_f{num_triples};
+         double const ns_f = ns_per_item(num_triples,[&]{
+            trilaterate_2d_batch_simd(triples_f.soa(),result_f.soa(),result_f.status.data(),level,
+               km_<float>{static_cast<float>(range_tolerance.numeric_value())});
+         });
+         report(level == simd_level::avx2 ? "2D avx2 float" : "2D avx512 float",ns_f,stats(result_f,triples.tag),num_triples);
+      }
+      return success;
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_triples = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+   std::cout << "cpu simd level = " << simd_level_name(cpu_simd_level()) << '\n';
+
+   bool success = run("below anchors",make_random_circle_triples(num_triples,1,0.003_km,0_km),epsilon_km,true);
+
+   auto const in_plane = make_random_circle_triples(num_triples,2,0_km,0.001_km);
+   success = run("in plane, default range_tolerance",in_plane,epsilon_km,true) && success;
+   success = run("in plane, range_tolerance 1 m",in_plane,0.001_km,false) && success;
+
+   auto contained = make_random_circle_triples(num_triples,3,0.003_km,0_km);
+   make_containment(contained);
+   success = run("one of A B inside the other",contained,epsilon_km,true) && success;
+
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
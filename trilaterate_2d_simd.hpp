@@ -0,0 +1,80 @@
+#ifndef TRILATERATION_TRILATERATE_2D_SIMD_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_2D_SIMD_HPP_INCLUDED
+
+/*
+  AVX2 and AVX-512 versions of trilaterate_2d_batch, using the lanes of trilaterate_simd.hpp
+  the instruction set is picked at runtime, falling back to the scalar trilaterate_2d_batch
+  double and float value types are supported
+  the status of a failed lane is the first of its masks to fail, as trilaterate_2d_batch
+
+  gcc or clang on x86 only
+*/
+
+#include "trilaterate_2d.hpp"
+#include "trilaterate_simd.hpp"
+
+namespace {
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+   namespace avx2 {
+
+      namespace f64 {
+#include "trilaterate_2d_simd_kernel.ipp"
+      } // f64
+
+      namespace f32 {
+#include "trilaterate_2d_simd_kernel.ipp"
+      } // f32
+
+      using f64::trilaterate_2d_batch;
+      using f32::trilaterate_2d_batch;
+
+   } // avx2
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+   namespace avx512 {
+
+      namespace f64 {
+#include "trilaterate_2d_simd_kernel.ipp"
+      } // f64
+
+      namespace f32 {
+#include "trilaterate_2d_simd_kernel.ipp"
+      } // f32
+
+      using f64::trilaterate_2d_batch;
+      using f32::trilaterate_2d_batch;
+
+   } // avx512
+
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+   // as trilaterate_2d_batch but using the simd kernel for level
+   // level must be supported by the cpu
+   // Length is quan::length::km or km_<float>
+   template <typename Length>
+   inline std::size_t trilaterate_2d_batch_simd(basic_circle_triple_soa<Length> const & in, basic_point_2d_soa<Length> const & out,
+      trilaterate_status * status, simd_level level = cpu_simd_level(), Length const & range_tolerance = epsilon<Length>())
+   {
+      switch (level){
+         case simd_level::avx512:
+            return avx512::trilaterate_2d_batch(in,out,status,range_tolerance);
+         case simd_level::avx2:
+            return avx2::trilaterate_2d_batch(in,out,status,range_tolerance);
+         default:
+            return trilaterate_2d_batch(in,out,status,range_tolerance);
+      }
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_2D_SIMD_HPP_INCLUDED
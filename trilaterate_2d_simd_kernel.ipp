@@ -0,0 +1,105 @@
+/*
+  lane kernel for trilaterate_2d_simd.hpp
+  included once per instruction set and value type, after trilaterate_simd_kernel.ipp in the same namespace
+  whose length, scalar and load it uses, and with the matching #pragma GCC target in effect
+*/
+
+   // the failure of each test of trilaterate_2d_element, in the order it makes them
+   constexpr trilaterate_status lane_2d_test_failure[] = {
+      trilaterate_status::coincident_AB, trilaterate_status::no_intersection_AB,
+      trilaterate_status::coincident_BC, trilaterate_status::no_intersection_BC,
+      trilaterate_status::coincident_AC, trilaterate_status::no_intersection_AC,
+      trilaterate_status::no_intersection_AB,   // B contains A, in ll_trilaterate_2d
+      trilaterate_status::degenerate_C, trilaterate_status::negative_z_squared
+   };
+   constexpr int num_lane_2d_tests = sizeof(lane_2d_test_failure) / sizeof(lane_2d_test_failure[0]);
+
+   // trilaterate_2d_verify and ll_trilaterate_2d over lanes::width triples at n
+   // status[0 .. width) is set to the status of each lane, the first test it failed as trilaterate_2d_element
+   // returns the mask of lanes solved
+   inline int trilaterate_2d_lanes(basic_circle_triple_soa<length> const & in, std::size_t n, basic_point_2d_soa<length> const & out,
+      typename lanes::reg range_tolerance, trilaterate_status * status)
+   {
+      typedef typename lanes::reg reg;
+      typedef typename lanes::mask mask;
+
+      reg const ax = load(in.A.x + n);
+      reg const ay = load(in.A.y + n);
+      reg const ar = load(in.A.radius + n);
+      reg const br = load(in.B.radius + n);
+      reg const cr = load(in.C.radius + n);
+
+      // relative to A
+      reg const bx = lanes::sub(load(in.B.x + n),ax);
+      reg const by = lanes::sub(load(in.B.y + n),ay);
+      reg const cx = lanes::sub(load(in.C.x + n),ax);
+      reg const cy = lanes::sub(load(in.C.y + n),ay);
+
+      // verify on the squares of the distances
+      reg const eps = lanes::set1(epsilon<length>().numeric_value());
+      reg const eps_2 = lanes::mul(eps,eps);
+      reg const distAB_2 = lanes::add(lanes::mul(bx,bx),lanes::mul(by,by));
+      reg const distAC_2 = lanes::add(lanes::mul(cx,cx),lanes::mul(cy,cy));
+      reg const bcx = lanes::sub(cx,bx);
+      reg const bcy = lanes::sub(cy,by);
+      reg const distBC_2 = lanes::add(lanes::mul(bcx,bcx),lanes::mul(bcy,bcy));
+      reg const rAB = lanes::add(ar,br);
+      reg const rBC = lanes::add(br,cr);
+      reg const rAC = lanes::add(ar,cr);
+      // rB - rA on its signed square
+      reg const dr = lanes::sub(br,ar);
+      reg const dr_2 = lanes::mul(dr,lanes::max(dr,lanes::sub(lanes::zero(),dr)));
+
+      // C off the line AB
+      reg const det = lanes::sub(lanes::mul(bx,cy),lanes::mul(by,cx));
+
+      // b.p = kb, c.p = kc
+      reg const half = lanes::set1(scalar{0.5});
+      reg const ar_2 = lanes::mul(ar,ar);
+      reg const kb = lanes::mul(lanes::add(lanes::sub(ar_2,lanes::mul(br,br)),distAB_2),half);
+      reg const kc = lanes::mul(lanes::add(lanes::sub(ar_2,lanes::mul(cr,cr)),distAC_2),half);
+      reg const inv_det = lanes::div(lanes::set1(scalar{1}),det);
+      reg const px = lanes::mul(lanes::sub(lanes::mul(kb,cy),lanes::mul(kc,by)),inv_det);
+      reg const py = lanes::mul(lanes::sub(lanes::mul(bx,kc),lanes::mul(cx,kb)),inv_det);
+
+      // z_2 >= -(2 * rA + range_tolerance) * range_tolerance
+      reg const z_2 = lanes::sub(ar_2,lanes::add(lanes::mul(px,px),lanes::mul(py,py)));
+      reg const min_z_2 = lanes::sub(lanes::zero(),lanes::mul(lanes::add(lanes::add(ar,ar),range_tolerance),range_tolerance));
+
+      // the lanes passing each test of lane_2d_test_failure
+      mask const pass[num_lane_2d_tests] = {
+         lanes::ge(distAB_2,eps_2), lanes::lt(distAB_2,lanes::mul(rAB,rAB)),
+         lanes::ge(distBC_2,eps_2), lanes::lt(distBC_2,lanes::mul(rBC,rBC)),
+         lanes::ge(distAC_2,eps_2), lanes::lt(distAC_2,lanes::mul(rAC,rAC)),
+         lanes::lt(dr_2,distAB_2),
+         lanes::ge(lanes::mul(det,det),lanes::mul(eps_2,distAB_2)),
+         lanes::ge(z_2,min_z_2)
+      };
+      mask const ok = lane_status(pass,lane_2d_test_failure,status);
+
+      lanes::store(reinterpret_cast<scalar *>(out.x + n),ok,lanes::add(ax,px));
+      lanes::store(reinterpret_cast<scalar *>(out.y + n),ok,lanes::add(ay,py));
+      return lanes::bits(ok);
+   }
+
+   inline std::size_t trilaterate_2d_batch(basic_circle_triple_soa<length> const & in, basic_point_2d_soa<length> const & out,
+      trilaterate_status * status, length const & range_tolerance)
+   {
+      typename lanes::reg const tolerance = lanes::set1(range_tolerance.numeric_value());
+      std::size_t num_solved = 0;
+      std::size_t n = 0;
+      for ( ; (n + lanes::width) <= in.size; n += lanes::width){
+         num_solved += __builtin_popcount(trilaterate_2d_lanes(in,n,out,tolerance,status + n));
+      }
+      // remainder
+      for ( ; n < in.size; ++n){
+         quan::two_d::vect<length> ip;
+         status[n] = trilaterate_2d_element(get_circle(in.A,n),get_circle(in.B,n),get_circle(in.C,n),ip,range_tolerance);
+         if ( status[n] == trilaterate_status::solved){
+            out.x[n] = ip.x;
+            out.y[n] = ip.y;
+            ++num_solved;
+         }
+      }
+      return num_solved;
+   }
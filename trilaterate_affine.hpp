@@ -0,0 +1,139 @@
+#ifndef TRILATERATION_TRILATERATE_AFFINE_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_AFFINE_HPP_INCLUDED
+
+/*
+  rotation plus translation as a 3x4 matrix, for column vectors
+
+     p' = R * p + t
+
+  replaces the 4x4 homogeneous quan::fusion matrices of matrix_calc, whose last column
+  is always 0 0 0 1 and whose rotations multiply many known zeros.
+  each row of R and its element of t are stored together as 4 values,
+  so a row is one aligned 32 byte load for double
+
+  the rotation is dimensionless, the translation and the points are Length
+  the rotations turn in the same sense as the quan::fusion rotation matrices
+  x_rotation y towards z, y_rotation x towards z, z_rotation x towards y
+*/
+
+#include <quan/out/angle.hpp>
+#include <quan/three_d/vect.hpp>
+
+namespace {
+
+   template <typename Length>
+   class affine_transform{
+   public:
+      typedef typename Length::value_type value_type;
+      typedef quan::three_d::vect<Length> vect_type;
+
+      // identity
+      constexpr affine_transform()
+      : m_m{{1,0,0,0},{0,1,0,0},{0,0,1,0}}{}
+
+      static affine_transform translation(vect_type const & v)
+      {
+         affine_transform result;
+         result.set_translation(v);
+         return result;
+      }
+
+      static affine_transform x_rotation(quan::angle::rad const & angle)
+      {
+         value_type const c = quan::cos(angle);
+         value_type const s = quan::sin(angle);
+         return affine_transform{{1,0,0},{0,c,-s},{0,s,c}};
+      }
+
+      static affine_transform y_rotation(quan::angle::rad const & angle)
+      {
+         value_type const c = quan::cos(angle);
+         value_type const s = quan::sin(angle);
+         return affine_transform{{c,0,-s},{0,1,0},{s,0,c}};
+      }
+
+      static affine_transform z_rotation(quan::angle::rad const & angle)
+      {
+         value_type const c = quan::cos(angle);
+         value_type const s = quan::sin(angle);
+         return affine_transform{{c,-s,0},{s,c,0},{0,0,1}};
+      }
+
+      // transform p
+      vect_type operator()(vect_type const & p) const
+      {
+         return vect_type{row(0,p),row(1,p),row(2,p)};
+      }
+
+      // rotate a direction or a displacement, without the translation
+      template <typename T>
+      quan::three_d::vect<T> rotate(quan::three_d::vect<T> const & v) const
+      {
+         return quan::three_d::vect<T>{
+            m_m[0][0] * v.x + m_m[0][1] * v.y + m_m[0][2] * v.z,
+            m_m[1][0] * v.x + m_m[1][1] * v.y + m_m[1][2] * v.z,
+            m_m[2][0] * v.x + m_m[2][1] * v.y + m_m[2][2] * v.z
+         };
+      }
+
+      // the transform applying b and then a
+      friend affine_transform operator*(affine_transform const & a, affine_transform const & b)
+      {
+         affine_transform result;
+         for ( int r = 0; r < 3; ++r){
+            for ( int c = 0; c < 4; ++c){
+               result.m_m[r][c] = a.m_m[r][0] * b.m_m[0][c] + a.m_m[r][1] * b.m_m[1][c] + a.m_m[r][2] * b.m_m[2][c];
+            }
+            result.m_m[r][3] += a.m_m[r][3];
+         }
+         return result;
+      }
+
+      // R must be a rotation, the inverse is then the transpose of R and -transpose(R) * t
+      affine_transform inverse() const
+      {
+         affine_transform result{
+            {m_m[0][0],m_m[1][0],m_m[2][0]},
+            {m_m[0][1],m_m[1][1],m_m[2][1]},
+            {m_m[0][2],m_m[1][2],m_m[2][2]}
+         };
+         result.set_translation(-result.rotate(translation()));
+         return result;
+      }
+
+      vect_type translation() const
+      {
+         return vect_type{Length{m_m[0][3]},Length{m_m[1][3]},Length{m_m[2][3]}};
+      }
+
+      // element of R
+      value_type rotation(int r, int c) const { return m_m[r][c];}
+
+   private:
+
+      typedef value_type row_type[3];
+
+      // rotation with rows r0 r1 r2
+      affine_transform(row_type const & r0, row_type const & r1, row_type const & r2)
+      : m_m{{r0[0],r0[1],r0[2],0},{r1[0],r1[1],r1[2],0},{r2[0],r2[1],r2[2],0}}{}
+
+      void set_translation(vect_type const & v)
+      {
+         m_m[0][3] = v.x.numeric_value();
+         m_m[1][3] = v.y.numeric_value();
+         m_m[2][3] = v.z.numeric_value();
+      }
+
+      Length row(int r, vect_type const & p) const
+      {
+         return Length{m_m[r][0] * p.x.numeric_value() + m_m[r][1] * p.y.numeric_value()
+            + m_m[r][2] * p.z.numeric_value() + m_m[r][3]};
+      }
+
+      // rows of R, each followed by its element of t in units of Length
+      alignas(4 * sizeof(value_type)) value_type m_m[3][4];
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_AFFINE_HPP_INCLUDED
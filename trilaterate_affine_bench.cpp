@@ -0,0 +1,125 @@
+/*
+  affine_transform against the 4x4 quan::fusion matrices of matrix_calc
+
+  compose : the transform back from the normalised frame of matrix_calc,
+            x, z and y rotations then a translation, composed and applied to one point
+  apply   : one composed transform applied to many points
+  solve   : trilaterate<matrix_calc> against trilaterate<affine_calc>
+
+  reports ns per item and the max difference between the results
+
+  usage : trilaterate_affine_bench.exe [num_items]
+*/
+
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_dispatch.hpp"
+
+namespace {
+
+   typedef affine_transform<quan::length::km> transform;
+
+   struct angles{
+      quan::angle::rad x;
+      quan::angle::rad y;
+      quan::angle::rad z;
+   };
+
+   auto fusion_transform(angles const & a, point const & t)
+   {
+      return quan::fusion::make_3d_x_rotation_matrix<quan::length::km>(a.x)
+         * quan::fusion::make_3d_z_rotation_matrix<quan::length::km>(a.z)
+         * quan::fusion::make_3d_y_rotation_matrix<quan::length::km>(a.y)
+         * quan::fusion::make_translation_matrix(t);
+   }
+
+   transform affine(angles const & a, point const & t)
+   {
+      return transform::translation(t) * transform::y_rotation(a.y) * transform::z_rotation(a.z) * transform::x_rotation(a.x);
+   }
+
+   void report(char const * name, double fusion_ns, double affine_ns, quan::length::km const & max_diff)
+   {
+      std::cout << name << " : fusion ns = " << fusion_ns << ", affine ns = " << affine_ns
+         << ", speedup = " << fusion_ns / affine_ns << ", max difference = " << max_diff << '\n';
+   }
+
+   template <typename Points>
+   quan::length::km max_difference(Points const & a, Points const & b)
+   {
+      auto max_diff = 0_km;
+      for ( std::size_t n = 0; n < a.size(); ++n){
+         auto const diff = magnitude(a[n] - b[n]);
+         if ( diff > max_diff){
+            max_diff = diff;
+         }
+      }
+      return max_diff;
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_items = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+
+   auto const triples = make_random_triples(num_items);
+   std::mt19937_64 gen{1};
+   std::uniform_real_distribution<double> angle{-3.14159,3.14159};
+   std::vector<angles> rotations(num_items);
+   for ( auto & r : rotations){
+      r = angles{quan::angle::rad{angle(gen)},quan::angle::rad{angle(gen)},quan::angle::rad{angle(gen)}};
+   }
+   // point n is transformed by rotations[n] and translated to the tag of triple n
+   auto const & points = triples.tag;
+   auto const & translations = triples.tag;
+
+   std::vector<point> fusion_result(num_items);
+   std::vector<point> affine_result(num_items);
+
+   double const fusion_compose_ns = ns_per_item(num_items,[&]{
+      for ( std::size_t n = 0; n < num_items; ++n){
+         fusion_result[n] = as_vect3d(quan::fusion::make_row_matrix(points[n]) * fusion_transform(rotations[n],translations[n]));
+      }
+   });
+   double const affine_compose_ns = ns_per_item(num_items,[&]{
+      for ( std::size_t n = 0; n < num_items; ++n){
+         affine_result[n] = affine(rotations[n],translations[n])(points[n]);
+      }
+   });
+   report("compose",fusion_compose_ns,affine_compose_ns,max_difference(fusion_result,affine_result));
+
+   auto const fusion_mx = fusion_transform(rotations[0],translations[0]);
+   auto const affine_mx = affine(rotations[0],translations[0]);
+   double const fusion_apply_ns = ns_per_item(num_items,[&]{
+      for ( std::size_t n = 0; n < num_items; ++n){
+         fusion_result[n] = as_vect3d(quan::fusion::make_row_matrix(points[n]) * fusion_mx);
+      }
+   });
+   double const affine_apply_ns = ns_per_item(num_items,[&]{
+      for ( std::size_t n = 0; n < num_items; ++n){
+         affine_result[n] = affine_mx(points[n]);
+      }
+   });
+   report("apply",fusion_apply_ns,affine_apply_ns,max_difference(fusion_result,affine_result));
+
+   point_arrays matrix_solve{num_items};
+   point_arrays affine_solve{num_items};
+   double const matrix_ns = ns_per_item(num_items,[&]{
+      trilaterate_batch_calc<matrix_calc>(triples.soa(),matrix_solve.soa(),matrix_solve.status.data());
+   });
+   double const affine_ns = ns_per_item(num_items,[&]{
+      trilaterate_batch_calc<affine_calc>(triples.soa(),affine_solve.soa(),affine_solve.status.data());
+   });
+   auto max_diff = 0_km;
+   for ( std::size_t n = 0; n < num_items; ++n){
+      if ( (matrix_solve.status[n] == trilaterate_status::solved) && (affine_solve.status[n] == trilaterate_status::solved)){
+         auto const diff = magnitude(matrix_solve.get(n) - affine_solve.get(n));
+         if ( diff > max_diff){
+            max_diff = diff;
+         }
+      }
+   }
+   report("solve",matrix_ns,affine_ns,max_diff);
+}
@@ -0,0 +1,320 @@
+/*
+  fails if a steady state solve path allocates from the heap
+
+  replaces the global operator new to count allocations, runs each path once to warm up
+  ( first use of thread local metrics, growing the batches of the async solver etc)
+  then again counting, and reports the allocations of each
+
+  paths
+     trilaterate with each calc, on triples failing each test of trilaterate_verify and ll_trilaterate
+     trilaterate_batch and trilaterate_batch_simd with their results in a solve_arena
+     multilaterate_batch with its results in a solve_arena, anchor_constellation::solve_batch
+     multilaterate_tdoa, and multilaterate_tdoa_batch with its results in a solve_arena
+     trilaterate_ring_stage with its arrays in a solve_arena
+     async_trilaterate_solver on the executor thread and on a worker
+
+  built with TRILATERATE_METRICS, so recording the metrics is checked too
+
+  usage : trilaterate_alloc_check.exe
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <new>
+
+#include "trilaterate_async.hpp"
+#include "trilaterate_bench.hpp"
+#include "multilaterate_linear.hpp"
+#include "multilaterate_tdoa.hpp"
+
+namespace {
+
+   std::atomic<bool> counting{false};
+   std::atomic<std::uint64_t> num_allocations{0};
+
+   // not inlined, so gcc does not see the operators pair malloc with delete
+   __attribute__((noinline)) void * counted_alloc(std::size_t size, std::size_t alignment)
+   {
+      if ( counting.load(std::memory_order_relaxed)){
+         num_allocations.fetch_add(1,std::memory_order_relaxed);
+      }
+      size = (size == 0) ? 1 : size;
+      if ( alignment <= alignof(std::max_align_t)){
+         return std::malloc(size);
+      }
+      return std::aligned_alloc(alignment,(size + alignment - 1) / alignment * alignment);
+   }
+
+   __attribute__((noinline)) void counted_free(void * p)
+   {
+      std::free(p);
+   }
+}
+
+void * operator new(std::size_t size)
+{
+   if ( void * const p = counted_alloc(size,0)){
+      return p;
+   }
+   throw std::bad_alloc{};
+}
+
+void * operator new[](std::size_t size) { return ::operator new(size);}
+void * operator new(std::size_t size, std::nothrow_t const &) noexcept { return counted_alloc(size,0);}
+void * operator new[](std::size_t size, std::nothrow_t const &) noexcept { return counted_alloc(size,0);}
+
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+   if ( void * const p = counted_alloc(size,static_cast<std::size_t>(alignment))){
+      return p;
+   }
+   throw std::bad_alloc{};
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment) { return ::operator new(size,alignment);}
+
+void operator delete(void * p) noexcept { counted_free(p);}
+void operator delete[](void * p) noexcept { counted_free(p);}
+void operator delete(void * p, std::size_t) noexcept { counted_free(p);}
+void operator delete[](void * p, std::size_t) noexcept { counted_free(p);}
+void operator delete(void * p, std::align_val_t) noexcept { counted_free(p);}
+void operator delete[](void * p, std::align_val_t) noexcept { counted_free(p);}
+void operator delete(void * p, std::size_t, std::align_val_t) noexcept { counted_free(p);}
+void operator delete[](void * p, std::size_t, std::align_val_t) noexcept { counted_free(p);}
+
+namespace {
+
+   // allocations made by f()
+   template <typename F>
+   std::uint64_t allocations(F f)
+   {
+      num_allocations.store(0);
+      counting.store(true);
+      f();
+      counting.store(false);
+      return num_allocations.load();
+   }
+
+   bool report(char const * name, std::size_t num_solves, std::uint64_t num)
+   {
+      std::cout << "   " << name << " : solves = " << num_solves << ", allocations = " << num << (num > 0 ? "  FAIL" : "") << '\n';
+      return num == 0;
+   }
+
+   // warm up f, then count its allocations
+   template <typename F>
+   bool check(char const * name, std::size_t num_solves, F f)
+   {
+      f();
+      return report(name,num_solves,allocations(f));
+   }
+
+   // the statuses of make_status_triples, each calc must give every one
+   constexpr trilaterate_status status_triple_statuses[] = {
+      trilaterate_status::solved,
+      trilaterate_status::coincident_AB, trilaterate_status::no_intersection_AB,
+      trilaterate_status::coincident_BC, trilaterate_status::no_intersection_BC,
+      trilaterate_status::coincident_AC, trilaterate_status::no_intersection_AC,
+      trilaterate_status::degenerate_C, trilaterate_status::negative_z_squared
+   };
+
+   // a triple failing each test, then solved triples
+   std::vector<std::array<sphere,3> > make_status_triples()
+   {
+      auto s = [](double x, double y, double z, double r){
+         return sphere{{quan::length::km{x},quan::length::km{y},quan::length::km{z}},quan::length::km{r}};
+      };
+      std::vector<std::array<sphere,3> > result = {
+         {{s(0,0,0,5),s(0,0,0,5),s(0,8,0,5)}},        // coincident_AB
+         {{s(0,0,0,1),s(9,0,0,1),s(0,8,0,5)}},        // no_intersection_AB
+         {{s(0,0,0,5),s(6,0,0,5),s(6,0,0,5)}},        // coincident_BC
+         {{s(0,0,0,5),s(6,0,0,5),s(20,0,0,1)}},       // no_intersection_BC
+         {{s(0,0,0,5),s(6,0,0,5),s(0,0,0,6)}},        // coincident_AC
+         {{s(0,0,0,1),s(4,0,0,5),s(0,7,0,5)}},        // no_intersection_AC
+         {{s(0,0,0,5),s(6,0,0,5),s(3,0,0,5)}},        // degenerate_C
+         {{s(0,0,0,5),s(6,0,0,5),s(3,7.9,0,3.5)}},    // negative_z_squared
+      };
+      auto const triples = make_random_triples(24,3,20_km,0.5_km);
+      for ( std::size_t n = 0; n < triples.size(); ++n){
+         result.push_back({{triples.get(0,n),triples.get(1,n),triples.get(2,n)}});
+      }
+      return result;
+   }
+
+   template <typename Calc>
+   bool check_calc(std::vector<std::array<sphere,3> > const & triples)
+   {
+      std::size_t status_count[num_trilaterate_status] = {};
+      std::size_t message_length = 0;
+      bool success = check(Calc::name,triples.size(),[&]{
+         // counts from the last run only
+         std::fill(std::begin(status_count),std::end(status_count),0);
+         for ( auto const & t : triples){
+            point p;
+            trilaterate_status const status = trilaterate<Calc>(t[0],t[1],t[2],p);
+            ++status_count[static_cast<int>(status)];
+            message_length += std::strlen(trilaterate_status_message(status));
+         }
+      });
+      std::cout << "      statuses";
+      for ( int s = 0; s < num_trilaterate_status; ++s){
+         if ( status_count[s] > 0){
+            std::cout << ' ' << trilaterate_status_name(static_cast<trilaterate_status>(s)) << " = " << status_count[s];
+         }
+      }
+      std::cout << '\n';
+      for ( auto status : status_triple_statuses){
+         if ( status_count[static_cast<int>(status)] == 0){
+            std::cout << "      no " << trilaterate_status_name(status) << "  FAIL\n";
+            success = false;
+         }
+      }
+      return success;
+   }
+
+   async_task track(async_trilaterate_solver<> & solver, sphere_triple_arrays const & triples, std::size_t first, std::size_t num_fixes,
+      std::uint64_t & num_solved)
+   {
+      for ( std::size_t f = 0; f < num_fixes; ++f){
+         std::size_t const n = (first + f) % triples.size();
+         trilaterate_fix const fix = co_await solver.trilaterate(triples.get(0,n),triples.get(1,n),triples.get(2,n));
+         num_solved += fix.status == trilaterate_status::solved;
+      }
+   }
+
+   // the coroutine frames are allocated when the tasks are started, so only running them is counted
+   // the first round warms up the thread local metrics of the worker
+   bool check_async(char const * name, unsigned num_workers, sphere_triple_arrays const & triples)
+   {
+      std::size_t constexpr num_tasks = 1000;
+      std::size_t constexpr num_fixes = 20;
+      single_thread_executor executor;
+      async_trilaterate_solver<> solver{executor,num_workers,64};
+      // at worst a batch for each coroutine, how many are in flight at once depends on the thread timing
+      executor.reserve(num_tasks);
+      solver.reserve(num_tasks);
+      std::uint64_t num_solved = 0;
+      std::uint64_t num = 0;
+      for ( int round = 0; round < 2; ++round){
+         for ( std::size_t t = 0; t < num_tasks; ++t){
+            track(solver,triples,t * 13,num_fixes,num_solved);
+         }
+         num = allocations([&]{ executor.run();});
+      }
+      return report(name,num_tasks * num_fixes,num);
+   }
+}
+
+int main()
+{
+   std::size_t constexpr num_triples = 4096;
+   auto const triples = make_random_triples(num_triples,5,20_km,0.01_km);
+   alignas(64) static unsigned char buffer[1 << 20];
+   solve_arena arena{buffer,sizeof buffer};
+   bool success = true;
+
+   std::cout << "trilaterate\n";
+   auto const status_triples = make_status_triples();
+   success = check_calc<matrix_calc>(status_triples) && success;
+   success = check_calc<affine_calc>(status_triples) && success;
+   success = check_calc<vect_calc>(status_triples) && success;
+   success = check_calc<basis_calc>(status_triples) && success;
+   success = check_calc<quaternion_calc>(status_triples) && success;
+
+   std::cout << "batch\n";
+   success = check("trilaterate_batch",num_triples,[&]{
+      arena.reset();
+      trilaterate_batch_result result;
+      trilaterate_batch(triples.soa(),arena,result);
+   }) && success;
+   for ( auto level : {simd_level::scalar, simd_level::avx2, simd_level::avx512}){
+      if ( level > cpu_simd_level()){
+         continue;
+      }
+      success = check(simd_level_name(level),num_triples,[&]{
+         arena.reset();
+         trilaterate_batch_result result;
+         trilaterate_batch_simd(triples.soa(),arena,result,level);
+      }) && success;
+   }
+
+   std::cout << "N anchors\n";
+   std::size_t constexpr num_anchors = 6;
+   std::size_t constexpr num_sets = 1000;
+   std::vector<sphere> sets(num_anchors * num_sets);
+   std::vector<quan::length::km> radii(sets.size());
+   std::vector<point> anchors(num_anchors);
+   {
+      auto const anchor_triples = make_random_triples(2,9);
+      for ( std::size_t a = 0; a < num_anchors; ++a){
+         anchors[a] = anchor_triples.get(a % 3,a / 3).centre;
+      }
+      for ( std::size_t n = 0; n < num_sets; ++n){
+         point const tag = triples.tag[n];
+         for ( std::size_t a = 0; a < num_anchors; ++a){
+            radii[n * num_anchors + a] = magnitude(tag - anchors[a]);
+            sets[n * num_anchors + a] = sphere{anchors[a],radii[n * num_anchors + a]};
+         }
+      }
+   }
+   success = check("multilaterate_batch",num_sets,[&]{
+      arena.reset();
+      multilaterate_batch_result result;
+      multilaterate_batch(sets.data(),num_anchors,num_sets,arena,result);
+   }) && success;
+   anchor_constellation const constellation{anchors.data(),num_anchors};
+   success = check("anchor_constellation::solve_batch",num_sets,[&]{
+      arena.reset();
+      point_soa out;
+      allocate_point_soa(arena,num_sets,out);
+      constellation.solve_batch(radii.data(),num_sets,out);
+   }) && success;
+
+   std::vector<quan::length::km> range_differences(num_sets * (num_anchors - 1));
+   for ( std::size_t n = 0; n < num_sets; ++n){
+      for ( std::size_t a = 1; a < num_anchors; ++a){
+         range_differences[n * (num_anchors - 1) + a - 1] = radii[n * num_anchors + a] - radii[n * num_anchors];
+      }
+   }
+   success = check("multilaterate_tdoa",num_sets,[&]{
+      for ( std::size_t n = 0; n < num_sets; ++n){
+         multilaterate_result result;
+         multilaterate_tdoa(anchors.data(),num_anchors,range_differences.data() + n * (num_anchors - 1),result);
+      }
+   }) && success;
+   tdoa_constellation const tdoa{anchors.data(),num_anchors};
+   success = tdoa.is_valid() && check("multilaterate_tdoa_batch",num_sets,[&]{
+      arena.reset();
+      trilaterate_batch_result result;
+      multilaterate_tdoa_batch(tdoa,range_differences.data(),num_sets,arena,result);
+   }) && success;
+
+   std::cout << "pipeline\n";
+   {
+      spsc_ring<measurement_record> in{1024};
+      spsc_ring<position_record> out{1024};
+      arena.reset();
+      trilaterate_ring_stage<spsc_ring<measurement_record>,spsc_ring<position_record> > stage{in,out,arena};
+      std::vector<position_record> positions(256);
+      success = stage.is_valid() && check("trilaterate_ring_stage",num_triples,[&]{
+         for ( std::size_t n = 0; n < num_triples; ++n){
+            measurement_record const record{n,{triples.get(0,n),triples.get(1,n),triples.get(2,n)}};
+            while ( !in.try_push(record)){
+               stage.run_once();
+               while ( out.try_pop(positions.data(),positions.size()) > 0){}
+            }
+         }
+         while ( stage.run_once() > 0){}
+         while ( out.try_pop(positions.data(),positions.size()) > 0){}
+      }) && success;
+   }
+   success = check_async("async_trilaterate_solver, no workers",0,triples) && success;
+   success = check_async("async_trilaterate_solver, 1 worker",1,triples) && success;
+
+   std::cout << (success ? "no allocations\n" : "FAILED\n");
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,169 @@
+#ifndef TRILATERATION_TRILATERATE_ARENA_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_ARENA_HPP_INCLUDED
+
+/*
+  caller supplied memory for the scratch and results of the solvers, so a solve never goes to the heap
+
+     alignas(64) static unsigned char buffer[1 << 20];
+     solve_arena arena{buffer,sizeof buffer};
+     trilaterate_batch_result result;
+     if ( trilaterate_batch_simd(triples,arena,result)){ ... result.positions.x[n] ... result.status[n] ...}
+     arena.reset();      // before the next batch
+
+  solve_arena hands out blocks of its buffer in order, aligned to a cache line, and only frees them all at once by reset.
+  once the buffer is used up allocate returns nullptr, it never throws or falls back to the heap
+  ( std::pmr::monotonic_buffer_resource would need gcc 9 and falls back to its upstream resource)
+
+  measurement_record_solver and trilaterate_ring_stage ( trilaterate_ring.hpp) also take an arena for their arrays.
+  trilaterate_alloc_check.exe counts the heap allocations of each steady state solve path and fails on any
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "multilaterate.hpp"
+#include "trilaterate_simd.hpp"
+
+namespace {
+
+   class solve_arena{
+   public:
+      static constexpr std::size_t alignment = 64;
+
+      solve_arena(void * buffer, std::size_t size)
+      : m_begin{static_cast<unsigned char *>(buffer)}, m_size{size}, m_used{0}{}
+
+      solve_arena(solve_arena const &) = delete;
+      solve_arena& operator = (solve_arena const &) = delete;
+
+      // n default constructed T, or nullptr if there is not room
+      template <typename T>
+      T * allocate(std::size_t n)
+      {
+         static_assert(std::is_trivially_destructible<T>::value,"the arena doesnt destroy what it holds");
+         static_assert(alignof(T) <= alignment,"T is aligned more than a cache line");
+         std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(m_begin + m_used);
+         std::size_t const padding = (alignment - address % alignment) % alignment;
+         if ( (m_size - m_used) < padding || ((m_size - m_used - padding) / sizeof(T)) < n){
+            return nullptr;
+         }
+         T * const result = reinterpret_cast<T *>(m_begin + m_used + padding);
+         for ( std::size_t i = 0; i < n; ++i){
+            ::new (static_cast<void *>(result + i)) T;
+         }
+         m_used += padding + n * sizeof(T);
+         return result;
+      }
+
+      // everything allocated is free again
+      void reset() { m_used = 0;}
+
+      std::size_t size() const { return m_size;}
+      std::size_t size_used() const { return m_used;}
+
+      // the most bytes of arena that allocate<T>(n) can use
+      template <typename T>
+      static constexpr std::size_t size_for(std::size_t n) { return n * sizeof(T) + alignment - 1;}
+
+   private:
+      unsigned char * const m_begin;
+      std::size_t const m_size;
+      std::size_t m_used;
+   };
+
+   // points out of an arena, false if there is not room
+   template <typename Length>
+   inline bool allocate_point_soa(solve_arena & arena, std::size_t n, basic_point_soa<Length> & out)
+   {
+      out.x = arena.allocate<Length>(n);
+      out.y = arena.allocate<Length>(n);
+      out.z = arena.allocate<Length>(n);
+      return (out.x != nullptr) && (out.y != nullptr) && (out.z != nullptr);
+   }
+
+   template <typename Length>
+   struct basic_trilaterate_batch_result{
+      std::size_t size;
+      basic_point_soa<Length> positions;   // only valid where solved
+      trilaterate_status * status;
+      std::size_t num_solved;
+   };
+
+   typedef basic_trilaterate_batch_result<quan::length::km> trilaterate_batch_result;
+
+   // the most bytes of arena used by a batch result of n
+   template <typename Length>
+   constexpr std::size_t trilaterate_batch_arena_size(std::size_t n)
+   {
+      return 3 * solve_arena::size_for<Length>(n) + solve_arena::size_for<trilaterate_status>(n);
+   }
+
+   template <typename Length>
+   inline bool allocate_batch_result(solve_arena & arena, std::size_t n, basic_trilaterate_batch_result<Length> & result)
+   {
+      result.size = n;
+      result.num_solved = 0;
+      result.status = arena.allocate<trilaterate_status>(n);
+      return allocate_point_soa(arena,n,result.positions) && (result.status != nullptr);
+   }
+
+   // trilaterate_batch with the results in arena
+   // returns false, solving nothing, if there is not room
+   template <typename Length>
+   inline bool trilaterate_batch(basic_sphere_triple_soa<Length> const & in, solve_arena & arena,
+      basic_trilaterate_batch_result<Length> & result)
+   {
+      if ( !allocate_batch_result(arena,in.size,result)){
+         return false;
+      }
+      result.num_solved = trilaterate_batch(in,result.positions,result.status);
+      return true;
+   }
+
+   // trilaterate_batch_simd with the results in arena
+   // returns false, solving nothing, if there is not room
+   template <typename Length>
+   inline bool trilaterate_batch_simd(basic_sphere_triple_soa<Length> const & in, solve_arena & arena,
+      basic_trilaterate_batch_result<Length> & result, simd_level level = cpu_simd_level())
+   {
+      if ( !allocate_batch_result(arena,in.size,result)){
+         return false;
+      }
+      result.num_solved = trilaterate_batch_simd(in,result.positions,result.status,level);
+      return true;
+   }
+
+   struct multilaterate_batch_result{
+      std::size_t size;
+      multilaterate_result * results;
+      trilaterate_status * status;
+      std::size_t num_solved;
+   };
+
+   constexpr std::size_t multilaterate_batch_arena_size(std::size_t num_sets)
+   {
+      return solve_arena::size_for<multilaterate_result>(num_sets) + solve_arena::size_for<trilaterate_status>(num_sets);
+   }
+
+   // multilaterate_batch with the results in arena
+   // returns false, solving nothing, if there is not room
+   inline bool multilaterate_batch(sphere const * spheres, std::size_t num_spheres, std::size_t num_sets,
+      solve_arena & arena, multilaterate_batch_result & result,
+      multilaterate_options const & options = multilaterate_options{})
+   {
+      result.size = num_sets;
+      result.num_solved = 0;
+      result.results = arena.allocate<multilaterate_result>(num_sets);
+      result.status = arena.allocate<trilaterate_status>(num_sets);
+      if ( (result.results == nullptr) || (result.status == nullptr)){
+         return false;
+      }
+      result.num_solved = multilaterate_batch(spheres,num_spheres,num_sets,result.results,result.status,options);
+      return true;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_ARENA_HPP_INCLUDED
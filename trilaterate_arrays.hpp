@@ -0,0 +1,104 @@
+#ifndef TRILATERATION_TRILATERATE_ARRAYS_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_ARRAYS_HPP_INCLUDED
+
+/*
+  vectors owning the arrays behind the batch views, and random sphere triples to fill them
+  used by the benchmarks and by trilaterate_dispatcher::auto_tune for its calibration batch
+*/
+
+#include <random>
+#include <vector>
+
+#include "trilaterate_batch.hpp"
+
+namespace {
+
+   // owns the arrays behind a sphere_triple_soa
+   template <typename Length>
+   struct basic_sphere_triple_arrays{
+
+      explicit basic_sphere_triple_arrays(std::size_t n)
+      : x(12,std::vector<Length>(n)),tag(n){}
+
+      // the same triples converted to another value type
+      template <typename Length1>
+      explicit basic_sphere_triple_arrays(basic_sphere_triple_arrays<Length1> const & in)
+      : x(12,std::vector<Length>(in.size())),tag(in.tag)
+      {
+         for ( int i = 0; i < 12; ++i){
+            for ( std::size_t n = 0; n < in.size(); ++n){
+               x[i][n] = Length{static_cast<typename Length::value_type>(in.x[i][n].numeric_value())};
+            }
+         }
+      }
+
+      std::size_t size() const { return tag.size();}
+
+      basic_sphere_soa<Length> sphere_view(int s) const
+      {
+         return {x[4*s].data(),x[4*s+1].data(),x[4*s+2].data(),x[4*s+3].data()};
+      }
+
+      basic_sphere_triple_soa<Length> soa() const
+      {
+         return {size(),sphere_view(0),sphere_view(1),sphere_view(2)};
+      }
+
+      quan::three_d::sphere<Length> get(int s, std::size_t n) const { return get_sphere(sphere_view(s),n);}
+
+      void set(int s, std::size_t n, quan::three_d::sphere<Length> const & in)
+      {
+         x[4*s][n] = in.centre.x;
+         x[4*s+1][n] = in.centre.y;
+         x[4*s+2][n] = in.centre.z;
+         x[4*s+3][n] = in.radius;
+      }
+
+      // ax,ay,az,ar, bx .. cr
+      std::vector<std::vector<Length> > x;
+      // the point the ranges were measured from
+      std::vector<point> tag;
+   };
+
+   template <typename Length>
+   struct basic_point_arrays{
+      explicit basic_point_arrays(std::size_t n) : x(n),y(n),z(n),status(n){}
+      basic_point_soa<Length> soa() { return {x.data(),y.data(),z.data()};}
+      quan::three_d::vect<Length> get(std::size_t n) const { return {x[n],y[n],z[n]};}
+      std::vector<Length> x;
+      std::vector<Length> y;
+      std::vector<Length> z;
+      std::vector<trilaterate_status> status;
+   };
+
+   typedef basic_sphere_triple_arrays<quan::length::km> sphere_triple_arrays;
+   typedef basic_point_arrays<quan::length::km> point_arrays;
+
+   /*
+     anchors uniformly in a cube of side extent
+     tag uniformly in the same cube, 
+     ranges are the exact distances from the tag plus uniform noise of +- noise 
+   */
+   inline sphere_triple_arrays make_random_triples(std::size_t n, unsigned seed = 1,
+      quan::length::km const & extent = 20_km, quan::length::km const & noise = 0_km)
+   {
+      std::mt19937_64 gen{seed};
+      std::uniform_real_distribution<double> pos{0.0,extent.numeric_value()};
+      std::uniform_real_distribution<double> err{-noise.numeric_value(),noise.numeric_value()};
+      auto random_point = [&]{ return point{quan::length::km{pos(gen)},quan::length::km{pos(gen)},quan::length::km{pos(gen)}};};
+
+      sphere_triple_arrays result{n};
+      for ( std::size_t i = 0; i < n; ++i){
+         point const tag = random_point();
+         result.tag[i] = tag;
+         for ( int s = 0; s < 3; ++s){
+            point const centre = random_point();
+            result.set(s,i,sphere{centre,magnitude(tag - centre) + quan::length::km{err(gen)}});
+         }
+      }
+      return result;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_ARRAYS_HPP_INCLUDED
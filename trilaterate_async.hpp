@@ -0,0 +1,363 @@
+#ifndef TRILATERATION_TRILATERATE_ASYNC_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_ASYNC_HPP_INCLUDED
+
+/*
+  co_await a position fix, C++20 coroutines
+
+     single_thread_executor executor;
+     async_trilaterate_solver<> solver{executor,2};
+
+     async_task track(async_trilaterate_solver<> & solver, ...)
+     {
+        for (;;){
+           trilaterate_fix const fix = co_await solver.trilaterate(A,B,C);
+           if ( fix.status == trilaterate_status::solved){ ... fix.position ...}
+        }
+     }
+
+     track(solver, ...);   // as many as wanted, each is a coroutine frame, not a thread
+     executor.run();
+
+  the requests made by all coroutines in one turn of the executor go in the same batch,
+  which is handed to a worker thread when it has max_batch requests, or when the executor has nothing left to run.
+  a worker solves the batch with measurement_record_solver ( trilaterate_ring.hpp) and posts the coroutines
+  back to the executor, which resumes them on its own thread. with no workers the batch is solved on the executor thread,
+  which is deterministic, for tests.
+
+  the executor of a gateway can be used instead of single_thread_executor if it has the same
+  work_started, post_finished and on_idle members
+
+  batches are reused, so once the number in flight is steady nothing is allocated per fix.
+  reserve on the executor and the solver allocates up front for a known number in flight
+*/
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "trilaterate_ring.hpp"
+
+namespace {
+
+   // a coroutine started by calling it, which frees itself when done
+   struct async_task{
+      struct promise_type{
+         async_task get_return_object() { return {};}
+         std::suspend_never initial_suspend() noexcept { return {};}
+         std::suspend_never final_suspend() noexcept { return {};}
+         void return_void() {}
+         void unhandled_exception() { std::terminate();}
+      };
+   };
+
+   /*
+     runs coroutines on the thread calling run
+     run returns once nothing is ready and no work started is waiting to finish
+   */
+   class single_thread_executor{
+   public:
+      single_thread_executor() : m_num_working{0}{}
+
+      single_thread_executor(single_thread_executor const &) = delete;
+      single_thread_executor& operator = (single_thread_executor const &) = delete;
+
+      // any thread, resume h on the executor thread
+      void post(std::coroutine_handle<> h)
+      {
+         post_finished(&h,1,0);
+      }
+
+      // executor thread, num coroutines have suspended for work on another thread
+      void work_started(std::size_t num)
+      {
+         std::lock_guard<std::mutex> lock{m_mutex};
+         m_num_working += num;
+      }
+
+      // any thread, resume num coroutines whose work has finished
+      void post_finished(std::coroutine_handle<> const * handles, std::size_t num)
+      {
+         post_finished(handles,num,num);
+      }
+
+      // room for num coroutines to be ready at once without allocating
+      void reserve(std::size_t num)
+      {
+         std::lock_guard<std::mutex> lock{m_mutex};
+         m_ready.reserve(num);
+         m_running.reserve(num);
+      }
+
+      // fn(context) is called on the executor thread each time nothing is ready to run
+      void on_idle(void (*fn)(void *), void * context)
+      {
+         m_idle.push_back({fn,context});
+      }
+
+      void run()
+      {
+         for (;;){
+            {
+               std::lock_guard<std::mutex> lock{m_mutex};
+               m_running.swap(m_ready);
+            }
+            if ( !m_running.empty()){
+               for ( auto h : m_running){
+                  h.resume();
+               }
+               m_running.clear();
+               continue;
+            }
+            for ( auto const & idle : m_idle){
+               idle.fn(idle.context);
+            }
+            std::unique_lock<std::mutex> lock{m_mutex};
+            if ( m_ready.empty() && (m_num_working == 0)){
+               return;
+            }
+            m_cv.wait(lock,[this]{ return !m_ready.empty();});
+         }
+      }
+
+   private:
+
+      void post_finished(std::coroutine_handle<> const * handles, std::size_t num, std::size_t num_finished)
+      {
+         {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_ready.insert(m_ready.end(),handles,handles + num);
+            m_num_working -= num_finished;
+         }
+         m_cv.notify_one();
+      }
+
+      struct idle_fn{
+         void (*fn)(void *);
+         void * context;
+      };
+
+      std::mutex m_mutex;
+      std::condition_variable m_cv;
+      std::vector<std::coroutine_handle<> > m_ready;
+      // swapped with m_ready, so both keep their capacity
+      std::vector<std::coroutine_handle<> > m_running;
+      std::size_t m_num_working;
+      std::vector<idle_fn> m_idle;
+   };
+
+   struct trilaterate_fix{
+      point position;              // valid if status is solved
+      trilaterate_status status;
+   };
+
+   template <typename Executor = single_thread_executor>
+   class async_trilaterate_solver{
+
+      struct batch{
+         explicit batch(std::size_t max_batch) : next{nullptr}, size{0}, records(max_batch), positions(max_batch), handles(max_batch), fixes(max_batch){}
+         // in the queue or the free list
+         batch * next;
+         std::size_t size;
+         std::vector<measurement_record> records;
+         std::vector<position_record> positions;
+         std::vector<std::coroutine_handle<> > handles;
+         std::vector<trilaterate_fix *> fixes;
+      };
+
+   public:
+
+      class awaiter{
+      public:
+         awaiter(async_trilaterate_solver & solver, sphere const & A, sphere const & B, sphere const & C)
+         : m_solver(solver), m_spheres{A,B,C}{}
+
+         bool await_ready() const noexcept { return false;}
+
+         void await_suspend(std::coroutine_handle<> h)
+         {
+            m_solver.add(m_spheres,h,&m_fix);
+         }
+
+         trilaterate_fix await_resume() const noexcept { return m_fix;}
+
+      private:
+         async_trilaterate_solver & m_solver;
+         sphere m_spheres[3];
+         trilaterate_fix m_fix;
+      };
+
+      // solves on num_workers threads, or on the executor thread if num_workers is 0
+      explicit async_trilaterate_solver(Executor & executor, unsigned num_workers = 1, std::size_t max_batch = 256)
+      : m_executor(executor), m_max_batch{max_batch}, m_current{nullptr}, m_inline_solver{max_batch}
+      , m_queue_front{nullptr}, m_queue_back{nullptr}, m_free{nullptr}
+      , m_stop{false}, m_num_fixes{0}, m_num_batches{0}
+      {
+         m_executor.on_idle(&async_trilaterate_solver::flush_idle,this);
+         for ( unsigned t = 0; t < num_workers; ++t){
+            m_workers.emplace_back([this]{ worker();});
+         }
+      }
+
+      async_trilaterate_solver(async_trilaterate_solver const &) = delete;
+      async_trilaterate_solver& operator = (async_trilaterate_solver const &) = delete;
+
+      // after the executor has finished running
+      ~async_trilaterate_solver()
+      {
+         {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+         }
+         m_cv.notify_all();
+         for ( auto & t : m_workers){
+            t.join();
+         }
+      }
+
+      awaiter trilaterate(sphere const & A, sphere const & B, sphere const & C)
+      {
+         return awaiter{*this,A,B,C};
+      }
+
+      // allocate num_batches batches now rather than as the number in flight grows, executor thread
+      void reserve(std::size_t num_batches)
+      {
+         while ( m_batches.size() < num_batches){
+            m_batches.emplace_back(new batch{m_max_batch});
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_batches.back()->next = m_free;
+            m_free = m_batches.back().get();
+         }
+      }
+
+      // hand the requests made so far to a worker, executor thread
+      void flush()
+      {
+         batch * const b = m_current;
+         if ( b == nullptr){
+            return;
+         }
+         m_current = nullptr;
+         m_executor.work_started(b->size);
+         m_num_fixes += b->size;
+         ++m_num_batches;
+         if ( m_workers.empty()){
+            solve(*b,m_inline_solver);
+            return;
+         }
+         {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if ( m_queue_back == nullptr){
+               m_queue_front = b;
+            }else{
+               m_queue_back->next = b;
+            }
+            m_queue_back = b;
+         }
+         m_cv.notify_one();
+      }
+
+      // executor thread
+      std::uint64_t num_fixes() const { return m_num_fixes;}
+      std::uint64_t num_batches() const { return m_num_batches;}
+
+   private:
+
+      void add(sphere const (&spheres)[3], std::coroutine_handle<> h, trilaterate_fix * fix)
+      {
+         if ( m_current == nullptr){
+            m_current = get_batch();
+         }
+         batch & b = *m_current;
+         std::size_t const n = b.size++;
+         b.records[n].id = n;
+         for ( int s = 0; s < 3; ++s){
+            b.records[n].spheres[s] = spheres[s];
+         }
+         b.handles[n] = h;
+         b.fixes[n] = fix;
+         if ( b.size == m_max_batch){
+            flush();
+         }
+      }
+
+      static void flush_idle(void * solver)
+      {
+         static_cast<async_trilaterate_solver *>(solver)->flush();
+      }
+
+      batch * get_batch()
+      {
+         {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if ( m_free != nullptr){
+               batch * const b = m_free;
+               m_free = b->next;
+               b->next = nullptr;
+               return b;
+            }
+         }
+         m_batches.emplace_back(new batch{m_max_batch});
+         return m_batches.back().get();
+      }
+
+      void solve(batch & b, measurement_record_solver & solver)
+      {
+         solver.solve(b.records.data(),b.size,b.positions.data());
+         for ( std::size_t n = 0; n < b.size; ++n){
+            *b.fixes[n] = trilaterate_fix{b.positions[n].position,b.positions[n].status};
+         }
+         m_executor.post_finished(b.handles.data(),b.size);
+         b.size = 0;
+         std::lock_guard<std::mutex> lock{m_mutex};
+         b.next = m_free;
+         m_free = &b;
+      }
+
+      void worker()
+      {
+         measurement_record_solver solver{m_max_batch};
+         for (;;){
+            batch * b = nullptr;
+            {
+               std::unique_lock<std::mutex> lock{m_mutex};
+               m_cv.wait(lock,[this]{ return m_stop || (m_queue_front != nullptr);});
+               b = m_queue_front;
+               if ( b == nullptr){
+                  return;
+               }
+               m_queue_front = b->next;
+               if ( m_queue_front == nullptr){
+                  m_queue_back = nullptr;
+               }
+            }
+            solve(*b,solver);
+         }
+      }
+
+      Executor & m_executor;
+      std::size_t const m_max_batch;
+      // executor thread
+      batch * m_current;
+      measurement_record_solver m_inline_solver;
+      std::vector<std::unique_ptr<batch> > m_batches;
+
+      std::mutex m_mutex;
+      std::condition_variable m_cv;
+      // lists through batch::next, so queueing allocates nothing
+      batch * m_queue_front;
+      batch * m_queue_back;
+      batch * m_free;
+      bool m_stop;
+
+      std::vector<std::thread> m_workers;
+      std::uint64_t m_num_fixes;
+      std::uint64_t m_num_batches;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_ASYNC_HPP_INCLUDED
@@ -0,0 +1,88 @@
+/*
+  many coroutines each co_awaiting a stream of fixes from async_trilaterate_solver on a single_thread_executor
+
+  num_tasks coroutines each await fixes_per_task fixes in turn, so num_tasks fixes are in flight at once.
+  run with the batches solved on the executor thread ( no workers), and on 1 and on hardware_concurrency workers.
+  reports fixes/s, the mean batch and mismatches against trilaterate_batch_simd run here on the same triples,
+  and fails on any mismatch
+
+  usage : trilaterate_async_bench.exe [num_tasks] [fixes_per_task]
+     defaults 10000 tasks, 100 fixes each
+*/
+
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_async.hpp"
+#include "trilaterate_bench.hpp"
+
+namespace {
+
+   typedef std::chrono::steady_clock clock;
+
+   struct task_counts{
+      std::uint64_t num_solved = 0;
+      std::uint64_t mismatches = 0;
+   };
+
+   async_task track(async_trilaterate_solver<> & solver, sphere_triple_arrays const & triples, point_arrays const & expected,
+      std::size_t first, std::size_t num_fixes, task_counts & counts)
+   {
+      for ( std::size_t f = 0; f < num_fixes; ++f){
+         std::size_t const n = (first + f) % triples.size();
+         trilaterate_fix const fix = co_await solver.trilaterate(triples.get(0,n),triples.get(1,n),triples.get(2,n));
+         bool const solved = fix.status == trilaterate_status::solved;
+         counts.num_solved += solved;
+         if ( solved != (expected.status[n] == trilaterate_status::solved)){
+            ++counts.mismatches;
+         }else if ( solved && (magnitude(fix.position - expected.get(n)) > epsilon_km)){
+            ++counts.mismatches;
+         }
+      }
+   }
+
+   bool run(unsigned num_workers, sphere_triple_arrays const & triples, point_arrays const & expected,
+      std::size_t num_tasks, std::size_t fixes_per_task)
+   {
+      single_thread_executor executor;
+      async_trilaterate_solver<> solver{executor,num_workers};
+      task_counts counts;
+
+      auto const start = clock::now();
+      for ( std::size_t t = 0; t < num_tasks; ++t){
+         track(solver,triples,expected,t * 7919,fixes_per_task,counts);
+      }
+      executor.run();
+      double const elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+      std::size_t const num_fixes = num_tasks * fixes_per_task;
+      std::cout << "   workers = " << num_workers << " : fixes/s = " << num_fixes / elapsed
+         << ", ns/fix = " << 1e9 * elapsed / num_fixes
+         << ", mean batch = " << static_cast<double>(solver.num_fixes()) / std::max<std::uint64_t>(solver.num_batches(),1)
+         << ", solved = " << counts.num_solved << '/' << num_fixes
+         << ", mismatches = " << counts.mismatches << '\n';
+      return (counts.mismatches == 0) && (solver.num_fixes() == num_fixes);
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_tasks = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 10000;
+   std::size_t const fixes_per_task = (argc > 2) ? std::strtoul(argv[2],nullptr,10) : 100;
+
+   auto const triples = make_random_triples(65536,7);
+   point_arrays expected{triples.size()};
+   double const batch_ns = ns_per_item(triples.size(),[&]{
+      trilaterate_batch_simd(triples.soa(),expected.soa(),expected.status.data());
+   });
+   std::cout << "trilaterate_batch_simd ns/solve = " << batch_ns << '\n';
+   std::cout << num_tasks << " coroutines, " << fixes_per_task << " fixes each\n";
+
+   bool success = run(0,triples,expected,num_tasks,fixes_per_task);
+   success = run(1,triples,expected,num_tasks,fixes_per_task) && success;
+   unsigned const num_threads = std::thread::hardware_concurrency();
+   if ( num_threads > 1){
+      success = run(num_threads,triples,expected,num_tasks,fixes_per_task) && success;
+   }
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
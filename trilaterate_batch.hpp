@@ -0,0 +1,111 @@
+#ifndef TRILATERATION_TRILATERATE_BATCH_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_BATCH_HPP_INCLUDED
+
+/*
+  batch trilateration over structure of arrays
+  no diagnostic output is done in the batch, the status of each triple is recorded in a status array
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+#include "trilaterate.hpp"
+
+namespace {
+
+   // structure of arrays view of sphere triples
+   // every array must hold at least size elements
+   template <typename Length>
+   struct basic_sphere_soa{
+      Length const * x;
+      Length const * y;
+      Length const * z;
+      Length const * radius;
+   };
+
+   template <typename Length>
+   struct basic_sphere_triple_soa{
+      std::size_t size;
+      basic_sphere_soa<Length> A;
+      basic_sphere_soa<Length> B;
+      basic_sphere_soa<Length> C;
+   };
+
+   template <typename Length>
+   struct basic_point_soa{
+      Length * x;
+      Length * y;
+      Length * z;
+   };
+
+   typedef basic_sphere_soa<quan::length::km> sphere_soa;
+   typedef basic_sphere_triple_soa<quan::length::km> sphere_triple_soa;
+   typedef basic_point_soa<quan::length::km> point_soa;
+
+   // elements [begin,end) of in
+   template <typename Length>
+   inline basic_sphere_triple_soa<Length> slice(basic_sphere_triple_soa<Length> const & in, std::size_t begin, std::size_t end)
+   {
+      auto slice_spheres = [begin](basic_sphere_soa<Length> const & s){
+         return basic_sphere_soa<Length>{s.x + begin,s.y + begin,s.z + begin,s.radius + begin};
+      };
+      return basic_sphere_triple_soa<Length>{end - begin,slice_spheres(in.A),slice_spheres(in.B),slice_spheres(in.C)};
+   }
+
+   // elements from begin of out
+   template <typename Length>
+   inline basic_point_soa<Length> slice(basic_point_soa<Length> const & out, std::size_t begin)
+   {
+      return basic_point_soa<Length>{out.x + begin,out.y + begin,out.z + begin};
+   }
+
+   template <typename Length>
+   inline quan::three_d::sphere<Length> get_sphere(basic_sphere_soa<Length> const & in, std::size_t n)
+   {
+      return quan::three_d::sphere<Length>{{in.x[n],in.y[n],in.z[n]},in.radius[n]};
+   }
+
+   // trilaterate without diagnostic output
+   // aligns using quan::three_d rotations as the vect calc
+   inline trilaterate_status trilaterate_element(sphere const& A, sphere const & B, sphere const & C,point & out)
+   {
+      null_tracer tracer;
+      auto const status = trilaterate_verify(A,B,C);
+      return ( status == trilaterate_status::solved) ? vect_calc::align_and_solve(A,B,C,out,tracer) : status;
+   }
+
+   // other value types use the basis calc, since the rotations are double only
+   template <typename Length>
+   inline trilaterate_status trilaterate_element(quan::three_d::sphere<Length> const& A, quan::three_d::sphere<Length> const & B, 
+      quan::three_d::sphere<Length> const & C, quan::three_d::vect<Length> & out)
+   {
+      null_tracer tracer;
+      auto const status = trilaterate_verify(A,B,C);
+      return ( status == trilaterate_status::solved) ? basis_calc::align_and_solve(A,B,C,out,tracer) : status;
+   }
+
+   // solve in.size sphere triples
+   // status[n] is set to the trilaterate_status of triple n
+   // out is only written where the triple was solved
+   // returns the number of triples solved
+   template <typename Length>
+   inline std::size_t trilaterate_batch(basic_sphere_triple_soa<Length> const & in, basic_point_soa<Length> const & out, 
+      trilaterate_status * status)
+   {
+      std::size_t num_solved = 0;
+      for ( std::size_t n = 0; n < in.size; ++n){
+         quan::three_d::vect<Length> ip;
+         status[n] = trilaterate_element(get_sphere(in.A,n),get_sphere(in.B,n),get_sphere(in.C,n),ip);
+         if ( status[n] == trilaterate_status::solved){
+            out.x[n] = ip.x;
+            out.y[n] = ip.y;
+            out.z[n] = ip.z;
+            ++num_solved;
+         }
+      }
+      return num_solved;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_BATCH_HPP_INCLUDED
@@ -0,0 +1,61 @@
+/*
+  throughput of trilaterate_batch against calling trilaterate in a loop
+  over the same random sphere triples
+
+  usage : trilaterate_batch_bench.exe [num_triples]
+*/
+
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_triples = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+
+   auto const triples = make_random_triples(num_triples);
+
+   point_arrays scalar_result{num_triples};
+   std::size_t scalar_solved = 0;
+   double const scalar_ns = ns_per_item(num_triples,[&]{
+      for ( std::size_t n = 0; n < num_triples; ++n){
+         point ip;
+         scalar_result.status[n] = trilaterate(triples.get(0,n),triples.get(1,n),triples.get(2,n),ip);
+         if ( scalar_result.status[n] == trilaterate_status::solved){
+            scalar_result.x[n] = ip.x;
+            scalar_result.y[n] = ip.y;
+            scalar_result.z[n] = ip.z;
+            ++scalar_solved;
+         }
+      }
+   });
+
+   point_arrays batch_result{num_triples};
+   std::size_t batch_solved = 0;
+   double const batch_ns = ns_per_item(num_triples,[&]{
+      batch_solved = trilaterate_batch(triples.soa(),batch_result.soa(),batch_result.status.data());
+   });
+
+   auto max_diff = 0_km;
+   std::size_t status_mismatch = 0;
+   for ( std::size_t n = 0; n < num_triples; ++n){
+      if ( scalar_result.status[n] != batch_result.status[n]){
+         ++status_mismatch;
+      }else if ( batch_result.status[n] == trilaterate_status::solved){
+         auto const diff = magnitude(scalar_result.get(n) - batch_result.get(n));
+         if ( diff > max_diff){
+            max_diff = diff;
+         }
+      }
+   }
+
+   std::cout << "triples            = " << num_triples << '\n';
+   std::cout << "scalar ns/solve    = " << scalar_ns << " ( solved " << scalar_solved << ")\n";
+   std::cout << "batch  ns/solve    = " << batch_ns << " ( solved " << batch_solved << ")\n";
+   std::cout << "speedup            = " << scalar_ns / batch_ns << '\n';
+   std::cout << "max difference     = " << max_diff << '\n';
+   std::cout << "status mismatches  = " << status_mismatch << '\n';
+
+   return status_mismatch == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
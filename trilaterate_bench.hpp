@@ -0,0 +1,27 @@
+#ifndef TRILATERATION_TRILATERATE_BENCH_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_BENCH_HPP_INCLUDED
+
+/*
+  timing for the benchmark programs
+  and the arrays and random geometry of trilaterate_arrays.hpp
+*/
+
+#include <chrono>
+
+#include "trilaterate_arrays.hpp"
+
+namespace {
+
+   // time in ns per item for f() run over num_items 
+   template <typename F>
+   inline double ns_per_item(std::size_t num_items, F f)
+   {
+      auto const start = std::chrono::steady_clock::now();
+      f();
+      auto const finish = std::chrono::steady_clock::now();
+      return std::chrono::duration<double,std::nano>(finish - start).count() / num_items;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_BENCH_HPP_INCLUDED
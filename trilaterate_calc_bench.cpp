@@ -0,0 +1,87 @@
+/*
+  time trilaterate with each calc policy, then with the calc chosen by trilaterate_dispatcher::auto_tune
+  then count the failure reasons on noisy ranges
+  
+  reports ns per solve and the worst range residual | |p - centre| - radius | of the solutions
+
+  usage : trilaterate_calc_bench.exe [num_triples]
+*/
+
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_dispatch.hpp"
+
+namespace {
+
+   void report(char const * name, double ns, sphere_triple_arrays const & triples, point_arrays const & result)
+   {
+      std::size_t num_solved = 0;
+      auto max_residual = 0_km;
+      for ( std::size_t n = 0; n < triples.size(); ++n){
+         if ( result.status[n] == trilaterate_status::solved){
+            ++num_solved;
+            for ( int s = 0; s < 3; ++s){
+               sphere const sp = triples.get(s,n);
+               auto const residual = abs(magnitude(result.get(n) - sp.centre) - sp.radius);
+               if ( residual > max_residual){
+                  max_residual = residual;
+               }
+            }
+         }
+      }
+      std::cout << name << " calc : ns/solve = " << ns 
+         << ", solved = " << num_solved << "/" << triples.size() 
+         << ", max range residual = " << max_residual << '\n';
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_triples = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+
+   auto const triples = make_random_triples(num_triples);
+
+   trilaterate_dispatcher dispatcher;
+   for ( auto id : trilaterate_calc_ids){
+      dispatcher.select(id);
+      point_arrays result{num_triples};
+      double const ns = ns_per_item(num_triples,[&]{ dispatcher.batch(triples.soa(),result.soa(),result.status.data());});
+      report(dispatcher.name(),ns,triples,result);
+   }
+
+   dispatcher.auto_tune();
+   std::cout << "\nauto_tune selected " << dispatcher.name() << " (";
+   for ( auto id : trilaterate_calc_ids){
+      std::cout << ' ' << dispatcher.tuned_ns_per_solve(id);
+   }
+   std::cout << " ns/solve )\n";
+
+   // solve through the dispatcher per triple
+   point_arrays result{num_triples};
+   double const ns = ns_per_item(num_triples,[&]{
+      for ( std::size_t n = 0; n < num_triples; ++n){
+         point ip;
+         result.status[n] = dispatcher(triples.get(0,n),triples.get(1,n),triples.get(2,n),ip);
+         if ( result.status[n] == trilaterate_status::solved){
+            result.x[n] = ip.x;
+            result.y[n] = ip.y;
+            result.z[n] = ip.z;
+         }
+      }
+   });
+   report("dispatched",ns,triples,result);
+
+   // failure reasons with noisy ranges
+   auto const noisy_triples = make_random_triples(num_triples,2,20_km,0.5_km);
+   trilaterate_diagnostics diagnostics;
+   double const noisy_ns = ns_per_item(num_triples,[&]{
+      for ( std::size_t n = 0; n < num_triples; ++n){
+         point ip;
+         trilaterate(noisy_triples.get(0,n),noisy_triples.get(1,n),noisy_triples.get(2,n),ip,diagnostics);
+      }
+   });
+   std::cout << "\nranges with +-0.5 km noise, " << default_calc::name << " calc : ns/solve = " << noisy_ns << '\n';
+   diagnostics.print(std::cout);
+}
@@ -0,0 +1,204 @@
+#ifndef TRILATERATION_TRILATERATE_CONSTEXPR_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_CONSTEXPR_HPP_INCLUDED
+
+/*
+  sphere triple with centres known at compile time, as anchors surveyed once and built into firmware
+
+  as prepared_anchor_triple, but the normalised frame, its transform back and the
+  constants of ll_trilaterate are all found by the compiler
+
+     constexpr constexpr_anchor_triple anchors{pA,pB,pC};
+     static_assert(anchors.is_valid(),"anchors are coincident or on one line");
+     auto const status = anchors.trilaterate(rA,rB,rC,p);
+
+  the frame is held as numeric values in km so that it is a constant expression
+  whichever quan functions are constexpr
+
+  the solve is one function templated on the square root.
+  with constexpr_sqrt it is a constant expression, checked by static_assert(anchors.is_trig_free())
+  gcc and clang evaluate atan2, sin and cos as builtins in a constant expression, so the assert
+  only shows the solve is free of them when compiled with -fno-builtin, as the Makefile does
+  the runtime solve is the same function with std::sqrt
+*/
+
+#include <cmath>
+
+#include "trilaterate.hpp"
+
+namespace {
+
+   namespace constexpr_detail{
+
+      struct dvect{
+         double x;
+         double y;
+         double z;
+      };
+
+      constexpr dvect operator+(dvect const & a, dvect const & b) { return {a.x + b.x,a.y + b.y,a.z + b.z};}
+      constexpr dvect operator-(dvect const & a, dvect const & b) { return {a.x - b.x,a.y - b.y,a.z - b.z};}
+      constexpr dvect operator*(double s, dvect const & a) { return {s * a.x,s * a.y,s * a.z};}
+      constexpr double dot_product(dvect const & a, dvect const & b) { return a.x * b.x + a.y * b.y + a.z * b.z;}
+
+      constexpr dvect cross_product(dvect const & a, dvect const & b)
+      {
+         return {a.y * b.z - a.z * b.y,a.z * b.x - a.x * b.z,a.x * b.y - a.y * b.x};
+      }
+
+      constexpr dvect numeric(point const & p)
+      {
+         return {p.x.numeric_value(),p.y.numeric_value(),p.z.numeric_value()};
+      }
+   }
+
+   // Newton's method, correct to the last place or so
+   struct constexpr_sqrt{
+      constexpr double operator()(double v) const
+      {
+         if ( !(v > 0.0)){
+            return 0.0;
+         }
+         double x = (v > 1.0) ? v : 1.0;
+         for ( int n = 0; n < 2048; ++n){
+            double const next = 0.5 * (x + v / x);
+            if ( !(next < x)){
+               break;
+            }
+            x = next;
+         }
+         return x;
+      }
+   };
+
+   struct runtime_sqrt{
+      double operator()(double v) const { return std::sqrt(v);}
+   };
+
+   class constexpr_anchor_triple{
+   public:
+
+      constexpr constexpr_anchor_triple(point const & pA, point const & pB, point const & pC)
+      : m_pA{constexpr_detail::numeric(pA)}
+      , m_pB{constexpr_detail::numeric(pB)}
+      , m_pC{constexpr_detail::numeric(pC)}
+      , m_distAB{magnitude(m_pB - m_pA)}
+      , m_distBC{magnitude(m_pC - m_pB)}
+      , m_distAC{magnitude(m_pC - m_pA)}
+      , m_ex{unit_vector(m_pB - m_pA)}
+      , m_i{constexpr_detail::dot_product(m_ex,m_pC - m_pA)}
+      , m_ey{unit_vector(m_pC - m_pA - m_i * m_ex)}
+      , m_ez{constexpr_detail::cross_product(m_ex,m_ey)}
+      , m_j{constexpr_detail::dot_product(m_ey,m_pC - m_pA)}
+      , m_d_2{m_distAB * m_distAB}
+      , m_i_2_plus_j_2{m_i * m_i + m_j * m_j}
+      , m_recip_2d{is_valid() ? 1.0 / (2.0 * m_distAB) : 0.0}
+      , m_recip_2j{is_valid() ? 1.0 / (2.0 * m_j) : 0.0}
+      , m_i_over_j{is_valid() ? m_i / m_j : 0.0}
+      {}
+
+      // false if any centres are coincident or all are on one line
+      constexpr bool is_valid() const
+      {
+         return (m_distAB >= epsilon_km.numeric_value()) && (m_distBC >= epsilon_km.numeric_value())
+            && (m_distAC >= epsilon_km.numeric_value()) && (m_j >= epsilon_km.numeric_value());
+      }
+
+      // p is only written if solved
+      trilaterate_status trilaterate(quan::length::km const & rA, quan::length::km const & rB, quan::length::km const & rC,
+         point & p) const
+      {
+         double ip[3] = {};
+         auto const status = solve(rA.numeric_value(),rB.numeric_value(),rC.numeric_value(),ip,runtime_sqrt{});
+         if ( status == trilaterate_status::solved){
+            p = point{quan::length::km{ip[0]},quan::length::km{ip[1]},quan::length::km{ip[2]}};
+         }
+         return status;
+      }
+
+      // true if the solve is a constant expression ( called in a static_assert)
+      // the ranges are from a point above the plane of the centres
+      constexpr bool is_trig_free() const
+      {
+         dvect const tag = m_pA + (0.5 * m_distAB) * (m_ex + m_ez) + (0.5 * m_j) * m_ey;
+         double ip[3] = {};
+         return solve(range(tag,m_pA),range(tag,m_pB),range(tag,m_pC),ip,constexpr_sqrt{}) == trilaterate_status::solved;
+      }
+
+      /*
+        the whole runtime solve
+        Sqrt is runtime_sqrt or constexpr_sqrt
+        ip is the intersection point in km
+      */
+      template <typename Sqrt>
+      constexpr trilaterate_status solve(double rA, double rB, double rC, double (&ip)[3], Sqrt sqrt) const
+      {
+         if ( m_distAB >= (rA + rB)){
+            return trilaterate_status::no_intersection_AB;
+         }
+         if ( m_distBC >= (rB + rC)){
+            return trilaterate_status::no_intersection_BC;
+         }
+         if ( m_distAC >= (rA + rC)){
+            return trilaterate_status::no_intersection_AC;
+         }
+         if ( ((m_distAB - rA) >= rB) || (rB >= (m_distAB + rA))){
+            // one of A B is inside the other
+            return trilaterate_status::no_intersection_AB;
+         }
+         double const rA_2 = rA * rA;
+         double const x = (rA_2 - rB * rB + m_d_2) * m_recip_2d;
+         double const y = (rA_2 - rC * rC + m_i_2_plus_j_2) * m_recip_2j - m_i_over_j * x;
+         double const z_2 = rA_2 - x * x - y * y;
+         if ( !(z_2 >= 0.0)){
+            return trilaterate_status::negative_z_squared;
+         }
+         double const z = sqrt(z_2);
+         ip[0] = m_pA.x + x * m_ex.x + y * m_ey.x + z * m_ez.x;
+         ip[1] = m_pA.y + x * m_ex.y + y * m_ey.y + z * m_ez.y;
+         ip[2] = m_pA.z + x * m_ex.z + y * m_ey.z + z * m_ez.z;
+         return trilaterate_status::solved;
+      }
+
+      quan::length::km d() const { return quan::length::km{m_distAB};}
+      quan::length::km i() const { return quan::length::km{m_i};}
+      quan::length::km j() const { return quan::length::km{m_j};}
+
+   private:
+
+      typedef constexpr_detail::dvect dvect;
+
+      static constexpr double magnitude(dvect const & v)
+      {
+         return constexpr_sqrt{}(constexpr_detail::dot_product(v,v));
+      }
+
+      static constexpr dvect unit_vector(dvect const & v)
+      {
+         return (magnitude(v) > 0.0) ? (1.0 / magnitude(v)) * v : v;
+      }
+
+      static constexpr double range(dvect const & from, dvect const & to) { return magnitude(to - from);}
+
+      dvect m_pA;
+      dvect m_pB;
+      dvect m_pC;
+      double m_distAB;
+      double m_distBC;
+      double m_distAC;
+      // rows of the rotation to the normalised frame
+      dvect m_ex;
+      double m_i;
+      dvect m_ey;
+      dvect m_ez;
+      double m_j;
+      // constants of ll_trilaterate
+      double m_d_2;
+      double m_i_2_plus_j_2;
+      double m_recip_2d;
+      double m_recip_2j;
+      double m_i_over_j;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_CONSTEXPR_HPP_INCLUDED
@@ -0,0 +1,90 @@
+/*
+  anchors known at compile time with changing ranges
+  constexpr_anchor_triple against prepared_anchor_triple and calling trilaterate each time
+
+  usage : trilaterate_constexpr_bench.exe [num_solves]
+*/
+
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_constexpr.hpp"
+#include "trilaterate_prepared.hpp"
+
+namespace {
+
+   // the example anchors of trilateration_transform.cpp
+   point constexpr pA{4.3_km, 5_km,6_km};
+   point constexpr pB{13_km, 4.5_km, 5.5_km};
+   point constexpr pC{10_km,11_km,5.6_km};
+
+   constexpr constexpr_anchor_triple anchors{pA,pB,pC};
+   static_assert(anchors.is_valid(),"anchors are coincident or on one line");
+   static_assert(anchors.is_trig_free(),"the solve must be a constant expression, free of trig when built with -fno-builtin");
+
+   void report(char const * name, double ns, point_arrays const & result, point_arrays const & reference)
+   {
+      std::size_t num_solved = 0;
+      auto max_diff = 0_km;
+      for ( std::size_t n = 0; n < result.status.size(); ++n){
+         if ( result.status[n] == trilaterate_status::solved){
+            ++num_solved;
+            auto const diff = magnitude(result.get(n) - reference.get(n));
+            if ( diff > max_diff){
+               max_diff = diff;
+            }
+         }
+      }
+      std::cout << name << " ns/solve = " << ns << ", solved = " << num_solved << "/" << result.status.size()
+         << ", max difference = " << max_diff << '\n';
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_solves = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+
+   // ranges from random tags to the fixed anchors
+   auto triples = make_random_triples(num_solves);
+   for ( std::size_t n = 0; n < num_solves; ++n){
+      point const tag = triples.tag[n];
+      triples.set(0,n,sphere{pA,magnitude(tag - pA)});
+      triples.set(1,n,sphere{pB,magnitude(tag - pB)});
+      triples.set(2,n,sphere{pC,magnitude(tag - pC)});
+   }
+   auto const & ranges = triples.x;
+
+   auto solve_all = [&](point_arrays & result, auto solve){
+      return ns_per_item(num_solves,[&]{
+         for ( std::size_t n = 0; n < num_solves; ++n){
+            point ip;
+            result.status[n] = solve(n,ip);
+            if ( result.status[n] == trilaterate_status::solved){
+               result.x[n] = ip.x;
+               result.y[n] = ip.y;
+               result.z[n] = ip.z;
+            }
+         }
+      });
+   };
+
+   point_arrays reference{num_solves};
+   double const basis_ns = solve_all(reference,[&](std::size_t n, point & ip){
+      return trilaterate<basis_calc>(triples.get(0,n),triples.get(1,n),triples.get(2,n),ip);
+   });
+   report("trilaterate<basis_calc>",basis_ns,reference,reference);
+
+   prepared_anchor_triple const prepared{pA,pB,pC};
+   point_arrays prepared_result{num_solves};
+   double const prepared_ns = solve_all(prepared_result,[&](std::size_t n, point & ip){
+      return prepared.trilaterate(ranges[3][n],ranges[7][n],ranges[11][n],ip);
+   });
+   report("prepared_anchor_triple",prepared_ns,prepared_result,reference);
+
+   point_arrays constexpr_result{num_solves};
+   double const constexpr_ns = solve_all(constexpr_result,[&](std::size_t n, point & ip){
+      return anchors.trilaterate(ranges[3][n],ranges[7][n],ranges[11][n],ip);
+   });
+   report("constexpr_anchor_triple",constexpr_ns,constexpr_result,reference);
+}
@@ -0,0 +1,174 @@
+#ifndef TRILATERATION_TRILATERATE_DISPATCH_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_DISPATCH_HPP_INCLUDED
+
+/*
+  choose the trilaterate calc policy at runtime
+
+  trilaterate_dispatcher holds a function pointer per operation for the selected calc,
+  so a call costs one indirect call and no test of which calc is selected.
+  auto_tune times each calc on a calibration batch and selects the fastest
+
+  for a loop with no indirect call at all, dispatch once outside the loop
+
+     dispatcher.visit([&](auto calc){
+        for ( ...) { trilaterate<decltype(calc)>(A,B,C,p);}
+     });
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "trilaterate_arrays.hpp"
+
+namespace {
+
+   enum class trilaterate_calc_id { matrix, affine, vect, basis, quaternion };
+
+   constexpr trilaterate_calc_id trilaterate_calc_ids[] = {
+      trilaterate_calc_id::matrix, trilaterate_calc_id::affine, trilaterate_calc_id::vect, trilaterate_calc_id::basis,
+      trilaterate_calc_id::quaternion
+   };
+
+   // id of default_calc
+   constexpr trilaterate_calc_id default_calc_id =
+      std::is_same<default_calc,basis_calc>::value ? trilaterate_calc_id::basis :
+      std::is_same<default_calc,quaternion_calc>::value ? trilaterate_calc_id::quaternion :
+      std::is_same<default_calc,vect_calc>::value ? trilaterate_calc_id::vect : 
+      std::is_same<default_calc,affine_calc>::value ? trilaterate_calc_id::affine : 
+         trilaterate_calc_id::matrix;
+
+   // solve in.size sphere triples with trilaterate<Calc>
+   // status and out as for trilaterate_batch
+   template <typename Calc>
+   inline std::size_t trilaterate_batch_calc(sphere_triple_soa const & in, point_soa const & out, trilaterate_status * status)
+   {
+      std::size_t num_solved = 0;
+      for ( std::size_t n = 0; n < in.size; ++n){
+         point ip;
+         status[n] = trilaterate<Calc>(get_sphere(in.A,n),get_sphere(in.B,n),get_sphere(in.C,n),ip);
+         if ( status[n] == trilaterate_status::solved){
+            out.x[n] = ip.x;
+            out.y[n] = ip.y;
+            out.z[n] = ip.z;
+            ++num_solved;
+         }
+      }
+      return num_solved;
+   }
+
+   class trilaterate_dispatcher{
+   public:
+
+      typedef trilaterate_status (*solve_fn)(sphere const& A, sphere const & B, sphere const & C,point & out);
+      typedef std::size_t (*batch_fn)(sphere_triple_soa const & in, point_soa const & out, trilaterate_status * status);
+
+      explicit trilaterate_dispatcher(trilaterate_calc_id id = default_calc_id)
+      {
+         select(id);
+      }
+
+      void select(trilaterate_calc_id id)
+      {
+         m_id = id;
+         visit_id(id,[this](auto calc){
+            typedef decltype(calc) calc_type;
+            m_solve = trilaterate<calc_type>;
+            m_batch = trilaterate_batch_calc<calc_type>;
+            m_name = calc_type::name;
+         });
+      }
+
+      /*
+        time each calc on the calibration triples, best of num_runs
+        and select the fastest
+        the triples should be solvable, since failures return early and make a calc look faster
+      */
+      trilaterate_calc_id auto_tune(sphere_triple_soa const & calibration, int num_runs = 3)
+      {
+         point_arrays result{calibration.size};
+         trilaterate_calc_id fastest = m_id;
+         double fastest_ns = 0.0;
+         for ( auto id : trilaterate_calc_ids){
+            double best_ns = 0.0;
+            visit_id(id,[&](auto calc){
+               for ( int run = 0; run < num_runs; ++run){
+                  auto const start = std::chrono::steady_clock::now();
+                  trilaterate_batch_calc<decltype(calc)>(calibration,result.soa(),result.status.data());
+                  double const ns = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - start).count()
+                     / calibration.size;
+                  best_ns = (run == 0) ? ns : std::min(best_ns,ns);
+               }
+            });
+            m_tuned_ns[static_cast<int>(id)] = best_ns;
+            if ( (id == trilaterate_calc_ids[0]) || (best_ns < fastest_ns)){
+               fastest = id;
+               fastest_ns = best_ns;
+            }
+         }
+         select(fastest);
+         return fastest;
+      }
+
+      // auto_tune on random triples
+      trilaterate_calc_id auto_tune(std::size_t calibration_size = 1024)
+      {
+         return auto_tune(make_random_triples(calibration_size).soa());
+      }
+
+      trilaterate_status operator()(sphere const& A, sphere const & B, sphere const & C,point & out) const
+      {
+         return m_solve(A,B,C,out);
+      }
+
+      std::size_t batch(sphere_triple_soa const & in, point_soa const & out, trilaterate_status * status) const
+      {
+         return m_batch(in,out,status);
+      }
+
+      // call f with a value of the selected calc type
+      template <typename F>
+      void visit(F f) const { visit_id(m_id,f);}
+
+      trilaterate_calc_id selected() const { return m_id;}
+      char const * name() const { return m_name;}
+
+      // ns per solve of calc id found by the last auto_tune, 0 if not tuned
+      double tuned_ns_per_solve(trilaterate_calc_id id) const { return m_tuned_ns[static_cast<int>(id)];}
+
+   private:
+
+      template <typename F>
+      static void visit_id(trilaterate_calc_id id, F f)
+      {
+         switch (id){
+            case trilaterate_calc_id::affine:
+               f(affine_calc{});
+               break;
+            case trilaterate_calc_id::vect:
+               f(vect_calc{});
+               break;
+            case trilaterate_calc_id::basis:
+               f(basis_calc{});
+               break;
+            case trilaterate_calc_id::quaternion:
+               f(quaternion_calc{});
+               break;
+            default:
+               f(matrix_calc{});
+               break;
+         }
+      }
+
+      trilaterate_calc_id m_id;
+      solve_fn m_solve;
+      batch_fn m_batch;
+      char const * m_name;
+      double m_tuned_ns[5] = {0.0,0.0,0.0,0.0,0.0};
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_DISPATCH_HPP_INCLUDED
@@ -0,0 +1,436 @@
+#ifndef TRILATERATION_TRILATERATE_FIXED_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_FIXED_HPP_INCLUDED
+
+/*
+  fixed point trilateration for targets without an fpu
+
+  the same solve as basis_calc, in integer arithmetic only
+  lengths are Q format integers in metres, unit vectors keep all but the sign and one integer bit
+
+  q16_16   int32_t lengths with int64_t intermediates
+           resolution 15 um, a working volume up to about +-5.5 km
+  q32_32   int64_t lengths with __int128 intermediates ( gcc and clang)
+           resolution 0.23 nm, a working volume up to about +-350000 km
+
+  ( with radii up to 1.75 times the largest coordinate)
+
+  the working volume bounds every centre coordinate and radius.
+  fixed_volume_fits<Format>(volume) checks that no intermediate of a solve in the volume can overflow,
+  and can be used in a static_assert for a constexpr volume.
+  a fixed_trilaterator is constructed for one volume and returns trilaterate_status::out_of_range
+  for spheres outside it, or for every solve if the volume does not fit the format ( see is_valid())
+
+     fixed_trilaterator<q16_16> const solver{fixed_volume{2_km,3_km}};
+     fixed_vect<q16_16> p;
+     auto const status = solver.trilaterate(A,B,C,p);
+
+  the error bound of a solve is in fixed_trilaterator::trilaterate(A,B,C,p,bound)
+  the conversions to and from quan lengths use double, for the host side only
+*/
+
+#include <cstdint>
+#include <limits>
+
+#include "trilaterate.hpp"
+
+namespace {
+
+   template <typename Int, typename Wide, typename UnsignedWide, int FracBits>
+   struct q_format{
+      typedef Int value_type;
+      typedef Wide wide_type;
+      typedef UnsignedWide unsigned_wide_type;
+      // fraction bits of a length in m
+      static constexpr int frac_bits = FracBits;
+      // fraction bits of a unit vector component
+      static constexpr int unit_frac_bits = static_cast<int>(sizeof(Int)) * 8 - 2;
+      static constexpr int value_bits = static_cast<int>(sizeof(Int)) * 8;
+      static constexpr int wide_bits = static_cast<int>(sizeof(Wide)) * 8;
+   };
+
+   typedef q_format<std::int32_t,std::int64_t,std::uint64_t,16> q16_16;
+   typedef q_format<std::int64_t,__int128,unsigned __int128,32> q32_32;
+
+   template <typename Format>
+   struct fixed_vect{
+      typename Format::value_type x;
+      typename Format::value_type y;
+      typename Format::value_type z;
+   };
+
+   template <typename Format>
+   struct fixed_sphere{
+      fixed_vect<Format> centre;
+      typename Format::value_type radius;
+   };
+
+   // every centre coordinate is in [-max_coordinate, max_coordinate]
+   // every radius is in [0, max_radius]
+   struct fixed_volume{
+      quan::length::km max_coordinate;
+      quan::length::km max_radius;
+   };
+
+   namespace fixed_detail{
+
+      constexpr double pow2(int n)
+      {
+         return (n > 0) ? 2.0 * pow2(n - 1) : ((n < 0) ? 0.5 * pow2(n + 1) : 1.0);
+      }
+
+      template <typename Format>
+      constexpr double m_per_raw() { return pow2(-Format::frac_bits);}
+
+      // largest magnitude in m of a length, of a length times a unit vector component in a wide
+      // and of a length squared in a wide
+      template <typename Format>
+      constexpr double max_value() { return pow2(Format::value_bits - 1 - Format::frac_bits);}
+      template <typename Format>
+      constexpr double max_shifted() { return pow2(Format::wide_bits - 1 - Format::frac_bits - Format::unit_frac_bits);}
+      template <typename Format>
+      constexpr double max_squared() { return pow2(Format::wide_bits - 1 - 2 * Format::frac_bits);}
+
+      constexpr double max(double a, double b) { return (a > b) ? a : b;}
+
+      // floor of the square root
+      template <typename UnsignedWide>
+      inline UnsignedWide isqrt(UnsignedWide v)
+      {
+         UnsignedWide result = 0;
+         UnsignedWide bit = UnsignedWide{1} << (sizeof(UnsignedWide) * 8 - 2);
+         while ( bit > v){
+            bit >>= 2;
+         }
+         while ( bit != 0){
+            if ( v >= result + bit){
+               v -= result + bit;
+               result = (result >> 1) + bit;
+            }else{
+               result >>= 1;
+            }
+            bit >>= 2;
+         }
+         return result;
+      }
+
+      // a / b rounded to nearest, b > 0
+      template <typename Wide>
+      inline Wide div_round(Wide a, Wide b)
+      {
+         return (a >= 0) ? (a + b / 2) / b : -((b / 2 - a) / b);
+      }
+
+      // a / 2^n rounded to nearest
+      template <typename Wide>
+      inline Wide shift_round(Wide a, int n)
+      {
+         return (a + (Wide{1} << (n - 1))) >> n;
+      }
+
+      template <typename Wide>
+      inline Wide abs(Wide a) { return (a < 0) ? -a : a;}
+   }
+
+   /*
+     true if no intermediate of a solve overflows for spheres in volume
+     with D the longest distance between centres, the largest intermediates are
+     x                 R + D / 2
+     lengths along a unit vector before rounding  3R + D/2
+     the numerator of y  3R^2 + 3D^2 + 2DR
+     allowing 1/16 for rounding
+   */
+   template <typename Format>
+   constexpr bool fixed_volume_fits(fixed_volume const & volume)
+   {
+      using namespace fixed_detail;
+      double const V = volume.max_coordinate.numeric_value() * 1000.0 * 1.0625;
+      double const R = volume.max_radius.numeric_value() * 1000.0 * 1.0625;
+      double const D = 2.0 * 1.7320508075688772 * V;
+      return (V > 0.0) && (R > 0.0)
+         && ( max(max(D,V + R), R + D) < max_value<Format>())
+         && ( max(D,3.0 * R + D) < max_shifted<Format>())
+         && ( max(4.0 * R * R,3.0 * R * R + 3.0 * D * D + 2.0 * D * R) < max_squared<Format>());
+   }
+
+   // lengths too big for the format saturate, so they are out of any volume that fits
+   template <typename Format>
+   inline typename Format::value_type to_fixed(quan::length::km const & v)
+   {
+      typedef typename Format::value_type value_type;
+      double const raw = v.numeric_value() * 1000.0 / fixed_detail::m_per_raw<Format>();
+      double const limit = fixed_detail::pow2(Format::value_bits - 1) - 1.0;
+      if ( !(raw > -limit)){
+         return -std::numeric_limits<value_type>::max();
+      }
+      if ( !(raw < limit)){
+         return std::numeric_limits<value_type>::max();
+      }
+      return static_cast<value_type>( (raw < 0.0) ? raw - 0.5 : raw + 0.5);
+   }
+
+   template <typename Format>
+   inline fixed_vect<Format> to_fixed(point const & p)
+   {
+      return fixed_vect<Format>{to_fixed<Format>(p.x),to_fixed<Format>(p.y),to_fixed<Format>(p.z)};
+   }
+
+   template <typename Format>
+   inline fixed_sphere<Format> to_fixed(sphere const & s)
+   {
+      return fixed_sphere<Format>{to_fixed<Format>(s.centre),to_fixed<Format>(s.radius)};
+   }
+
+   template <typename Format>
+   inline quan::length::km to_km(typename Format::value_type v)
+   {
+      return quan::length::km{v * fixed_detail::m_per_raw<Format>() / 1000.0};
+   }
+
+   template <typename Format>
+   inline point to_point(fixed_vect<Format> const & p)
+   {
+      return point{to_km<Format>(p.x),to_km<Format>(p.y),to_km<Format>(p.z)};
+   }
+
+   /*
+     trilaterate in fixed point for spheres in a working volume
+     nothing is modified after construction so one object can be used from many threads at once
+   */
+   template <typename Format>
+   class fixed_trilaterator{
+   public:
+      typedef typename Format::value_type value_type;
+      typedef typename Format::wide_type wide_type;
+      typedef typename Format::unsigned_wide_type unsigned_wide_type;
+      static constexpr int frac_bits = Format::frac_bits;
+      static constexpr int unit_frac_bits = Format::unit_frac_bits;
+
+      // the volume is checked before it is converted to the format
+      explicit fixed_trilaterator(fixed_volume const & volume)
+      : m_valid{fixed_volume_fits<Format>(volume)}
+      , m_max_coordinate{m_valid ? to_fixed<Format>(volume.max_coordinate) : value_type{0}}
+      , m_max_radius{m_valid ? to_fixed<Format>(volume.max_radius) : value_type{0}}
+      , m_max_distance{static_cast<value_type>(2 * isqrt(3 * square(m_max_coordinate)))}
+      , m_epsilon{to_fixed<Format>(epsilon_km)}
+      {}
+
+      // false if a solve in the volume could overflow the format
+      // every solve then returns trilaterate_status::out_of_range
+      bool is_valid() const { return m_valid;}
+
+      // p is only written if solved
+      trilaterate_status trilaterate(fixed_sphere<Format> const & A, fixed_sphere<Format> const & B,
+         fixed_sphere<Format> const & C, fixed_vect<Format> & p) const
+      {
+         frame f;
+         return solve(A,B,C,p,f);
+      }
+
+      /*
+        as trilaterate(A,B,C,p) and if solved also the bound on the distance of p
+        from the exact intersection of A B C, in the units of p
+        the bound follows the rounding of each step, so it grows as the solve is ill conditioned,
+        with B near A ( small d), C near the line AB ( small j) or p near the plane ABC ( small z)
+      */
+      trilaterate_status trilaterate(fixed_sphere<Format> const & A, fixed_sphere<Format> const & B,
+         fixed_sphere<Format> const & C, fixed_vect<Format> & p, value_type & bound) const
+      {
+         frame f;
+         auto const status = solve(A,B,C,p,f);
+         if ( status == trilaterate_status::solved){
+            bound = error_bound(A.radius,f);
+         }
+         return status;
+      }
+
+      bool in_volume(fixed_sphere<Format> const & s) const
+      {
+         return m_valid
+            && (fixed_detail::abs(s.centre.x) <= m_max_coordinate)
+            && (fixed_detail::abs(s.centre.y) <= m_max_coordinate)
+            && (fixed_detail::abs(s.centre.z) <= m_max_coordinate)
+            && (s.radius >= 0) && (s.radius <= m_max_radius);
+      }
+
+   private:
+
+      // the normalised frame lengths of a solve
+      struct frame{
+         value_type d;
+         value_type j;
+         value_type z;
+      };
+
+      static wide_type square(value_type v) { return static_cast<wide_type>(v) * v;}
+
+      static wide_type magnitude_squared(fixed_vect<Format> const & v)
+      {
+         return square(v.x) + square(v.y) + square(v.z);
+      }
+
+      static value_type isqrt(wide_type v)
+      {
+         return static_cast<value_type>(fixed_detail::isqrt(static_cast<unsigned_wide_type>(v)));
+      }
+
+      static fixed_vect<Format> sub(fixed_vect<Format> const & a, fixed_vect<Format> const & b)
+      {
+         return fixed_vect<Format>{
+            static_cast<value_type>(a.x - b.x),static_cast<value_type>(a.y - b.y),static_cast<value_type>(a.z - b.z)
+         };
+      }
+
+      // v / length as a unit vector
+      static fixed_vect<Format> unit(fixed_vect<Format> const & v, value_type length)
+      {
+         auto const unit1 = [length](value_type c){
+            return static_cast<value_type>(fixed_detail::div_round(static_cast<wide_type>(c) << unit_frac_bits,static_cast<wide_type>(length)));
+         };
+         return fixed_vect<Format>{unit1(v.x),unit1(v.y),unit1(v.z)};
+      }
+
+      // length of v along unit vector u
+      static value_type along(fixed_vect<Format> const & u, fixed_vect<Format> const & v)
+      {
+         return static_cast<value_type>(fixed_detail::shift_round(
+            static_cast<wide_type>(u.x) * v.x + static_cast<wide_type>(u.y) * v.y + static_cast<wide_type>(u.z) * v.z,
+            unit_frac_bits));
+      }
+
+      // as trilaterate_verify for one pair of spheres
+      trilaterate_status verify(wide_type dist_squared, value_type r1, value_type r2,
+         trilaterate_status coincident, trilaterate_status no_intersection) const
+      {
+         if ( dist_squared < square(m_epsilon)){
+            return coincident;
+         }
+         wide_type const r_sum = static_cast<wide_type>(r1) + r2;
+         if ( dist_squared >= r_sum * r_sum){
+            return no_intersection;
+         }
+         return trilaterate_status::solved;
+      }
+
+      trilaterate_status solve(fixed_sphere<Format> const & A, fixed_sphere<Format> const & B,
+         fixed_sphere<Format> const & C, fixed_vect<Format> & p, frame & f) const
+      {
+         using fixed_detail::div_round;
+         using fixed_detail::shift_round;
+
+         if ( !in_volume(A) || !in_volume(B) || !in_volume(C)){
+            return trilaterate_status::out_of_range;
+         }
+
+         // translate so that A is at origin
+         auto const b = sub(B.centre,A.centre);
+         auto const c = sub(C.centre,A.centre);
+
+         auto const dist_squared = magnitude_squared(b);
+         auto status = verify(dist_squared,A.radius,B.radius,
+            trilaterate_status::coincident_AB,trilaterate_status::no_intersection_AB);
+         if ( status == trilaterate_status::solved){
+            status = verify(magnitude_squared(sub(C.centre,B.centre)),B.radius,C.radius,
+               trilaterate_status::coincident_BC,trilaterate_status::no_intersection_BC);
+         }
+         if ( status == trilaterate_status::solved){
+            status = verify(magnitude_squared(c),A.radius,C.radius,
+               trilaterate_status::coincident_AC,trilaterate_status::no_intersection_AC);
+         }
+         if ( status != trilaterate_status::solved){
+            return status;
+         }
+
+         value_type const d = isqrt(dist_squared);
+         // B contains A, as ll_trilaterate
+         // d >= rA + rB was rejected by verify, and A containing B is negative_z_squared below
+         if ( B.radius >= d + A.radius){
+            return trilaterate_status::no_intersection_AB;
+         }
+
+         // basis ex, ey, ez
+         auto const ex = unit(b,d);
+         value_type const i = along(ex,c);
+         fixed_vect<Format> const t{
+            static_cast<value_type>(c.x - shift_round(static_cast<wide_type>(i) * ex.x,unit_frac_bits)),
+            static_cast<value_type>(c.y - shift_round(static_cast<wide_type>(i) * ex.y,unit_frac_bits)),
+            static_cast<value_type>(c.z - shift_round(static_cast<wide_type>(i) * ex.z,unit_frac_bits))
+         };
+         value_type const j = isqrt(magnitude_squared(t));
+         if ( j < m_epsilon){
+            return trilaterate_status::degenerate_C;
+         }
+         auto const ey = unit(t,j);
+         auto const cross = [](value_type a1, value_type b1, value_type a2, value_type b2){
+            return static_cast<value_type>(shift_round(static_cast<wide_type>(a1) * b1 - static_cast<wide_type>(a2) * b2,unit_frac_bits));
+         };
+         fixed_vect<Format> const ez{
+            cross(ex.y,ey.z,ex.z,ey.y),
+            cross(ex.z,ey.x,ex.x,ey.z),
+            cross(ex.x,ey.y,ex.y,ey.x)
+         };
+
+         // ll_trilaterate, numerators are length squared so dividing by a length gives a length
+         wide_type const rA_2 = square(A.radius);
+         value_type const x = static_cast<value_type>(div_round(rA_2 - square(B.radius) + square(d),2 * static_cast<wide_type>(d)));
+         wide_type const y_num = rA_2 - square(C.radius) + square(i) + square(j) - 2 * static_cast<wide_type>(i) * x;
+         if ( fixed_detail::abs(y_num) > 2 * static_cast<wide_type>(j) * A.radius){
+            // |y| > rA
+            return trilaterate_status::negative_z_squared;
+         }
+         value_type const y = static_cast<value_type>(div_round(y_num,2 * static_cast<wide_type>(j)));
+         wide_type const z_2 = rA_2 - square(x) - square(y);
+         if ( z_2 < 0){
+            return trilaterate_status::negative_z_squared;
+         }
+         value_type const z = isqrt(z_2);
+
+         // A + x * ex + y * ey + z * ez
+         auto const to_world = [x,y,z](value_type a, value_type ux, value_type uy, value_type uz){
+            return static_cast<value_type>(a + shift_round(
+               static_cast<wide_type>(x) * ux + static_cast<wide_type>(y) * uy + static_cast<wide_type>(z) * uz,unit_frac_bits));
+         };
+         p.x = to_world(A.centre.x,ex.x,ey.x,ez.x);
+         p.y = to_world(A.centre.y,ex.y,ey.y,ez.y);
+         p.z = to_world(A.centre.z,ex.z,ey.z,ez.z);
+         f = frame{d,j,z};
+         return trilaterate_status::solved;
+      }
+
+      /*
+        e is the error in the normalised frame coordinates from rounding, in units of the last place
+        a few for each length, D / d from the direction of ex and D / j from ey,
+        plus (R + D) times the rounding of the unit vectors
+        z^2 = rA^2 - x^2 - y^2 is then out by up to 4 * rA * e, which is an error in z 
+        of 2 * rA * e / z, or sqrt(4 * rA * e) where z is small
+      */
+      value_type error_bound(value_type rA, frame const & f) const
+      {
+         using fixed_detail::div_round;
+         wide_type const D = m_max_distance;
+         wide_type const e = K0 + div_round(K1 * D,static_cast<wide_type>(f.d)) + div_round(K1 * D,static_cast<wide_type>(f.j))
+            + ((K1 * (static_cast<wide_type>(m_max_radius) + D)) >> unit_frac_bits);
+         wide_type const z_2_error = 4 * static_cast<wide_type>(rA) * e;
+         wide_type ez = static_cast<wide_type>(fixed_detail::isqrt(static_cast<unsigned_wide_type>(z_2_error))) + 1;
+         if ( f.z > 0){
+            wide_type const ez1 = div_round(z_2_error,2 * static_cast<wide_type>(f.z)) + 1;
+            if ( ez1 < ez){
+               ez = ez1;
+            }
+         }
+         return static_cast<value_type>(e + ez);
+      }
+
+      static constexpr int K0 = 4;
+      static constexpr int K1 = 4;
+
+      bool m_valid;
+      value_type m_max_coordinate;
+      value_type m_max_radius;
+      // longest distance between two centres in the volume
+      value_type m_max_distance;
+      value_type m_epsilon;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_FIXED_HPP_INCLUDED
@@ -0,0 +1,138 @@
+/*
+  fixed point trilateration against double
+
+  for q16_16 and q32_32 solves random sphere triples in a working volume with fixed_trilaterator
+  and with trilaterate<basis_calc> in double, then reports
+  status mismatches, the error against the double solution as p50, p99 and max,
+  the number of solves out by more than their error bound, and ns per solve
+
+  usage : trilaterate_fixed_bench.exe [num_triples]
+  returns EXIT_FAILURE if any solve is out by more than its error bound
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_fixed.hpp"
+
+namespace {
+
+   template <typename Format>
+   bool check(char const * name, sphere_triple_arrays const & triples, fixed_volume const & volume,
+      point_arrays const & reference, double reference_ns)
+   {
+      std::size_t const num_triples = triples.size();
+      fixed_trilaterator<Format> const solver{volume};
+
+      std::vector<fixed_sphere<Format> > in(3 * num_triples);
+      for ( std::size_t n = 0; n < num_triples; ++n){
+         for ( int s = 0; s < 3; ++s){
+            in[3 * n + s] = to_fixed<Format>(triples.get(s,n));
+         }
+      }
+
+      std::vector<fixed_vect<Format> > result(num_triples);
+      std::vector<typename Format::value_type> bound(num_triples);
+      std::vector<trilaterate_status> status(num_triples);
+      double const ns = ns_per_item(num_triples,[&]{
+         for ( std::size_t n = 0; n < num_triples; ++n){
+            status[n] = solver.trilaterate(in[3 * n],in[3 * n + 1],in[3 * n + 2],result[n],bound[n]);
+         }
+      });
+
+      std::size_t status_mismatch = 0;
+      std::size_t out_of_bound = 0;
+      std::vector<double> errors;
+      for ( std::size_t n = 0; n < num_triples; ++n){
+         bool const solved = status[n] == trilaterate_status::solved;
+         if ( solved != (reference.status[n] == trilaterate_status::solved)){
+            ++status_mismatch;
+         }else if ( solved){
+            auto const error = magnitude(to_point(result[n]) - reference.get(n));
+            errors.push_back(error.numeric_value() * 1000.0);
+            if ( error > to_km<Format>(bound[n])){
+               ++out_of_bound;
+            }
+         }
+      }
+      std::sort(errors.begin(),errors.end());
+      auto quantile = [&errors](double q){ return errors.empty() ? 0.0 : errors[static_cast<std::size_t>(q * (errors.size() - 1))];};
+
+      std::cout << name << " : ns/solve = " << ns << " ( double " << reference_ns << ")"
+         << ", solved = " << errors.size() << "/" << num_triples
+         << ", status mismatches = " << status_mismatch << '\n'
+         << "   error (m) : p50 = " << quantile(0.5) << ", p99 = " << quantile(0.99)
+         << ", max = " << (errors.empty() ? 0.0 : errors.back())
+         << ", out of bound = " << out_of_bound << '\n';
+      return out_of_bound == 0;
+   }
+
+   // solve triples with double and check each format against it
+   bool check_volume(char const * name, sphere_triple_arrays const & triples, fixed_volume const & volume,
+      bool with_q16_16)
+   {
+      std::size_t const num_triples = triples.size();
+      point_arrays reference{num_triples};
+      double const reference_ns = ns_per_item(num_triples,[&]{
+         for ( std::size_t n = 0; n < num_triples; ++n){
+            point p;
+            reference.status[n] = trilaterate<basis_calc>(triples.get(0,n),triples.get(1,n),triples.get(2,n),p);
+            if ( reference.status[n] == trilaterate_status::solved){
+               reference.x[n] = p.x;
+               reference.y[n] = p.y;
+               reference.z[n] = p.z;
+            }
+         }
+      });
+      std::cout << name << '\n';
+      bool success = true;
+      if ( with_q16_16){
+         success = check<q16_16>("   q16_16",triples,volume,reference,reference_ns) && success;
+      }
+      success = check<q32_32>("   q32_32",triples,volume,reference,reference_ns) && success;
+      return success;
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_triples = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+
+   // make_random_triples puts the centres in [0,extent] so ranges are at most sqrt(3) * extent
+   fixed_volume constexpr site{2_km,3.5_km};
+   static_assert(fixed_volume_fits<q16_16>(site),"site must fit q16_16");
+   fixed_volume constexpr region{200_km,350_km};
+   static_assert(!fixed_volume_fits<q16_16>(region) && fixed_volume_fits<q32_32>(region),"region only fits q32_32");
+
+   bool success = check_volume("2 km site",make_random_triples(num_triples,1,site.max_coordinate),site,true);
+   success = check_volume("2 km site, +-1 cm ranges",make_random_triples(num_triples,2,site.max_coordinate,0.00001_km),site,true) && success;
+   success = check_volume("200 km region",make_random_triples(num_triples,3,region.max_coordinate),region,false) && success;
+
+   // a volume too big for the format fails every solve
+   fixed_trilaterator<q16_16> const too_big{region};
+   fixed_vect<q16_16> p;
+   sphere const A{{1_km,1_km,1_km},1_km};
+   auto const status = too_big.trilaterate(to_fixed<q16_16>(A),to_fixed<q16_16>(A),to_fixed<q16_16>(A),p);
+   std::cout << "200 km region as q16_16 : " << trilaterate_status_name(status) << '\n';
+   success = !too_big.is_valid() && (status == trilaterate_status::out_of_range) && success;
+
+   // one of A B inside the other gives the same status as double
+   // B containing A is no_intersection_AB, A containing B falls through to negative_z_squared
+   fixed_trilaterator<q32_32> const site_solver{site};
+   sphere const big{{0.2_km,0.3_km,0.1_km},1.5_km};
+   sphere const small{{0.9_km,0.4_km,0.2_km},0.3_km};
+   sphere const C{{0.5_km,1.5_km,0.3_km},1.2_km};
+   for ( auto const & ab : {std::make_pair(big,small),std::make_pair(small,big)}){
+      point ip;
+      fixed_vect<q32_32> fixed_ip;
+      auto const expected = trilaterate<basis_calc>(ab.first,ab.second,C,ip);
+      auto const fixed_status = site_solver.trilaterate(to_fixed<q32_32>(ab.first),to_fixed<q32_32>(ab.second),to_fixed<q32_32>(C),fixed_ip);
+      std::cout << "containment : double " << trilaterate_status_name(expected) 
+         << ", q32_32 " << trilaterate_status_name(fixed_status) << '\n';
+      success = (fixed_status == expected) && success;
+   }
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+/*
+  float against double trilateration
+
+  for each geometry reports the error of the float solution against the double solution
+  and against the tag the ranges were measured from, as max, p50 and p99 in m
+  then ns per solve of the scalar batch and simd batch in double and float
+  (the scalar double batch aligns by rotations, the scalar float batch by the basis calc)
+
+  float keeps about 7 significant digits, so the error grows with the distance of the anchors from the origin
+  translate the anchors to a local origin before converting to float when the site is far from it
+
+  usage : trilaterate_float_bench.exe [num_triples]
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_simd.hpp"
+
+namespace {
+
+   typedef basic_sphere_triple_arrays<km_<float> > sphere_triple_arrays_f;
+   typedef basic_point_arrays<km_<float> > point_arrays_f;
+
+   point to_double(point_<float> const & p)
+   {
+      return point{quan::length::km{p.x.numeric_value()},quan::length::km{p.y.numeric_value()},quan::length::km{p.z.numeric_value()}};
+   }
+
+   // distance from p to the tag or its mirror image in the plane of the centres
+   // whichever is nearer, since either is a solution
+   quan::length::km tag_error(point const & p, point const & tag, sphere const & A, sphere const & B, sphere const & C)
+   {
+      auto const normal = unit_vector(quan::three_d::cross_product(B.centre - A.centre,C.centre - A.centre));
+      point const mirror = tag - 2.0 * dot_product(tag - A.centre,normal) * normal;
+      return std::min(magnitude(p - tag),magnitude(p - mirror));
+   }
+
+   // errors in m
+   struct error_summary{
+      void add(quan::length::km const & e) { m_errors.push_back(e.numeric_value() * 1000.0);}
+      void print(std::ostream & out, char const * name)
+      {
+         if ( m_errors.empty()){
+            out << "   " << name << " : none solved\n";
+            return;
+         }
+         std::sort(m_errors.begin(),m_errors.end());
+         auto quantile = [this](double q){ return m_errors[static_cast<std::size_t>(q * (m_errors.size() - 1))];};
+         out << "   " << name << " error (m) : p50 = " << quantile(0.5)
+            << ", p99 = " << quantile(0.99) << ", max = " << m_errors.back() << '\n';
+      }
+   private:
+      std::vector<double> m_errors;
+   };
+
+   void accuracy(char const * name, std::size_t num_triples, quan::length::km const & extent, quan::length::km const & noise)
+   {
+      auto const triples = make_random_triples(num_triples,1,extent,noise);
+      sphere_triple_arrays_f const triples_f{triples};
+
+      point_arrays result{num_triples};
+      trilaterate_batch_simd(triples.soa(),result.soa(),result.status.data());
+      point_arrays_f result_f{num_triples};
+      trilaterate_batch_simd(triples_f.soa(),result_f.soa(),result_f.status.data());
+
+      error_summary vs_double, vs_tag_double, vs_tag_float;
+      std::size_t status_mismatch = 0;
+      for ( std::size_t n = 0; n < num_triples; ++n){
+         if ( result.status[n] != result_f.status[n]){
+            ++status_mismatch;
+            continue;
+         }
+         if ( result.status[n] == trilaterate_status::solved){
+            point const p = result.get(n);
+            point const pf = to_double(result_f.get(n));
+            sphere const A = triples.get(0,n);
+            sphere const B = triples.get(1,n);
+            sphere const C = triples.get(2,n);
+            vs_double.add(magnitude(pf - p));
+            vs_tag_double.add(tag_error(p,triples.tag[n],A,B,C));
+            vs_tag_float.add(tag_error(pf,triples.tag[n],A,B,C));
+         }
+      }
+      std::cout << name << " : status mismatches = " << status_mismatch << '\n';
+      vs_double.print(std::cout,"float vs double");
+      if ( noise > 0_km){
+         vs_tag_double.print(std::cout,"double vs tag");
+         vs_tag_float.print(std::cout,"float vs tag");
+      }
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_triples = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+
+   accuracy("300 m site, exact ranges",num_triples,0.3_km,0_km);
+   accuracy("300 m site, +-1 cm ranges",num_triples,0.3_km,0.00001_km);
+   accuracy("20 km site, exact ranges",num_triples,20_km,0_km);
+   accuracy("20 km site, +-1 cm ranges",num_triples,20_km,0.00001_km);
+
+   auto const triples = make_random_triples(num_triples);
+   sphere_triple_arrays_f const triples_f{triples};
+   point_arrays result{num_triples};
+   point_arrays_f result_f{num_triples};
+
+   std::cout << "\nns/solve\n";
+   std::cout << "   scalar double = " << ns_per_item(num_triples,[&]{
+      trilaterate_batch(triples.soa(),result.soa(),result.status.data());
+   }) << '\n';
+   std::cout << "   scalar float  = " << ns_per_item(num_triples,[&]{
+      trilaterate_batch(triples_f.soa(),result_f.soa(),result_f.status.data());
+   }) << '\n';
+   std::cout << "   " << simd_level_name(cpu_simd_level()) << " double = " << ns_per_item(num_triples,[&]{
+      trilaterate_batch_simd(triples.soa(),result.soa(),result.status.data());
+   }) << '\n';
+   std::cout << "   " << simd_level_name(cpu_simd_level()) << " float  = " << ns_per_item(num_triples,[&]{
+      trilaterate_batch_simd(triples_f.soa(),result_f.soa(),result_f.status.data());
+   }) << '\n';
+}
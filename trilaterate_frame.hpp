@@ -0,0 +1,107 @@
+#ifndef TRILATERATION_TRILATERATE_FRAME_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_FRAME_HPP_INCLUDED
+
+/*
+  the normalised frame of three anchors as a unit quaternion and an origin
+  for moving whole tag trajectories into and out of the frame of the anchors
+
+     anchor_frame<quan::length::km> const frame{pA,pB,pC};
+     frame.to_frame(world_points,num_points,local_points);
+     frame.to_world(local_points,num_points,world_points);
+
+  in the frame A is at origin, B is on the x axis and C is in the xy plane, as for ll_trilaterate
+*/
+
+#include "trilaterate_batch.hpp"
+#include "trilaterate_quaternion.hpp"
+
+namespace {
+
+   template <typename Length>
+   class anchor_frame{
+   public:
+      typedef quan::three_d::vect<Length> point_type;
+      typedef typename Length::value_type value_type;
+      typedef unit_quaternion<value_type> quaternion;
+
+      // pA pB pC must not be coincident or on one line
+      anchor_frame(point_type const & pA, point_type const & pB, point_type const & pC)
+      : m_origin{pA}
+      , m_to_frame{make_quaternion(pB - pA,pC - pA)}
+      {}
+
+      anchor_frame(point_type const & origin, quaternion const & to_frame)
+      : m_origin{origin}, m_to_frame{to_frame}{}
+
+      point_type to_frame(point_type const & p) const { return m_to_frame.rotate(p - m_origin);}
+      point_type to_world(point_type const & p) const { return m_to_frame.conjugate().rotate(p) + m_origin;}
+
+      /*
+        the first n points of in into the frame, or back to the world
+        in and out may be the same arrays
+      */
+      void to_frame(basic_point_soa<Length> const & in, std::size_t n, basic_point_soa<Length> const & out) const
+      {
+         rotate_points(m_to_frame,point_type{-m_origin.x,-m_origin.y,-m_origin.z},point_type{},in,n,out);
+      }
+
+      void to_world(basic_point_soa<Length> const & in, std::size_t n, basic_point_soa<Length> const & out) const
+      {
+         rotate_points(m_to_frame.conjugate(),point_type{},m_origin,in,n,out);
+      }
+
+      // the frame of other as seen in this frame, composed without going through a matrix
+      anchor_frame relative(anchor_frame const & other) const
+      {
+         return anchor_frame{to_frame(other.m_origin),(other.m_to_frame * m_to_frame.conjugate()).normalised()};
+      }
+
+      point_type origin() const { return m_origin;}
+      quaternion rotation() const { return m_to_frame;}
+
+   private:
+
+      static quaternion make_quaternion(point_type const & pB1, point_type const & pC1)
+      {
+         auto const ex = unit_vector(pB1);
+         auto const ey = unit_vector(pC1 - dot_product(ex,pC1) * ex);
+         auto const ez = decltype(ex){
+            ex.y * ey.z - ex.z * ey.y,
+            ex.z * ey.x - ex.x * ey.z,
+            ex.x * ey.y - ex.y * ey.x
+         };
+         return quaternion::from_basis(ex,ey,ez);
+      }
+
+      // out = q.rotate(in + before) + after
+      // q is converted to a rotation matrix once, so each point is 9 multiply adds
+      static void rotate_points(quaternion const & q, point_type const & before, point_type const & after,
+         basic_point_soa<Length> const & in, std::size_t n, basic_point_soa<Length> const & out)
+      {
+         value_type const w = q.w, x = q.x, y = q.y, z = q.z;
+         value_type const m00 = 1 - 2 * (y * y + z * z), m01 = 2 * (x * y - w * z),     m02 = 2 * (x * z + w * y);
+         value_type const m10 = 2 * (x * y + w * z),     m11 = 1 - 2 * (x * x + z * z), m12 = 2 * (y * z - w * x);
+         value_type const m20 = 2 * (x * z - w * y),     m21 = 2 * (y * z + w * x),     m22 = 1 - 2 * (x * x + y * y);
+         value_type const bx = before.x.numeric_value(), by = before.y.numeric_value(), bz = before.z.numeric_value();
+         value_type const ax = after.x.numeric_value(), ay = after.y.numeric_value(), az = after.z.numeric_value();
+         // the translations folded together, out = M * in + t
+         value_type const tx = m00 * bx + m01 * by + m02 * bz + ax;
+         value_type const ty = m10 * bx + m11 * by + m12 * bz + ay;
+         value_type const tz = m20 * bx + m21 * by + m22 * bz + az;
+         for ( std::size_t i = 0; i < n; ++i){
+            value_type const vx = in.x[i].numeric_value();
+            value_type const vy = in.y[i].numeric_value();
+            value_type const vz = in.z[i].numeric_value();
+            out.x[i] = Length{m00 * vx + m01 * vy + m02 * vz + tx};
+            out.y[i] = Length{m10 * vx + m11 * vy + m12 * vz + ty};
+            out.z[i] = Length{m20 * vx + m21 * vy + m22 * vz + tz};
+         }
+      }
+
+      point_type m_origin;
+      quaternion m_to_frame;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_FRAME_HPP_INCLUDED
@@ -0,0 +1,172 @@
+/*
+  moving a tag trajectory into and out of the frame of three anchors
+
+  the batched anchor_frame quaternion kernels against per point
+  Euler rotations ( quan::three_d y, z and x rotations as vect_calc) and a composed affine_transform
+  then trilaterate<quaternion_calc> against vect_calc and basis_calc, on random anchors and on anchors with AB
+  near the z axis, where the Euler y and z angles are near their singularity
+
+  reports ns per point or solve and the max error of the round trip or the solve
+
+  usage : trilaterate_frame_bench.exe [num_points]
+*/
+
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_dispatch.hpp"
+#include "trilaterate_frame.hpp"
+
+namespace {
+
+   quan::length::km max_difference(point_arrays const & a, point_arrays const & b)
+   {
+      auto max_diff = 0_km;
+      for ( std::size_t n = 0; n < a.x.size(); ++n){
+         auto const diff = magnitude(a.get(n) - b.get(n));
+         if ( diff > max_diff){
+            max_diff = diff;
+         }
+      }
+      return max_diff;
+   }
+
+   // worst | |p - centre| - radius | of the solved triples
+   quan::length::km max_residual(sphere_triple_arrays const & triples, point_arrays const & result)
+   {
+      auto max_residual = 0_km;
+      for ( std::size_t n = 0; n < triples.size(); ++n){
+         if ( result.status[n] == trilaterate_status::solved){
+            for ( int s = 0; s < 3; ++s){
+               sphere const sp = triples.get(s,n);
+               auto const residual = abs(magnitude(result.get(n) - sp.centre) - sp.radius);
+               if ( residual > max_residual){
+                  max_residual = residual;
+               }
+            }
+         }
+      }
+      return max_residual;
+   }
+
+   void trajectory(std::size_t num_points)
+   {
+      point const pA{4.3_km, 5_km,6_km};
+      point const pB{13_km, 4.5_km, 5.5_km};
+      point const pC{10_km,11_km,5.6_km};
+
+      // the tags of random triples as the trajectory
+      auto const triples = make_random_triples(num_points);
+      point_arrays world{num_points};
+      for ( std::size_t n = 0; n < num_points; ++n){
+         world.x[n] = triples.tag[n].x;
+         world.y[n] = triples.tag[n].y;
+         world.z[n] = triples.tag[n].z;
+      }
+
+      anchor_frame<quan::length::km> const frame{pA,pB,pC};
+      point_arrays local{num_points};
+      point_arrays round_trip{num_points};
+      double const to_frame_ns = ns_per_item(num_points,[&]{ frame.to_frame(world.soa(),num_points,local.soa());});
+      double const to_world_ns = ns_per_item(num_points,[&]{ frame.to_world(local.soa(),num_points,round_trip.soa());});
+      std::cout << "anchor_frame : to_frame ns/point = " << to_frame_ns << ", to_world ns/point = " << to_world_ns
+         << ", round trip error = " << max_difference(world,round_trip) << '\n';
+
+      // the same frame by Euler angles
+      auto const pB1 = pB - pA;
+      auto const pC1 = pC - pA;
+      auto const y_angle = quan::atan2(pB1.z,pB1.x);
+      quan::three_d::y_rotation const y_rotate{-y_angle};
+      auto const pB2 = y_rotate(pB1);
+      auto const z_angle = quan::atan2(pB2.y,pB2.x);
+      quan::three_d::z_rotation const z_rotate{-z_angle};
+      auto const pC3 = z_rotate(y_rotate(pC1));
+      auto const x_angle = quan::atan2(pC3.z,pC3.y);
+      quan::three_d::x_rotation const x_rotate{-x_angle};
+      quan::three_d::x_rotation const x_unrotate{x_angle};
+      quan::three_d::z_rotation const z_unrotate{z_angle};
+      quan::three_d::y_rotation const y_unrotate{y_angle};
+
+      point_arrays euler_local{num_points};
+      double const euler_to_frame_ns = ns_per_item(num_points,[&]{
+         for ( std::size_t n = 0; n < num_points; ++n){
+            point const p = x_rotate(z_rotate(y_rotate(world.get(n) - pA)));
+            euler_local.x[n] = p.x;
+            euler_local.y[n] = p.y;
+            euler_local.z[n] = p.z;
+         }
+      });
+      double const euler_to_world_ns = ns_per_item(num_points,[&]{
+         for ( std::size_t n = 0; n < num_points; ++n){
+            point const p = y_unrotate(z_unrotate(x_unrotate(euler_local.get(n)))) + pA;
+            round_trip.x[n] = p.x;
+            round_trip.y[n] = p.y;
+            round_trip.z[n] = p.z;
+         }
+      });
+      std::cout << "euler rotations : to_frame ns/point = " << euler_to_frame_ns << ", to_world ns/point = " << euler_to_world_ns
+         << ", round trip error = " << max_difference(world,round_trip)
+         << ", difference from anchor_frame = " << max_difference(local,euler_local) << '\n';
+
+      typedef affine_transform<quan::length::km> transform;
+      auto const to_frame = transform::x_rotation(-x_angle) * transform::z_rotation(-z_angle)
+         * transform::y_rotation(-y_angle) * transform::translation(-pA);
+      auto const to_world = to_frame.inverse();
+      point_arrays affine_local{num_points};
+      double const affine_to_frame_ns = ns_per_item(num_points,[&]{
+         for ( std::size_t n = 0; n < num_points; ++n){
+            point const p = to_frame(world.get(n));
+            affine_local.x[n] = p.x;
+            affine_local.y[n] = p.y;
+            affine_local.z[n] = p.z;
+         }
+      });
+      double const affine_to_world_ns = ns_per_item(num_points,[&]{
+         for ( std::size_t n = 0; n < num_points; ++n){
+            point const p = to_world(affine_local.get(n));
+            round_trip.x[n] = p.x;
+            round_trip.y[n] = p.y;
+            round_trip.z[n] = p.z;
+         }
+      });
+      std::cout << "affine_transform : to_frame ns/point = " << affine_to_frame_ns << ", to_world ns/point = " << affine_to_world_ns
+         << ", round trip error = " << max_difference(world,round_trip)
+         << ", difference from anchor_frame = " << max_difference(local,affine_local) << "\n\n";
+   }
+
+   void solve(char const * name, sphere_triple_arrays const & triples)
+   {
+      std::cout << name << '\n';
+      for ( auto id : {trilaterate_calc_id::vect, trilaterate_calc_id::basis, trilaterate_calc_id::quaternion}){
+         trilaterate_dispatcher const dispatcher{id};
+         point_arrays result{triples.size()};
+         double const ns = ns_per_item(triples.size(),[&]{ dispatcher.batch(triples.soa(),result.soa(),result.status.data());});
+         std::cout << "   " << dispatcher.name() << " calc : ns/solve = " << ns
+            << ", max range residual = " << max_residual(triples,result) << '\n';
+      }
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_points = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+
+   trajectory(num_points);
+
+   auto const triples = make_random_triples(num_points);
+   solve("random anchors",triples);
+
+   // B 10 cm to 1 m horizontally from directly above A
+   // ( vect_calc asserts that B is not within epsilon_km of directly above A)
+   auto steep = make_random_triples(num_points,2);
+   std::mt19937_64 gen{3};
+   std::uniform_real_distribution<double> offset{0.0001,0.001};
+   for ( std::size_t n = 0; n < num_points; ++n){
+      point const tag = steep.tag[n];
+      sphere const A = steep.get(0,n);
+      point const pB = A.centre + point{quan::length::km{offset(gen)},quan::length::km{offset(gen)},5_km};
+      steep.set(1,n,sphere{pB,magnitude(tag - pB)});
+   }
+   solve("AB near the z axis",steep);
+}
@@ -0,0 +1,265 @@
+/*
+  load generator for trilaterate_service.exe
+
+  each connection is a thread sending random sphere triples with at most window requests in flight,
+  at rate requests/s over all connections, or as fast as responses come back if rate is 0.
+  with a rate, latency is from the time a request was due to be sent, so a stalled service is not hidden
+  by the generator waiting for it
+
+  reports throughput and latency p50, p99, p999 and max,
+  and checks every response against trilaterate_batch_simd run here on the same triples
+
+  usage : trilaterate_load.exe (--unix path | --tcp port) [--connections n] [--window n] [--rate n] [--seconds n]
+     defaults 4 connections, window 64, rate 0, 5 seconds
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <poll.h>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_service.hpp"
+
+namespace {
+
+   typedef std::chrono::steady_clock clock;
+
+   struct load_options{
+      char const * unix_path = nullptr;
+      int tcp_port = 0;
+      std::size_t connections = 4;
+      std::size_t window = 64;
+      double rate = 0;
+      double seconds = 5;
+   };
+
+   struct client_result{
+      latency_histogram latency;
+      std::uint64_t sent = 0;
+      std::uint64_t received = 0;
+      std::uint64_t solved = 0;
+      // responses that differ from the local solve
+      std::uint64_t mismatches = 0;
+      bool failed = false;
+   };
+
+   // the triples and their local solution
+   struct workload{
+      explicit workload(std::size_t n) : triples{make_random_triples(n,7)}, expected{n}
+      {
+         trilaterate_batch_simd(triples.soa(),expected.soa(),expected.status.data());
+      }
+      sphere_triple_arrays triples;
+      point_arrays expected;
+   };
+
+   bool send_all(int fd, char const * data, std::size_t size)
+   {
+      while ( size > 0){
+         ssize_t const num_sent = ::send(fd,data,size,MSG_NOSIGNAL);
+         if ( num_sent < 0){
+            if ( errno == EINTR){
+               continue;
+            }
+            return false;
+         }
+         data += num_sent;
+         size -= num_sent;
+      }
+      return true;
+   }
+
+   bool check(service_response const & response, workload const & work)
+   {
+      std::size_t const n = response.id % work.triples.size();
+      bool const solved = response.status == static_cast<std::uint8_t>(trilaterate_status::solved);
+      if ( solved != (work.expected.status[n] == trilaterate_status::solved)){
+         return false;
+      }
+      if ( !solved){
+         return true;
+      }
+      point const p{quan::length::km{response.position[0]},quan::length::km{response.position[1]},quan::length::km{response.position[2]}};
+      return magnitude(p - work.expected.get(n)) <= epsilon_km;
+   }
+
+   void run_client(int fd, workload const & work, load_options const & options, clock::time_point end, client_result & result)
+   {
+      std::size_t const window = options.window;
+      // responses come back in order, so the due time of request id is at id % window
+      std::vector<clock::time_point> due(window);
+      std::vector<char> out;
+      out.reserve(window * sizeof(service_request));
+      std::array<char,64 * sizeof(service_response)> in;
+      std::size_t in_size = 0;
+
+      auto const interval = (options.rate > 0)
+         ? std::chrono::nanoseconds{static_cast<std::int64_t>(1e9 * options.connections / options.rate)}
+         : std::chrono::nanoseconds{0};
+      std::uint64_t next_id = 0;
+      std::uint64_t next_response = 0;
+      auto next_send = clock::now();
+
+      for (;;){
+         auto now = clock::now();
+         bool const sending = now < end;
+         out.clear();
+         while ( sending && ((next_id - next_response) < window) && ((interval.count() == 0) || (next_send <= now))){
+            service_request request;
+            request.id = next_id;
+            std::size_t const n = next_id % work.triples.size();
+            for ( int s = 0; s < 3; ++s){
+               sphere const sp = work.triples.get(s,n);
+               double * const v = request.sphere + 4 * s;
+               v[0] = sp.centre.x.numeric_value();
+               v[1] = sp.centre.y.numeric_value();
+               v[2] = sp.centre.z.numeric_value();
+               v[3] = sp.radius.numeric_value();
+            }
+            char const * const bytes = reinterpret_cast<char const *>(&request);
+            out.insert(out.end(),bytes,bytes + sizeof(request));
+            due[next_id % window] = (interval.count() == 0) ? now : next_send;
+            next_send += interval;
+            ++next_id;
+         }
+         if ( !out.empty()){
+            if ( !send_all(fd,out.data(),out.size())){
+               result.failed = true;
+               return;
+            }
+            result.sent += out.size() / sizeof(service_request);
+         }
+         if ( !sending && (next_response == next_id)){
+            return;
+         }
+
+         // wait for responses, until the next request is due while sending
+         // or for at most a second for the last responses
+         now = clock::now();
+         auto wait = std::chrono::nanoseconds{std::chrono::seconds{1}};
+         if ( sending){
+            wait = std::chrono::duration_cast<std::chrono::nanoseconds>(end - now);
+            if ( (interval.count() > 0) && ((next_id - next_response) < window)){
+               wait = std::min(wait,std::chrono::duration_cast<std::chrono::nanoseconds>(next_send - now));
+            }
+         }
+         wait = std::max(wait,std::chrono::nanoseconds{0});
+         timespec const timeout{static_cast<time_t>(wait.count() / 1000000000),static_cast<long>(wait.count() % 1000000000)};
+         pollfd p{fd,POLLIN,0};
+         int const ready = ::ppoll(&p,1,&timeout,nullptr);
+         if ( ready == 0){
+            if ( !sending){
+               // responses lost
+               result.failed = true;
+               return;
+            }
+            continue;
+         }
+         ssize_t const num_read = ::recv(fd,in.data() + in_size,in.size() - in_size,MSG_DONTWAIT);
+         if ( num_read <= 0){
+            if ( (num_read < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))){
+               continue;
+            }
+            result.failed = true;
+            return;
+         }
+         in_size += num_read;
+         auto const received = clock::now();
+         std::size_t const num_responses = in_size / sizeof(service_response);
+         for ( std::size_t r = 0; r < num_responses; ++r){
+            service_response response;
+            std::memcpy(&response,in.data() + r * sizeof(service_response),sizeof(response));
+            if ( response.id != next_response){
+               result.failed = true;
+               return;
+            }
+            result.latency.add(std::chrono::duration_cast<std::chrono::nanoseconds>(received - due[response.id % window]).count());
+            ++result.received;
+            result.solved += response.status == static_cast<std::uint8_t>(trilaterate_status::solved);
+            result.mismatches += !check(response,work);
+            ++next_response;
+         }
+         std::size_t const used = num_responses * sizeof(service_response);
+         std::memmove(in.data(),in.data() + used,in_size - used);
+         in_size -= used;
+      }
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   load_options options;
+   for ( int i = 1; i < argc; ++i){
+      bool const has_value = (i + 1) < argc;
+      if ( has_value && (std::strcmp(argv[i],"--unix") == 0)){
+         options.unix_path = argv[++i];
+      }else if ( has_value && (std::strcmp(argv[i],"--tcp") == 0)){
+         options.tcp_port = std::atoi(argv[++i]);
+      }else if ( has_value && (std::strcmp(argv[i],"--connections") == 0)){
+         options.connections = std::max(1UL,std::strtoul(argv[++i],nullptr,10));
+      }else if ( has_value && (std::strcmp(argv[i],"--window") == 0)){
+         options.window = std::max(1UL,std::strtoul(argv[++i],nullptr,10));
+      }else if ( has_value && (std::strcmp(argv[i],"--rate") == 0)){
+         options.rate = std::strtod(argv[++i],nullptr);
+      }else if ( has_value && (std::strcmp(argv[i],"--seconds") == 0)){
+         options.seconds = std::strtod(argv[++i],nullptr);
+      }else{
+         options.unix_path = nullptr;
+         options.tcp_port = 0;
+         break;
+      }
+   }
+   if ( (options.unix_path == nullptr) && (options.tcp_port == 0)){
+      std::cerr << "usage : trilaterate_load.exe (--unix path | --tcp port) [--connections n] [--window n] [--rate n] [--seconds n]\n";
+      return EXIT_FAILURE;
+   }
+
+   workload const work{4096};
+   std::vector<int> fds;
+   for ( std::size_t c = 0; c < options.connections; ++c){
+      int const fd = (options.unix_path != nullptr) ? service_connect_unix(options.unix_path) : service_connect_tcp(options.tcp_port);
+      if ( fd < 0){
+         std::cerr << "cant connect to the service\n";
+         return EXIT_FAILURE;
+      }
+      fds.push_back(fd);
+   }
+
+   std::vector<client_result> results(options.connections);
+   std::vector<std::thread> threads;
+   auto const start = clock::now();
+   auto const end = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>{options.seconds});
+   for ( std::size_t c = 0; c < options.connections; ++c){
+      threads.emplace_back([&,c]{ run_client(fds[c],work,options,end,results[c]);});
+   }
+   for ( auto & t : threads){
+      t.join();
+   }
+   double const elapsed = std::chrono::duration<double>(clock::now() - start).count();
+   for ( int fd : fds){
+      ::close(fd);
+   }
+
+   client_result total;
+   for ( auto const & r : results){
+      total.latency.add(r.latency);
+      total.sent += r.sent;
+      total.received += r.received;
+      total.solved += r.solved;
+      total.mismatches += r.mismatches;
+      total.failed = total.failed || r.failed;
+   }
+   std::cout << "connections = " << options.connections << ", window = " << options.window
+      << ", rate = " << options.rate << '\n';
+   std::cout << "sent = " << total.sent << ", received = " << total.received << ", solved = " << total.solved
+      << ", responses/s = " << total.received / elapsed << '\n';
+   std::cout << "latency us p50 = " << total.latency.quantile_ns(0.5) / 1000
+      << ", p99 = " << total.latency.quantile_ns(0.99) / 1000
+      << ", p999 = " << total.latency.quantile_ns(0.999) / 1000
+      << ", max = " << total.latency.max_ns / 1000.0 << '\n';
+   std::cout << "mismatches = " << total.mismatches << (total.failed ? ", connection failed" : "") << '\n';
+   return ( !total.failed && (total.mismatches == 0)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,130 @@
+/*
+  binary measurement logs, see trilaterate_log.hpp for the format
+
+  usage :
+     trilaterate_log.exe --convert in.csv out.trilog     text records as trilaterate_stream.exe to a measurement log
+     trilaterate_log.exe --solve in.trilog out.trires    solve a measurement log to a result log
+     trilaterate_log.exe --bench in.trilog               read throughput of a measurement log
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "trilaterate_stream.hpp"
+#include "trilaterate_log.hpp"
+
+namespace {
+
+   double seconds_since(std::chrono::steady_clock::time_point start)
+   {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   int convert(char const * in_filename, char const * out_filename)
+   {
+      std::FILE * in = std::fopen(in_filename,"rb");
+      if ( in == nullptr){
+         std::cerr << "cant open \"" << in_filename << "\"\n";
+         return EXIT_FAILURE;
+      }
+      measurement_log_writer out{out_filename,3};
+      if ( !out.is_open()){
+         std::cerr << "cant create \"" << out_filename << "\"\n";
+         std::fclose(in);
+         return EXIT_FAILURE;
+      }
+      line_reader reader{in};
+      std::unique_ptr<measurement_batch> batch{new measurement_batch};
+      record_parser parser;
+      std::size_t num_bad = 0;
+      auto write_batch = [&]{
+         for ( std::size_t n = 0; n < batch->size; ++n){
+            if ( batch->bad[n]){
+               ++num_bad;
+               continue;
+            }
+            sphere spheres[3];
+            for ( int s = 0; s < 3; ++s){
+               spheres[s] = sphere{{batch->x[4*s][n],batch->x[4*s+1][n],batch->x[4*s+2][n]},batch->x[4*s+3][n]};
+            }
+            out.write(spheres);
+         }
+         batch->size = 0;
+      };
+      char const * begin;
+      char const * end;
+      while ( reader.next(begin,end)){
+         if ( parser.parse(begin,end,*batch) && batch->full()){
+            write_batch();
+         }
+      }
+      write_batch();
+      out.close();
+      std::fclose(in);
+      std::cerr << out.num_records() << " records written, " << num_bad << " bad records skipped\n";
+      return EXIT_SUCCESS;
+   }
+
+   int solve(char const * in_filename, char const * out_filename)
+   {
+      measurement_log_reader const in{in_filename};
+      if ( !in.is_valid()){
+         std::cerr << "\"" << in_filename << "\" is not a measurement log\n";
+         return EXIT_FAILURE;
+      }
+      result_log_writer const out{out_filename,in.num_records()};
+      if ( !out.is_open()){
+         std::cerr << "cant create \"" << out_filename << "\"\n";
+         return EXIT_FAILURE;
+      }
+      auto const start = std::chrono::steady_clock::now();
+      std::uint64_t const num_solved = trilaterate_log(in,out);
+      double const elapsed = seconds_since(start);
+      std::cerr << num_solved << "/" << in.num_records() << " solved in " << elapsed << " s, " 
+         << in.num_records() / elapsed << " records/s\n";
+      return EXIT_SUCCESS;
+   }
+
+   int bench(char const * in_filename)
+   {
+      measurement_log_reader const in{in_filename};
+      if ( !in.is_valid()){
+         std::cerr << "\"" << in_filename << "\" is not a measurement log\n";
+         return EXIT_FAILURE;
+      }
+      auto const start = std::chrono::steady_clock::now();
+      // touch every value through the soa views
+      auto sum = 0_km;
+      for ( std::uint64_t b = 0; b < in.num_blocks(); ++b){
+         auto const block = in.triple_block(b);
+         for ( sphere_soa const * s : {&block.A,&block.B,&block.C}){
+            for ( std::size_t n = 0; n < block.size; ++n){
+               sum += s->x[n] + s->y[n] + s->z[n] + s->radius[n];
+            }
+         }
+      }
+      double const elapsed = seconds_since(start);
+      double const bytes = in.num_records() * 12.0 * sizeof(double);
+      std::cout << "read " << in.num_records() << " records in " << elapsed << " s, "
+         << in.num_records() / elapsed << " records/s, " << bytes / elapsed / 1e9 << " GB/s"
+         << " ( checksum " << sum << ")\n";
+      return EXIT_SUCCESS;
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   if ( (argc == 4) && (std::strcmp(argv[1],"--convert") == 0)){
+      return convert(argv[2],argv[3]);
+   }
+   if ( (argc == 4) && (std::strcmp(argv[1],"--solve") == 0)){
+      return solve(argv[2],argv[3]);
+   }
+   if ( (argc == 3) && (std::strcmp(argv[1],"--bench") == 0)){
+      return bench(argv[2]);
+   }
+   std::cerr << "usage : trilaterate_log.exe --convert in.csv out.trilog | --solve in.trilog out.trires | --bench in.trilog\n";
+   return EXIT_FAILURE;
+}
@@ -0,0 +1,342 @@
+#ifndef TRILATERATION_TRILATERATE_LOG_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_LOG_HPP_INCLUDED
+
+/*
+  binary measurement log, read through a memory mapping without copying
+
+  measurement log ( little endian, native double)
+     log_header, 64 bytes
+     blocks of log_block_size records
+        for each anchor 0 .. num_anchors - 1 columns x[log_block_size] y[..] z[..] radius[..] in km
+     the last block is zero padded
+  every column starts on a 64 byte boundary of the file, 
+  so a block of a sphere triple log is a sphere_triple_soa straight into the mapping
+
+  result log
+     log_header, 64 bytes ( num_anchors is 0)
+     blocks of log_block_size results
+        columns x[log_block_size] y[..] z[..] in km, then status[log_block_size] bytes
+        status is the trilaterate_status of the record
+
+  POSIX only
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trilaterate_simd.hpp"
+
+namespace {
+
+   std::size_t constexpr log_block_size = 4096;
+   std::uint32_t constexpr log_version = 1;
+   std::uint32_t constexpr result_log_version = 2;
+
+   struct log_header{
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t num_anchors;
+      std::uint64_t block_size;
+      std::uint64_t num_records;
+      std::uint8_t reserved[32];
+   };
+   static_assert(sizeof(log_header) == 64,"log header must keep the columns 64 byte aligned");
+   static_assert(sizeof(quan::length::km) == sizeof(double),"log columns are read as quan::length::km");
+   static_assert(sizeof(trilaterate_status) == 1,"the result log has a status byte per record");
+
+   char constexpr measurement_log_magic[8] = {'T','R','I','L','O','G','\0','\0'};
+   char constexpr result_log_magic[8] = {'T','R','I','R','E','S','\0','\0'};
+
+   inline log_header make_log_header(char const (&magic)[8], std::uint32_t num_anchors, std::uint64_t num_records,
+      std::uint32_t version = log_version)
+   {
+      log_header header;
+      std::memset(&header,0,sizeof(header));
+      std::memcpy(header.magic,magic,sizeof(header.magic));
+      header.version = version;
+      header.num_anchors = num_anchors;
+      header.block_size = log_block_size;
+      header.num_records = num_records;
+      return header;
+   }
+
+   // no overflow for any num_records read from a header
+   inline std::uint64_t num_log_blocks(std::uint64_t num_records)
+   {
+      return num_records / log_block_size + ( (num_records % log_block_size) != 0);
+   }
+
+   // most anchors for which a measurement block size fits in a std::size_t
+   std::uint64_t constexpr max_log_anchors = SIZE_MAX / (4 * log_block_size * sizeof(double));
+
+   inline std::size_t measurement_block_bytes(std::uint32_t num_anchors)
+   {
+      return std::size_t{num_anchors} * 4 * log_block_size * sizeof(double);
+   }
+
+   inline std::size_t result_block_bytes()
+   {
+      return 3 * log_block_size * sizeof(double) + log_block_size;
+   }
+
+   // whole file memory mapping
+   class mapped_file{
+   public:
+
+      // map an existing file read only
+      explicit mapped_file(char const * filename)
+      : m_data{nullptr}, m_size{0}
+      {
+         int const fd = ::open(filename,O_RDONLY);
+         if ( fd < 0){
+            return;
+         }
+         struct stat st;
+         if ( (::fstat(fd,&st) == 0) && (st.st_size > 0)){
+            void * const p = ::mmap(nullptr,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+            if ( p != MAP_FAILED){
+               m_data = static_cast<char *>(p);
+               m_size = st.st_size;
+               ::madvise(p,m_size,MADV_SEQUENTIAL);
+            }
+         }
+         ::close(fd);
+      }
+
+      // create or truncate a file of size bytes and map it read write
+      mapped_file(char const * filename, std::size_t size)
+      : m_data{nullptr}, m_size{0}
+      {
+         int const fd = ::open(filename,O_RDWR | O_CREAT | O_TRUNC,0644);
+         if ( fd < 0){
+            return;
+         }
+         if ( ::ftruncate(fd,size) == 0){
+            void * const p = ::mmap(nullptr,size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+            if ( p != MAP_FAILED){
+               m_data = static_cast<char *>(p);
+               m_size = size;
+            }
+         }
+         ::close(fd);
+      }
+
+      ~mapped_file()
+      {
+         if ( m_data != nullptr){
+            ::munmap(m_data,m_size);
+         }
+      }
+
+      mapped_file(mapped_file const &) = delete;
+      mapped_file& operator = (mapped_file const &) = delete;
+
+      bool is_open() const { return m_data != nullptr;}
+      char * data() const { return m_data;}
+      std::size_t size() const { return m_size;}
+
+   private:
+      char * m_data;
+      std::size_t m_size;
+   };
+
+   // writes a measurement log one block at a time
+   class measurement_log_writer{
+   public:
+
+      measurement_log_writer(char const * filename, std::uint32_t num_anchors)
+      : m_file{std::fopen(filename,"wb")}
+      , m_num_anchors{num_anchors}
+      , m_block(std::size_t{num_anchors} * 4 * log_block_size)
+      , m_num_records{0}
+      {
+         if ( m_file != nullptr){
+            write_header();
+         }
+      }
+
+      ~measurement_log_writer() { close();}
+
+      measurement_log_writer(measurement_log_writer const &) = delete;
+      measurement_log_writer& operator = (measurement_log_writer const &) = delete;
+
+      bool is_open() const { return m_file != nullptr;}
+      std::uint64_t num_records() const { return m_num_records;}
+
+      // one record of num_anchors spheres
+      void write(sphere const * spheres)
+      {
+         std::size_t const n = m_num_records % log_block_size;
+         for ( std::uint32_t a = 0; a < m_num_anchors; ++a){
+            double * const column = &m_block[a * 4 * log_block_size];
+            column[n] = spheres[a].centre.x.numeric_value();
+            column[n + log_block_size] = spheres[a].centre.y.numeric_value();
+            column[n + 2 * log_block_size] = spheres[a].centre.z.numeric_value();
+            column[n + 3 * log_block_size] = spheres[a].radius.numeric_value();
+         }
+         ++m_num_records;
+         if ( (m_num_records % log_block_size) == 0){
+            write_block();
+         }
+      }
+
+      // write the last block and the final header
+      void close()
+      {
+         if ( m_file == nullptr){
+            return;
+         }
+         if ( (m_num_records % log_block_size) != 0){
+            std::size_t const used = m_num_records % log_block_size;
+            for ( std::size_t c = 0; c < std::size_t{m_num_anchors} * 4; ++c){
+               std::fill(&m_block[c * log_block_size + used],&m_block[(c + 1) * log_block_size],0.0);
+            }
+            write_block();
+         }
+         std::fseek(m_file,0,SEEK_SET);
+         write_header();
+         std::fclose(m_file);
+         m_file = nullptr;
+      }
+
+   private:
+
+      void write_header()
+      {
+         log_header const header = make_log_header(measurement_log_magic,m_num_anchors,m_num_records);
+         std::fwrite(&header,sizeof(header),1,m_file);
+      }
+
+      void write_block()
+      {
+         std::fwrite(m_block.data(),sizeof(double),m_block.size(),m_file);
+      }
+
+      std::FILE * m_file;
+      std::uint32_t m_num_anchors;
+      std::vector<double> m_block;
+      std::uint64_t m_num_records;
+   };
+
+   // validated view of a mapped measurement log
+   class measurement_log_reader{
+   public:
+
+      explicit measurement_log_reader(char const * filename)
+      : m_file{filename}, m_header{nullptr}
+      {
+         if ( !m_file.is_open() || (m_file.size() < sizeof(log_header))){
+            return;
+         }
+         auto const header = reinterpret_cast<log_header const *>(m_file.data());
+         // the blocks must fit in the file, compared by division so a bad header cannot overflow
+         if ( (std::memcmp(header->magic,measurement_log_magic,sizeof(header->magic)) == 0)
+               && (header->version == log_version) 
+               && (header->block_size == log_block_size)
+               && (header->num_anchors >= 3)
+               && (header->num_anchors <= max_log_anchors)
+               && (num_log_blocks(header->num_records) 
+                     <= (m_file.size() - sizeof(log_header)) / measurement_block_bytes(header->num_anchors))){
+            m_header = header;
+         }
+      }
+
+      bool is_valid() const { return m_header != nullptr;}
+      std::uint32_t num_anchors() const { return m_header->num_anchors;}
+      std::uint64_t num_records() const { return m_header->num_records;}
+      std::uint64_t num_blocks() const { return num_log_blocks(num_records());}
+
+      std::size_t block_records(std::uint64_t b) const
+      {
+         return (b + 1 < num_blocks()) ? log_block_size : num_records() - b * log_block_size;
+      }
+
+      // column c of block b,  c = anchor * 4 + ( 0 : x, 1 : y, 2 : z, 3 : radius)
+      quan::length::km const * column(std::uint64_t b, std::size_t c) const
+      {
+         char const * const block = m_file.data() + sizeof(log_header) + b * measurement_block_bytes(num_anchors());
+         return reinterpret_cast<quan::length::km const *>(block) + c * log_block_size;
+      }
+
+      // the first 3 anchors of block b, pointing into the mapping
+      sphere_triple_soa triple_block(std::uint64_t b) const
+      {
+         auto view = [&](int a){ return sphere_soa{column(b,4*a),column(b,4*a+1),column(b,4*a+2),column(b,4*a+3)};};
+         return sphere_triple_soa{block_records(b),view(0),view(1),view(2)};
+      }
+
+      sphere get(std::uint64_t record, std::uint32_t anchor) const
+      {
+         std::uint64_t const b = record / log_block_size;
+         std::size_t const n = record % log_block_size;
+         return sphere{
+            {column(b,4*anchor)[n],column(b,4*anchor+1)[n],column(b,4*anchor+2)[n]},
+            column(b,4*anchor+3)[n]
+         };
+      }
+
+   private:
+      mapped_file m_file;
+      log_header const * m_header;
+   };
+
+   // result log of a fixed number of records, written through the mapping
+   class result_log_writer{
+   public:
+
+      result_log_writer(char const * filename, std::uint64_t num_records)
+      : m_file{filename,sizeof(log_header) + num_log_blocks(num_records) * result_block_bytes()}
+      , m_num_records{num_records}
+      {
+         if ( m_file.is_open()){
+            log_header const header = make_log_header(result_log_magic,0,num_records,result_log_version);
+            std::memcpy(m_file.data(),&header,sizeof(header));
+         }
+      }
+
+      bool is_open() const { return m_file.is_open();}
+
+      point_soa block(std::uint64_t b) const
+      {
+         auto const x = reinterpret_cast<quan::length::km *>(block_data(b));
+         return point_soa{x,x + log_block_size,x + 2 * log_block_size};
+      }
+
+      trilaterate_status * status(std::uint64_t b) const
+      {
+         return reinterpret_cast<trilaterate_status *>(block_data(b) + 3 * log_block_size * sizeof(double));
+      }
+
+   private:
+
+      char * block_data(std::uint64_t b) const
+      {
+         return m_file.data() + sizeof(log_header) + b * result_block_bytes();
+      }
+
+      mapped_file m_file;
+      std::uint64_t m_num_records;
+   };
+
+   // solve the first 3 anchors of every record of in into out
+   // returns the number of records solved
+   inline std::uint64_t trilaterate_log(measurement_log_reader const & in, result_log_writer const & out)
+   {
+      std::uint64_t num_solved = 0;
+      for ( std::uint64_t b = 0; b < in.num_blocks(); ++b){
+         num_solved += trilaterate_batch_simd(in.triple_block(b),out.block(b),out.status(b));
+      }
+      return num_solved;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_LOG_HPP_INCLUDED
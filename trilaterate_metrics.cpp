@@ -0,0 +1,60 @@
+/*
+  solve noisy triples with each calc on all threads with TRILATERATE_METRICS defined
+  then output the metrics as JSON or Prometheus text
+
+  ns per solve of each calc goes to stderr, compare with trilaterate_calc_bench.exe for the cost of the metrics
+
+  usage : trilaterate_metrics.exe [--prometheus] [num_triples]
+*/
+
+#define TRILATERATE_METRICS
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_dispatch.hpp"
+
+int main(int argc, char const * argv[])
+{
+   bool prometheus = false;
+   std::size_t num_triples = 1000000;
+   for ( int arg = 1; arg < argc; ++arg){
+      if ( std::strcmp(argv[arg],"--prometheus") == 0){
+         prometheus = true;
+      }else{
+         num_triples = std::strtoul(argv[arg],nullptr,10);
+      }
+   }
+
+   auto const triples = make_random_triples(num_triples,1,20_km,0.1_km);
+   unsigned const num_threads = std::max(1U,std::thread::hardware_concurrency());
+
+   for ( auto id : trilaterate_calc_ids){
+      trilaterate_dispatcher const dispatcher{id};
+      double const ns = ns_per_item(num_triples,[&]{
+         std::vector<std::thread> threads;
+         for ( unsigned t = 0; t < num_threads; ++t){
+            threads.emplace_back([&,t]{
+               for ( std::size_t n = t; n < num_triples; n += num_threads){
+                  point ip;
+                  dispatcher(triples.get(0,n),triples.get(1,n),triples.get(2,n),ip);
+               }
+            });
+         }
+         for ( auto & thread : threads){
+            thread.join();
+         }
+      });
+      std::cerr << dispatcher.name() << " calc : ns/solve = " << ns << " on " << num_threads << " threads\n";
+   }
+
+   auto const snapshot = trilaterate_metrics_collect();
+   if ( prometheus){
+      write_prometheus(std::cout,snapshot);
+   }else{
+      write_json(std::cout,snapshot);
+   }
+}
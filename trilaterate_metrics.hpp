@@ -0,0 +1,393 @@
+#ifndef TRILATERATION_TRILATERATE_METRICS_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_METRICS_HPP_INCLUDED
+
+/*
+  per stage latency and status counts of trilaterate
+
+  define TRILATERATE_METRICS before including trilaterate.hpp to turn on
+  otherwise trilaterate_stage_timer and trilaterate_metrics_record are empty and compile to nothing
+
+  each thread records to its own counters, TSC cycles per stage into a log linear histogram
+  ( 16 sub buckets per power of 2, so a quantile is within 6% )
+  the status of every solve is counted, but the stages are only timed for 1 in TRILATERATE_METRICS_SAMPLE_PERIOD solves
+  ( default 16, a TSC read can cost 20 ns or more in a virtual machine)
+  trilaterate_metrics_collect sums the counters of all threads ( including threads that have exited)
+  and can be called from any thread while others solve
+  write_json and write_prometheus output a collected snapshot
+
+  the metrics are per translation unit, as is everything in these headers
+*/
+
+#include <algorithm>
+#include <cstdint>
+
+#include "trilaterate_status.hpp"
+
+#if defined TRILATERATE_METRICS
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <x86intrin.h>
+
+#if ! defined TRILATERATE_METRICS_SAMPLE_PERIOD
+#define TRILATERATE_METRICS_SAMPLE_PERIOD 16
+#endif
+
+#endif
+
+namespace {
+
+   enum class trilaterate_stage : std::uint8_t {
+      verify,              // trilaterate_verify
+      translate,           // mt, translate so A is at origin
+      rotate_y,            // mry
+      rotate_z,            // mrz
+      rotate_x,            // mrx
+      basis,               // basis calc alignment
+      ll_trilaterate,      // solve in the normalised frame
+      inverse_transform    // mxtot_dash, back to the original frame
+   };
+
+   constexpr int num_trilaterate_stages = 8;
+
+   inline char const * trilaterate_stage_name(trilaterate_stage stage)
+   {
+      switch (stage){
+         case trilaterate_stage::verify:            return "verify";
+         case trilaterate_stage::translate:         return "translate";
+         case trilaterate_stage::rotate_y:          return "rotate_y";
+         case trilaterate_stage::rotate_z:          return "rotate_z";
+         case trilaterate_stage::rotate_x:          return "rotate_x";
+         case trilaterate_stage::basis:             return "basis";
+         case trilaterate_stage::ll_trilaterate:    return "ll_trilaterate";
+         case trilaterate_stage::inverse_transform: return "inverse_transform";
+         default:                                   return "unknown";
+      }
+   }
+
+   /*
+     log linear buckets of cycles, or of ns
+     also used without TRILATERATE_METRICS by the latency histograms of trilaterate_service.hpp
+   */
+   constexpr int latency_sub_bucket_bits = 4;
+   constexpr int latency_sub_buckets = 1 << latency_sub_bucket_bits;
+   // values from 2^latency_max_exponent cycles go in the last bucket
+   constexpr int latency_max_exponent = 40;
+   constexpr int latency_num_buckets = (latency_max_exponent - latency_sub_bucket_bits + 1) * latency_sub_buckets;
+
+   inline int latency_bucket(std::uint64_t cycles)
+   {
+      if ( cycles < latency_sub_buckets){
+         return static_cast<int>(cycles);
+      }
+      int const exponent = 63 - __builtin_clzll(cycles);
+      if ( exponent >= latency_max_exponent){
+         return latency_num_buckets - 1;
+      }
+      int const shift = exponent - latency_sub_bucket_bits;
+      return (shift + 1) * latency_sub_buckets + static_cast<int>((cycles >> shift) & (latency_sub_buckets - 1));
+   }
+
+   // smallest value in bucket
+   inline std::uint64_t latency_bucket_lower(int bucket)
+   {
+      if ( bucket < latency_sub_buckets){
+         return bucket;
+      }
+      int const shift = bucket / latency_sub_buckets - 1;
+      return static_cast<std::uint64_t>(latency_sub_buckets + bucket % latency_sub_buckets) << shift;
+   }
+
+   // value at quantile q of count values with the largest max_value, the upper end of the bucket
+   inline double latency_quantile(std::uint64_t const * buckets, std::uint64_t count, std::uint64_t max_value, double q)
+   {
+      if ( count == 0){
+         return 0.0;
+      }
+      auto const rank = static_cast<std::uint64_t>(q * (count - 1)) + 1;
+      std::uint64_t seen = 0;
+      for ( int b = 0; b < latency_num_buckets - 1; ++b){
+         seen += buckets[b];
+         if ( seen >= rank){
+            return static_cast<double>(std::min(latency_bucket_lower(b + 1) - 1, max_value));
+         }
+      }
+      return static_cast<double>(max_value);
+   }
+
+#if defined TRILATERATE_METRICS
+
+   // summed counts of all threads
+   struct trilaterate_metrics_snapshot{
+
+      struct stage_histogram{
+         std::uint64_t count = 0;
+         std::uint64_t sum_cycles = 0;
+         std::uint64_t max_cycles = 0;
+         std::vector<std::uint64_t> buckets = std::vector<std::uint64_t>(latency_num_buckets);
+
+         // cycles at quantile q, the upper end of the bucket
+         double quantile_cycles(double q) const
+         {
+            return latency_quantile(buckets.data(),count,max_cycles,q);
+         }
+      };
+
+      std::uint64_t status_count[num_trilaterate_status] = {};
+      stage_histogram stage[num_trilaterate_stages];
+      // to convert cycles to time
+      double cycles_per_ns = 1.0;
+   };
+
+   /*
+     the counters of one thread
+     only the owning thread writes, so an increment is a relaxed load and store, not a locked add
+   */
+   struct trilaterate_thread_metrics{
+
+      trilaterate_thread_metrics();
+      ~trilaterate_thread_metrics();
+
+      trilaterate_thread_metrics(trilaterate_thread_metrics const &) = delete;
+      trilaterate_thread_metrics & operator = (trilaterate_thread_metrics const &) = delete;
+
+      static void increment(std::atomic<std::uint64_t> & counter, std::uint64_t value = 1)
+      {
+         counter.store(counter.load(std::memory_order_relaxed) + value,std::memory_order_relaxed);
+      }
+
+      void record(trilaterate_stage stage, std::uint64_t cycles)
+      {
+         auto & s = this->stage[static_cast<int>(stage)];
+         increment(s.count);
+         increment(s.sum_cycles,cycles);
+         if ( cycles > s.max_cycles.load(std::memory_order_relaxed)){
+            s.max_cycles.store(cycles,std::memory_order_relaxed);
+         }
+         increment(s.buckets[latency_bucket(cycles)]);
+      }
+
+      void record(trilaterate_status status)
+      {
+         increment(status_count[static_cast<int>(status)]);
+      }
+
+      // start a solve, returns true if its stages are to be timed
+      bool begin_solve()
+      {
+         if ( --sample_countdown == 0){
+            sample_countdown = TRILATERATE_METRICS_SAMPLE_PERIOD;
+            sampled = true;
+         }else{
+            sampled = false;
+         }
+         return sampled;
+      }
+
+      // add to snapshot
+      void add_to(trilaterate_metrics_snapshot & snapshot) const
+      {
+         for ( int i = 0; i < num_trilaterate_status; ++i){
+            snapshot.status_count[i] += status_count[i].load(std::memory_order_relaxed);
+         }
+         for ( int i = 0; i < num_trilaterate_stages; ++i){
+            auto const & from = stage[i];
+            auto & to = snapshot.stage[i];
+            to.count += from.count.load(std::memory_order_relaxed);
+            to.sum_cycles += from.sum_cycles.load(std::memory_order_relaxed);
+            to.max_cycles = std::max(to.max_cycles,from.max_cycles.load(std::memory_order_relaxed));
+            for ( int b = 0; b < latency_num_buckets; ++b){
+               to.buckets[b] += from.buckets[b].load(std::memory_order_relaxed);
+            }
+         }
+      }
+
+      struct stage_counters{
+         std::atomic<std::uint64_t> count{0};
+         std::atomic<std::uint64_t> sum_cycles{0};
+         std::atomic<std::uint64_t> max_cycles{0};
+         std::atomic<std::uint64_t> buckets[latency_num_buckets] = {};
+      };
+
+      std::atomic<std::uint64_t> status_count[num_trilaterate_status] = {};
+      stage_counters stage[num_trilaterate_stages];
+      // only used by the owning thread
+      unsigned sample_countdown = 1;
+      bool sampled = false;
+   };
+
+   // the metrics of live threads and the sum of exited threads
+   struct trilaterate_metrics_registry{
+      std::mutex mutex;
+      std::vector<trilaterate_thread_metrics const *> live;
+      trilaterate_metrics_snapshot exited;
+   };
+
+   inline trilaterate_metrics_registry & get_trilaterate_metrics_registry()
+   {
+      static trilaterate_metrics_registry registry;
+      return registry;
+   }
+
+   inline trilaterate_thread_metrics::trilaterate_thread_metrics()
+   {
+      auto & registry = get_trilaterate_metrics_registry();
+      std::lock_guard<std::mutex> lock{registry.mutex};
+      registry.live.push_back(this);
+   }
+
+   inline trilaterate_thread_metrics::~trilaterate_thread_metrics()
+   {
+      auto & registry = get_trilaterate_metrics_registry();
+      std::lock_guard<std::mutex> lock{registry.mutex};
+      add_to(registry.exited);
+      registry.live.erase(std::find(registry.live.begin(),registry.live.end(),this));
+   }
+
+   inline trilaterate_thread_metrics & get_trilaterate_thread_metrics()
+   {
+      thread_local trilaterate_thread_metrics metrics;
+      return metrics;
+   }
+
+   // TSC rate measured once against steady_clock
+   inline double tsc_cycles_per_ns()
+   {
+      static double const result = []{
+         auto const start = std::chrono::steady_clock::now();
+         auto const start_cycles = __rdtsc();
+         auto finish = start;
+         do {
+            finish = std::chrono::steady_clock::now();
+         } while ( (finish - start) < std::chrono::milliseconds{10});
+         auto const cycles = __rdtsc() - start_cycles;
+         return cycles / std::chrono::duration<double,std::nano>(finish - start).count();
+      }();
+      return result;
+   }
+
+   inline trilaterate_metrics_snapshot trilaterate_metrics_collect()
+   {
+      auto & registry = get_trilaterate_metrics_registry();
+      trilaterate_metrics_snapshot result;
+      {
+         std::lock_guard<std::mutex> lock{registry.mutex};
+         result = registry.exited;
+         for ( auto metrics : registry.live){
+            metrics->add_to(result);
+         }
+      }
+      result.cycles_per_ns = tsc_cycles_per_ns();
+      return result;
+   }
+
+   // times the stages of one solve if it is sampled
+   class trilaterate_stage_timer{
+   public:
+      // new_solve starts a solve, else continue the solve started by the caller
+      explicit trilaterate_stage_timer(bool new_solve = false)
+      : m_metrics(get_trilaterate_thread_metrics()), 
+         m_sampled(new_solve ? m_metrics.begin_solve() : m_metrics.sampled),
+         m_start(m_sampled ? __rdtsc() : 0){}
+
+      // record the time since the last lap as stage
+      void lap(trilaterate_stage stage)
+      {
+         if ( m_sampled){
+            auto const now = __rdtsc();
+            m_metrics.record(stage,now - m_start);
+            m_start = now;
+         }
+      }
+   private:
+      trilaterate_thread_metrics & m_metrics;
+      bool const m_sampled;
+      std::uint64_t m_start;
+   };
+
+   inline void trilaterate_metrics_record(trilaterate_status status)
+   {
+      get_trilaterate_thread_metrics().record(status);
+   }
+
+   /*
+     {"status":{"solved":n, ...},
+      "stages":{"verify":{"count":n,"mean_ns":t,"p50_ns":t,"p90_ns":t,"p99_ns":t,"p999_ns":t,"max_ns":t}, ...}}
+   */
+   inline void write_json(std::ostream & out, trilaterate_metrics_snapshot const & snapshot)
+   {
+      out << "{\"status\":{";
+      for ( int i = 0; i < num_trilaterate_status; ++i){
+         out << (i ? "," : "") << '"' << trilaterate_status_name(static_cast<trilaterate_status>(i)) << "\":"
+            << snapshot.status_count[i];
+      }
+      out << "},\"stages\":{";
+      bool first = true;
+      for ( int i = 0; i < num_trilaterate_stages; ++i){
+         auto const & s = snapshot.stage[i];
+         if ( s.count == 0){
+            continue;
+         }
+         auto const ns = [&snapshot](double cycles){ return cycles / snapshot.cycles_per_ns;};
+         out << (first ? "" : ",") << '"' << trilaterate_stage_name(static_cast<trilaterate_stage>(i)) << "\":{"
+            << "\"count\":" << s.count
+            << ",\"mean_ns\":" << ns(static_cast<double>(s.sum_cycles) / s.count)
+            << ",\"p50_ns\":" << ns(s.quantile_cycles(0.5))
+            << ",\"p90_ns\":" << ns(s.quantile_cycles(0.9))
+            << ",\"p99_ns\":" << ns(s.quantile_cycles(0.99))
+            << ",\"p999_ns\":" << ns(s.quantile_cycles(0.999))
+            << ",\"max_ns\":" << ns(static_cast<double>(s.max_cycles)) << '}';
+         first = false;
+      }
+      out << "}}\n";
+   }
+
+   // prometheus text exposition format, histogram buckets at each power of 2 cycles
+   inline void write_prometheus(std::ostream & out, trilaterate_metrics_snapshot const & snapshot)
+   {
+      out << "# HELP trilaterate_solves_total Solves by result status.\n"
+         << "# TYPE trilaterate_solves_total counter\n";
+      for ( int i = 0; i < num_trilaterate_status; ++i){
+         out << "trilaterate_solves_total{status=\"" << trilaterate_status_name(static_cast<trilaterate_status>(i)) << "\"} "
+            << snapshot.status_count[i] << '\n';
+      }
+      out << "# HELP trilaterate_stage_seconds Time in each stage of trilaterate.\n"
+         << "# TYPE trilaterate_stage_seconds histogram\n";
+      double const seconds_per_cycle = 1.e-9 / snapshot.cycles_per_ns;
+      for ( int i = 0; i < num_trilaterate_stages; ++i){
+         auto const & s = snapshot.stage[i];
+         char const * const name = trilaterate_stage_name(static_cast<trilaterate_stage>(i));
+         std::uint64_t cumulative = 0;
+         int bucket = 0;
+         for ( int exponent = latency_sub_bucket_bits; exponent < latency_max_exponent; ++exponent){
+            // all buckets below 2^exponent cycles
+            int const end = latency_bucket(std::uint64_t{1} << exponent);
+            for ( ; bucket < end; ++bucket){
+               cumulative += s.buckets[bucket];
+            }
+            out << "trilaterate_stage_seconds_bucket{stage=\"" << name << "\",le=\""
+               << static_cast<double>(std::uint64_t{1} << exponent) * seconds_per_cycle << "\"} " << cumulative << '\n';
+         }
+         out << "trilaterate_stage_seconds_bucket{stage=\"" << name << "\",le=\"+Inf\"} " << s.count << '\n'
+            << "trilaterate_stage_seconds_sum{stage=\"" << name << "\"} " << s.sum_cycles * seconds_per_cycle << '\n'
+            << "trilaterate_stage_seconds_count{stage=\"" << name << "\"} " << s.count << '\n';
+      }
+   }
+
+#else
+
+   struct trilaterate_stage_timer{
+      explicit trilaterate_stage_timer(bool = false) {}
+      void lap(trilaterate_stage) {}
+   };
+
+   inline void trilaterate_metrics_record(trilaterate_status) {}
+
+#endif // TRILATERATE_METRICS
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_METRICS_HPP_INCLUDED
@@ -0,0 +1,44 @@
+#ifndef TRILATERATION_TRILATERATE_PARALLEL_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_PARALLEL_HPP_INCLUDED
+
+/*
+  batch solves split over a work_stealing_pool
+  every element is written to the same index as its input 
+  so the output is the same whatever the number of threads
+*/
+
+#include "work_stealing_pool.hpp"
+#include "trilaterate_simd.hpp"
+#include "multilaterate.hpp"
+
+namespace {
+
+   // trilaterate_batch_simd in chunks of chunk_size over the pool
+   inline std::size_t trilaterate_batch_parallel(work_stealing_pool & pool, 
+      sphere_triple_soa const & in, point_soa const & out, trilaterate_status * status, 
+      std::size_t chunk_size = 4096)
+   {
+      std::atomic<std::size_t> num_solved{0};
+      pool.parallel_for(in.size,chunk_size,[&](std::size_t begin, std::size_t end){
+         num_solved += trilaterate_batch_simd(slice(in,begin,end),slice(out,begin),status + begin);
+      });
+      return num_solved;
+   }
+
+   // multilaterate_batch in chunks of chunk_size sets over the pool
+   inline std::size_t multilaterate_batch_parallel(work_stealing_pool & pool, 
+      sphere const * spheres, std::size_t num_spheres, std::size_t num_sets,
+      multilaterate_result * results, trilaterate_status * status,
+      std::size_t chunk_size = 256, multilaterate_options const & options = multilaterate_options{})
+   {
+      std::atomic<std::size_t> num_solved{0};
+      pool.parallel_for(num_sets,chunk_size,[&](std::size_t begin, std::size_t end){
+         num_solved += multilaterate_batch(spheres + begin * num_spheres,num_spheres,end - begin,
+            results + begin,status + begin,options);
+      });
+      return num_solved;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_PARALLEL_HPP_INCLUDED
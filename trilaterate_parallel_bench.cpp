@@ -0,0 +1,97 @@
+/*
+  scaling of the parallel batch solves over 1 .. max_threads threads
+  on the same random workload, checking the output matches the 1 thread output
+
+  usage : trilaterate_parallel_bench.exe [num_triples] [max_threads] [chunk_size] [pin]
+  pin binds the worker threads to cores, the main thread is not pinned
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_parallel.hpp"
+
+namespace {
+
+   void report(unsigned num_threads, double ns, double one_thread_ns, bool matches)
+   {
+      double const speedup = one_thread_ns / ns;
+      std::cout << "   threads = " << num_threads 
+         << ", ns/solve = " << ns 
+         << ", Msolves/s = " << 1.e3 / ns
+         << ", speedup = " << speedup 
+         << ", efficiency = " << speedup / num_threads
+         << ( matches ? "" : " OUTPUT MISMATCH") << '\n';
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_triples = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 4000000;
+   unsigned const max_threads = (argc > 2) ? std::strtoul(argv[2],nullptr,10) : std::thread::hardware_concurrency();
+   std::size_t const chunk_size = (argc > 3) ? std::strtoul(argv[3],nullptr,10) : 4096;
+   bool const pin = (argc > 4) && (std::strcmp(argv[4],"pin") == 0);
+
+   auto const triples = make_random_triples(num_triples,1,20_km,0.1_km);
+
+   // N anchor sets of 6 spheres from pairs of triples
+   std::size_t const num_sets = num_triples / 16;
+   std::size_t constexpr num_spheres = 6;
+   std::vector<sphere> spheres(num_sets * num_spheres);
+   for ( std::size_t n = 0; n < num_sets; ++n){
+      point const tag = triples.tag[2 * n];
+      for ( std::size_t s = 0; s < num_spheres; ++s){
+         point const centre = triples.get(s % 3, 2 * n + s / 3).centre;
+         spheres[n * num_spheres + s] = sphere{centre,magnitude(tag - centre)};
+      }
+   }
+
+   std::cout << "simd level = " << simd_level_name(cpu_simd_level()) 
+      << ", chunk size = " << chunk_size << ( pin ? ", pinned" : "") << '\n';
+
+   bool success = true;
+
+   std::cout << "trilaterate_batch_parallel, " << num_triples << " triples\n";
+   point_arrays one_thread_result{num_triples};
+   double one_thread_ns = 0;
+   for ( unsigned t = 1; t <= max_threads; ++t){
+      work_stealing_pool pool{t,pin};
+      point_arrays result{num_triples};
+      double const ns = ns_per_item(num_triples,[&]{
+         trilaterate_batch_parallel(pool,triples.soa(),result.soa(),result.status.data(),chunk_size);
+      });
+      if ( t == 1){
+         one_thread_result = result;
+         one_thread_ns = ns;
+      }
+      bool const matches = (result.x == one_thread_result.x) && (result.y == one_thread_result.y)
+         && (result.z == one_thread_result.z) && (result.status == one_thread_result.status);
+      success = success && matches;
+      report(t,ns,one_thread_ns,matches);
+   }
+
+   std::cout << "multilaterate_batch_parallel, " << num_sets << " sets of " << num_spheres << " spheres\n";
+   std::vector<multilaterate_result> one_thread_sets(num_sets);
+   for ( unsigned t = 1; t <= max_threads; ++t){
+      work_stealing_pool pool{t,pin};
+      std::vector<multilaterate_result> results(num_sets);
+      std::vector<trilaterate_status> status(num_sets);
+      double const ns = ns_per_item(num_sets,[&]{
+         multilaterate_batch_parallel(pool,spheres.data(),num_spheres,num_sets,results.data(),status.data(),chunk_size / 16);
+      });
+      if ( t == 1){
+         one_thread_sets = results;
+         one_thread_ns = ns;
+      }
+      bool matches = true;
+      for ( std::size_t n = 0; n < num_sets; ++n){
+         matches = matches && (results[n].position == one_thread_sets[n].position);
+      }
+      success = success && matches;
+      report(t,ns,one_thread_ns,matches);
+   }
+
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,110 @@
+#ifndef TRILATERATION_TRILATERATE_PREPARED_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_PREPARED_HPP_INCLUDED
+
+/*
+  sphere triple with fixed centres and changing radii
+  the normalised frame and the transform back from it are found once,
+  so each solve is just the ll_trilaterate arithmetic and one affine transform
+*/
+
+#include "trilaterate.hpp"
+
+namespace {
+
+   /*
+     centres of a sphere triple with the normalised frame precomputed
+     nothing is modified after construction so one object can be used 
+     from many threads at once
+   */
+   class prepared_anchor_triple{
+   public:
+      typedef decltype(unit_vector(point{})) unit_vect;
+
+      prepared_anchor_triple(point const & pA, point const & pB, point const & pC)
+      : m_pA{pA}
+      , m_distAB{magnitude(pB - pA)}
+      , m_distBC{magnitude(pC - pB)}
+      , m_distAC{magnitude(pC - pA)}
+      , m_ex{unit_vector(pB - pA)}
+      , m_i{dot_product(m_ex,pC - pA)}
+      , m_ey{unit_vector(pC - pA - m_i * m_ex)}
+      , m_ez{
+           m_ex.y * m_ey.z - m_ex.z * m_ey.y,
+           m_ex.z * m_ey.x - m_ex.x * m_ey.z,
+           m_ex.x * m_ey.y - m_ex.y * m_ey.x
+        }
+      , m_j{dot_product(m_ey,pC - pA)}
+      {}
+
+      // false if any centres are coincident or all are on one line
+      bool is_valid() const
+      {
+         return (m_distAB >= epsilon_km) && (m_distBC >= epsilon_km) && (m_distAC >= epsilon_km)
+            && (abs(m_j) >= epsilon_km);
+      }
+
+      // radii of spheres A B C
+      // returns the reason if there is no solution, checked in the same order as trilaterate
+      // no diagnostic output
+      trilaterate_status trilaterate(quan::length::km const & rA, quan::length::km const & rB, quan::length::km const & rC, point & out) const
+      {
+         assert(is_valid());
+         if ( m_distAB >= (rA + rB)){
+            return trilaterate_status::no_intersection_AB;
+         }
+         if ( m_distBC >= (rB + rC)){
+            return trilaterate_status::no_intersection_BC;
+         }
+         if ( m_distAC >= (rA + rC)){
+            return trilaterate_status::no_intersection_AC;
+         }
+         if ( ((m_distAB - rA) >= rB) || (rB >= (m_distAB + rA))){
+            // one of A B is inside the other, as ll_trilaterate
+            return trilaterate_status::no_intersection_AB;
+         }
+         point ip_norm;
+         auto const status = ll_trilaterate_calc(m_distAB,m_i,m_j,rA,rB,rC,ip_norm);
+         if ( status == trilaterate_status::solved){
+            out = to_world(ip_norm);
+         }
+         return status;
+      }
+
+      // transform back from the normalised frame
+      point to_world(point const & p_norm) const
+      {
+         return m_pA + p_norm.x * m_ex + p_norm.y * m_ey + p_norm.z * m_ez;
+      }
+
+      // transform to the normalised frame
+      point to_norm(point const & p) const
+      {
+         auto const p1 = p - m_pA;
+         return point{dot_product(m_ex,p1),dot_product(m_ey,p1),dot_product(m_ez,p1)};
+      }
+
+      point pA() const { return m_pA;}
+      point pB() const { return to_world(pB_norm());}
+      point pC() const { return to_world(pC_norm());}
+      point pB_norm() const { return point{m_distAB,0_km,0_km};}
+      point pC_norm() const { return point{m_i,m_j,0_km};}
+      quan::length::km d() const { return m_distAB;}
+      quan::length::km i() const { return m_i;}
+      quan::length::km j() const { return m_j;}
+
+   private:
+      point m_pA;
+      quan::length::km m_distAB;
+      quan::length::km m_distBC;
+      quan::length::km m_distAC;
+      // rows of the rotation to the normalised frame
+      unit_vect m_ex;
+      quan::length::km m_i;
+      unit_vect m_ey;
+      unit_vect m_ez;
+      quan::length::km m_j;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_PREPARED_HPP_INCLUDED
@@ -0,0 +1,130 @@
+/*
+  fixed anchors with changing ranges
+  prepared_anchor_triple against calling trilaterate each time,
+  then the same prepared_anchor_triple shared by several threads
+  every 1000th triple has one of A B inside the other, so the statuses of those failures are compared too
+
+  usage : trilaterate_prepared_bench.exe [num_solves] [num_threads]
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_prepared.hpp"
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_solves = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+   unsigned const num_threads = (argc > 2) ? std::strtoul(argv[2],nullptr,10) : 4;
+
+   sphere const A{{4.3_km, 5_km,6_km},7.5_km};
+   sphere const B{{13_km, 4.5_km, 5.5_km},5.0_km};
+   sphere const C{{10_km,11_km,5.6_km},7.0_km};
+
+   // ranges from random tags to the fixed anchors
+   auto triples = make_random_triples(num_solves);
+   for ( std::size_t n = 0; n < num_solves; ++n){
+      point const tag = triples.tag[n];
+      triples.set(0,n,sphere{A.centre,magnitude(tag - A.centre)});
+      triples.set(1,n,sphere{B.centre,magnitude(tag - B.centre)});
+      triples.set(2,n,sphere{C.centre,magnitude(tag - C.centre)});
+   }
+   // every containment_step th triple has B containing A, at tangency or beyond, or A containing B
+   std::size_t constexpr containment_step = 1000;
+   auto const distAB = magnitude(B.centre - A.centre);
+   for ( std::size_t n = 0; n < num_solves; n += containment_step){
+      auto const rA = triples.get(0,n).radius;
+      switch ( (n / containment_step) % 3){
+         case 0:
+            triples.set(1,n,sphere{B.centre,distAB + rA});
+            break;
+         case 1:
+            triples.set(1,n,sphere{B.centre,distAB + rA + 1_km});
+            break;
+         default:
+            triples.set(0,n,sphere{A.centre,distAB + triples.get(1,n).radius + 1_km});
+            break;
+      }
+   }
+   auto const & ranges = triples.x;
+
+   point_arrays scalar_result{num_solves};
+   double const scalar_ns = ns_per_item(num_solves,[&]{
+      for ( std::size_t n = 0; n < num_solves; ++n){
+         point ip;
+         scalar_result.status[n] = trilaterate(triples.get(0,n),triples.get(1,n),triples.get(2,n),ip);
+         if ( scalar_result.status[n] == trilaterate_status::solved){
+            scalar_result.x[n] = ip.x;
+            scalar_result.y[n] = ip.y;
+            scalar_result.z[n] = ip.z;
+         }
+      }
+   });
+
+   prepared_anchor_triple const anchors{A.centre,B.centre,C.centre};
+   if (!anchors.is_valid()){
+      std::cout << "invalid anchors\n";
+      return EXIT_FAILURE;
+   }
+
+   auto solve_range = [&](point_arrays & result, std::size_t begin, std::size_t end){
+      for ( std::size_t n = begin; n < end; ++n){
+         point ip;
+         result.status[n] = anchors.trilaterate(ranges[3][n],ranges[7][n],ranges[11][n],ip);
+         if ( result.status[n] == trilaterate_status::solved){
+            result.x[n] = ip.x;
+            result.y[n] = ip.y;
+            result.z[n] = ip.z;
+         }
+      }
+   };
+
+   point_arrays prepared_result{num_solves};
+   double const prepared_ns = ns_per_item(num_solves,[&]{
+      solve_range(prepared_result,0,num_solves);
+   });
+
+   point_arrays threaded_result{num_solves};
+   double const threaded_ns = ns_per_item(num_solves,[&]{
+      std::vector<std::thread> threads;
+      for ( unsigned t = 0; t < num_threads; ++t){
+         threads.emplace_back(solve_range,std::ref(threaded_result),
+            num_solves * t / num_threads, num_solves * (t + 1) / num_threads);
+      }
+      for ( auto & t : threads){
+         t.join();
+      }
+   });
+
+   auto max_diff = 0_km;
+   std::size_t status_mismatch = 0;
+   std::size_t containment_mismatch = 0;
+   for ( std::size_t n = 0; n < num_solves; ++n){
+      if ( ((n % containment_step) == 0) && (prepared_result.status[n] == trilaterate_status::solved)){
+         ++containment_mismatch;
+      }
+      if ( (scalar_result.status[n] != prepared_result.status[n]) 
+            || (threaded_result.status[n] != prepared_result.status[n])){
+         ++status_mismatch;
+      }else if ( prepared_result.status[n] == trilaterate_status::solved){
+         auto const diff = magnitude(scalar_result.get(n) - prepared_result.get(n));
+         if ( diff > max_diff){
+            max_diff = diff;
+         }
+         if ( magnitude(threaded_result.get(n) - prepared_result.get(n)) > 0_km){
+            ++status_mismatch;
+         }
+      }
+   }
+
+   std::cout << "trilaterate ns/solve          = " << scalar_ns << '\n';
+   std::cout << "prepared ns/solve             = " << prepared_ns << " , speedup = " << scalar_ns / prepared_ns << '\n';
+   std::cout << "prepared " << num_threads << " threads ns/solve    = " << threaded_ns << '\n';
+   std::cout << "max difference                = " << max_diff << '\n';
+   std::cout << "mismatches                    = " << status_mismatch << '\n';
+   std::cout << "containment solved            = " << containment_mismatch << '\n';
+
+   return ( (status_mismatch == 0) && (containment_mismatch == 0) && (max_diff < epsilon_km) ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,96 @@
+#ifndef TRILATERATION_TRILATERATE_QUATERNION_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_QUATERNION_HPP_INCLUDED
+
+/*
+  unit quaternion rotation
+
+  made directly from an orthonormal basis, so aligning to the frame of the anchors needs
+  no angles and has none of the loss of accuracy of the Euler rotations when an angle is near +-90 deg.
+  composing is one quaternion product and the inverse is the conjugate
+*/
+
+#include <cmath>
+
+#include <quan/three_d/vect.hpp>
+
+namespace {
+
+   template <typename T>
+   struct unit_quaternion{
+      T w;
+      T x;
+      T y;
+      T z;
+
+      static constexpr unit_quaternion identity() { return unit_quaternion{1,0,0,0};}
+
+      /*
+        the rotation taking ex, ey, ez to the x, y and z axes
+        ex ey ez must be orthonormal and right handed ( ez = ex x ey)
+        the rotation matrix has rows ex ey ez, converted by Shepperd's method
+        from its largest diagonal term for accuracy
+      */
+      template <typename V>
+      static unit_quaternion from_basis(quan::three_d::vect<V> const & ex, quan::three_d::vect<V> const & ey,
+         quan::three_d::vect<V> const & ez)
+      {
+         T const m00 = ex.x, m01 = ex.y, m02 = ex.z;
+         T const m10 = ey.x, m11 = ey.y, m12 = ey.z;
+         T const m20 = ez.x, m21 = ez.y, m22 = ez.z;
+         T const trace = m00 + m11 + m22;
+         if ( trace > 0){
+            T const s = 2 * std::sqrt(trace + 1);
+            return unit_quaternion{s / 4,(m21 - m12) / s,(m02 - m20) / s,(m10 - m01) / s};
+         }
+         if ( (m00 > m11) && (m00 > m22)){
+            T const s = 2 * std::sqrt(1 + m00 - m11 - m22);
+            return unit_quaternion{(m21 - m12) / s,s / 4,(m01 + m10) / s,(m02 + m20) / s};
+         }
+         if ( m11 > m22){
+            T const s = 2 * std::sqrt(1 + m11 - m00 - m22);
+            return unit_quaternion{(m02 - m20) / s,(m01 + m10) / s,s / 4,(m12 + m21) / s};
+         }
+         T const s = 2 * std::sqrt(1 + m22 - m00 - m11);
+         return unit_quaternion{(m10 - m01) / s,(m02 + m20) / s,(m12 + m21) / s,s / 4};
+      }
+
+      // v rotated, v may be a point, a displacement or a direction
+      // v + 2w (u x v) + 2 u x (u x v) where u is x y z
+      template <typename V>
+      quan::three_d::vect<V> rotate(quan::three_d::vect<V> const & v) const
+      {
+         V const tx = 2 * (y * v.z - z * v.y);
+         V const ty = 2 * (z * v.x - x * v.z);
+         V const tz = 2 * (x * v.y - y * v.x);
+         return quan::three_d::vect<V>{
+            v.x + w * tx + (y * tz - z * ty),
+            v.y + w * ty + (z * tx - x * tz),
+            v.z + w * tz + (x * ty - y * tx)
+         };
+      }
+
+      // the inverse rotation
+      constexpr unit_quaternion conjugate() const { return unit_quaternion{w,-x,-y,-z};}
+
+      // rotation by b and then a
+      friend constexpr unit_quaternion operator*(unit_quaternion const & a, unit_quaternion const & b)
+      {
+         return unit_quaternion{
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+            a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+         };
+      }
+
+      // rescale to unit length, after many compositions
+      unit_quaternion normalised() const
+      {
+         T const n = std::sqrt(w * w + x * x + y * y + z * z);
+         return unit_quaternion{w / n,x / n,y / n,z / n};
+      }
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_QUATERNION_HPP_INCLUDED
@@ -0,0 +1,464 @@
+#ifndef TRILATERATION_TRILATERATE_RING_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_RING_HPP_INCLUDED
+
+/*
+  lock free bounded rings for handing measurement records from ingest threads to solver threads,
+  and a pipeline stage that drains a ring in batches into trilaterate_batch_simd and pushes the positions to another
+
+     mpsc_ring<measurement_record> in{4096};
+     spsc_ring<position_record> out{4096};
+     trilaterate_ring_stage<mpsc_ring<measurement_record>,spsc_ring<position_record> > stage{in,out};
+
+     radio threads   : in.push<ring_overflow::drop_oldest>(record);
+     solver thread   : stage.run(stop);
+     result thread   : out.try_pop(positions,max_positions);
+
+  spsc_ring  one producer and one consumer thread, wait free, no read modify write
+             each side keeps a copy of the index of the other, so only reads it again when the ring looks full or empty
+  mpsc_ring  any number of producers and one consumer, each slot has a sequence number ( Vyukov's bounded queue).
+             popping is also safe from the producers, which is how drop_oldest makes room
+
+  what push does when the ring is full
+     block        wait, with backoff, until the consumer makes room ( backpressure)
+     drop_newest  drop the record pushed
+     drop_oldest  drop the oldest record in the ring, mpsc_ring only
+
+  capacities are rounded up to a power of 2, all memory is allocated on construction
+  a stage can also take its arrays from a solve_arena ( trilaterate_arena.hpp)
+  the indices of the producers and the consumer are on their own cache lines, as is each slot of mpsc_ring
+
+  x86 only ( pause in the backoff)
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include <immintrin.h>
+
+#include "trilaterate_arena.hpp"
+
+namespace {
+
+   std::size_t constexpr cache_line_size = 64;
+
+   enum class ring_overflow { block, drop_newest, drop_oldest };
+
+   inline std::size_t ring_capacity(std::size_t capacity)
+   {
+      std::size_t result = 2;
+      while ( result < capacity){
+         result *= 2;
+      }
+      return result;
+   }
+
+   // spin, then pause for longer, then yield the core
+   class ring_backoff{
+   public:
+      ring_backoff() : m_count{0}{}
+
+      void pause()
+      {
+         if ( m_count < 6){
+            for ( int n = 0; n < (1 << m_count); ++n){
+               _mm_pause();
+            }
+            ++m_count;
+         }else{
+            std::this_thread::yield();
+         }
+      }
+
+      void reset() { m_count = 0;}
+   private:
+      int m_count;
+   };
+
+   template <typename T>
+   class spsc_ring{
+   public:
+      typedef T value_type;
+
+      explicit spsc_ring(std::size_t capacity)
+      : m_mask{ring_capacity(capacity) - 1}, m_slots{new T[m_mask + 1]}{}
+
+      spsc_ring(spsc_ring const &) = delete;
+      spsc_ring& operator = (spsc_ring const &) = delete;
+
+      std::size_t capacity() const { return m_mask + 1;}
+
+      // producer
+      bool try_push(T const & item)
+      {
+         std::size_t const tail = m_producer.tail.load(std::memory_order_relaxed);
+         if ( (tail - m_producer.cached_head) == capacity()){
+            m_producer.cached_head = m_consumer.head.load(std::memory_order_acquire);
+            if ( (tail - m_producer.cached_head) == capacity()){
+               return false;
+            }
+         }
+         m_slots[tail & m_mask] = item;
+         m_producer.tail.store(tail + 1,std::memory_order_release);
+         return true;
+      }
+
+      // producer, returns false if item was dropped
+      template <ring_overflow Overflow>
+      bool push(T const & item)
+      {
+         static_assert(Overflow != ring_overflow::drop_oldest,"drop_oldest needs a ring the producer can pop, use mpsc_ring");
+         if ( Overflow == ring_overflow::block){
+            ring_backoff backoff;
+            while ( !try_push(item)){
+               backoff.pause();
+            }
+            return true;
+         }
+         if ( try_push(item)){
+            return true;
+         }
+         m_producer.dropped.store(m_producer.dropped.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+         return false;
+      }
+
+      // consumer, pops up to max items to out, returns the number popped
+      std::size_t try_pop(T * out, std::size_t max)
+      {
+         std::size_t const head = m_consumer.head.load(std::memory_order_relaxed);
+         if ( m_consumer.cached_tail == head){
+            m_consumer.cached_tail = m_producer.tail.load(std::memory_order_acquire);
+            if ( m_consumer.cached_tail == head){
+               return 0;
+            }
+         }
+         std::size_t const n = std::min(max,m_consumer.cached_tail - head);
+         for ( std::size_t i = 0; i < n; ++i){
+            out[i] = m_slots[(head + i) & m_mask];
+         }
+         m_consumer.head.store(head + n,std::memory_order_release);
+         return n;
+      }
+
+      bool try_pop(T & item) { return try_pop(&item,1) == 1;}
+
+      // records dropped by push
+      std::uint64_t num_dropped() const { return m_producer.dropped.load(std::memory_order_relaxed);}
+
+   private:
+
+      struct alignas(cache_line_size) producer_side{
+         std::atomic<std::size_t> tail{0};
+         std::size_t cached_head = 0;
+         std::atomic<std::uint64_t> dropped{0};
+      };
+
+      struct alignas(cache_line_size) consumer_side{
+         std::atomic<std::size_t> head{0};
+         std::size_t cached_tail = 0;
+      };
+
+      producer_side m_producer;
+      consumer_side m_consumer;
+      std::size_t const m_mask;
+      std::unique_ptr<T[]> m_slots;
+   };
+
+   template <typename T>
+   class mpsc_ring{
+   public:
+      typedef T value_type;
+
+      explicit mpsc_ring(std::size_t capacity)
+      : m_mask{ring_capacity(capacity) - 1}, m_slots{new slot[m_mask + 1]}
+      {
+         for ( std::size_t n = 0; n <= m_mask; ++n){
+            m_slots[n].sequence.store(n,std::memory_order_relaxed);
+         }
+      }
+
+      mpsc_ring(mpsc_ring const &) = delete;
+      mpsc_ring& operator = (mpsc_ring const &) = delete;
+
+      std::size_t capacity() const { return m_mask + 1;}
+
+      // any thread
+      bool try_push(T const & item)
+      {
+         std::size_t pos = m_tail.value.load(std::memory_order_relaxed);
+         for (;;){
+            slot & s = m_slots[pos & m_mask];
+            std::size_t const sequence = s.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::ptrdiff_t>(sequence - pos);
+            if ( diff == 0){
+               if ( m_tail.value.compare_exchange_weak(pos,pos + 1,std::memory_order_relaxed)){
+                  s.item = item;
+                  s.sequence.store(pos + 1,std::memory_order_release);
+                  return true;
+               }
+            }else if ( diff < 0){
+               // full
+               return false;
+            }else{
+               pos = m_tail.value.load(std::memory_order_relaxed);
+            }
+         }
+      }
+
+      // any thread, returns false if item or an older record was dropped
+      template <ring_overflow Overflow>
+      bool push(T const & item)
+      {
+         if ( Overflow == ring_overflow::block){
+            ring_backoff backoff;
+            while ( !try_push(item)){
+               backoff.pause();
+            }
+            return true;
+         }
+         if ( Overflow == ring_overflow::drop_newest){
+            if ( try_push(item)){
+               return true;
+            }
+            m_dropped.value.fetch_add(1,std::memory_order_relaxed);
+            return false;
+         }
+         bool dropped = false;
+         while ( !try_push(item)){
+            T oldest;
+            if ( try_pop(&oldest,1) == 1){
+               m_dropped.value.fetch_add(1,std::memory_order_relaxed);
+               dropped = true;
+            }
+         }
+         return !dropped;
+      }
+
+      // the consumer, or a producer dropping the oldest records
+      // pops up to max items to out, returns the number popped
+      std::size_t try_pop(T * out, std::size_t max)
+      {
+         std::size_t pos = m_head.value.load(std::memory_order_relaxed);
+         for (;;){
+            // the run of filled slots from pos
+            std::size_t n = 0;
+            while ( (n < max) && (m_slots[(pos + n) & m_mask].sequence.load(std::memory_order_acquire) == (pos + n + 1))){
+               ++n;
+            }
+            if ( n == 0){
+               std::size_t const head = m_head.value.load(std::memory_order_relaxed);
+               if ( head == pos){
+                  return 0;
+               }
+               pos = head;
+               continue;
+            }
+            if ( m_head.value.compare_exchange_weak(pos,pos + n,std::memory_order_relaxed)){
+               for ( std::size_t i = 0; i < n; ++i){
+                  slot & s = m_slots[(pos + i) & m_mask];
+                  out[i] = s.item;
+                  s.sequence.store(pos + i + m_mask + 1,std::memory_order_release);
+               }
+               return n;
+            }
+         }
+      }
+
+      bool try_pop(T & item) { return try_pop(&item,1) == 1;}
+
+      // records dropped by push
+      std::uint64_t num_dropped() const { return m_dropped.value.load(std::memory_order_relaxed);}
+
+   private:
+
+      struct alignas(cache_line_size) slot{
+         std::atomic<std::size_t> sequence;
+         T item;
+      };
+
+      struct alignas(cache_line_size) padded_index{
+         std::atomic<std::size_t> value{0};
+      };
+
+      padded_index m_tail;
+      padded_index m_head;
+      padded_index m_dropped;
+      std::size_t const m_mask;
+      std::unique_ptr<slot[]> m_slots;
+   };
+
+   // the ranges of one tag
+   struct measurement_record{
+      std::uint64_t id;
+      sphere spheres[3];
+   };
+
+   struct position_record{
+      std::uint64_t id;
+      point position;              // 0 unless status is solved
+      trilaterate_status status;
+   };
+
+   // solves up to max_batch measurement records at a time with trilaterate_batch_simd, through arrays allocated once
+   class measurement_record_solver{
+   public:
+      // the most bytes of arena used
+      static constexpr std::size_t arena_size(std::size_t max_batch)
+      {
+         return 15 * solve_arena::size_for<quan::length::km>(max_batch) + solve_arena::size_for<trilaterate_status>(max_batch);
+      }
+
+      explicit measurement_record_solver(std::size_t max_batch)
+      : m_buffer{new unsigned char[arena_size(max_batch)]}, m_max_batch{max_batch}
+      {
+         solve_arena arena{m_buffer.get(),arena_size(max_batch)};
+         allocate(arena);
+      }
+
+      // the arrays are from arena, check is_valid for room
+      measurement_record_solver(std::size_t max_batch, solve_arena & arena)
+      : m_max_batch{max_batch}
+      {
+         allocate(arena);
+      }
+
+      measurement_record_solver(measurement_record_solver const &) = delete;
+      measurement_record_solver& operator = (measurement_record_solver const &) = delete;
+
+      bool is_valid() const { return m_status != nullptr;}
+      std::size_t max_batch() const { return m_max_batch;}
+
+      // n must be at most max_batch, out may be in
+      void solve(measurement_record const * in, std::size_t n, position_record * out)
+      {
+         auto column = [this](int c){ return m_columns + c * m_max_batch;};
+         for ( std::size_t r = 0; r < n; ++r){
+            for ( int s = 0; s < 3; ++s){
+               sphere const & sp = in[r].spheres[s];
+               column(4 * s)[r] = sp.centre.x;
+               column(4 * s + 1)[r] = sp.centre.y;
+               column(4 * s + 2)[r] = sp.centre.z;
+               column(4 * s + 3)[r] = sp.radius;
+            }
+         }
+         auto view = [&](int s){ return sphere_soa{column(4 * s),column(4 * s + 1),column(4 * s + 2),column(4 * s + 3)};};
+         sphere_triple_soa const triples{n,view(0),view(1),view(2)};
+         point_soa const points{column(12),column(13),column(14)};
+         trilaterate_batch_simd(triples,points,m_status);
+
+         for ( std::size_t r = 0; r < n; ++r){
+            position_record result;
+            result.id = in[r].id;
+            result.status = m_status[r];
+            // the point arrays are only written for solved records
+            result.position = ( result.status == trilaterate_status::solved)
+               ? point{points.x[r],points.y[r],points.z[r]}
+               : point{0_km,0_km,0_km};
+            out[r] = result;
+         }
+      }
+
+   private:
+
+      void allocate(solve_arena & arena)
+      {
+         m_columns = arena.allocate<quan::length::km>(15 * m_max_batch);
+         m_status = (m_columns != nullptr) ? arena.allocate<trilaterate_status>(m_max_batch) : nullptr;
+      }
+
+      // unless from an arena
+      std::unique_ptr<unsigned char[]> m_buffer;
+      std::size_t const m_max_batch;
+      // ax .. cr then the results x y z, max_batch each
+      quan::length::km * m_columns;
+      trilaterate_status * m_status;
+   };
+
+   /*
+     takes up to max_batch records from in at a time, solves them together and pushes the positions to out
+     with Overflow, so with drop_newest or drop_oldest a slow consumer of the positions does not hold up the solver.
+     one thread runs a stage, the counts are for that thread, or after it has stopped
+   */
+   template <typename InRing, typename OutRing, ring_overflow Overflow = ring_overflow::block>
+   class trilaterate_ring_stage{
+   public:
+
+      // the most bytes of arena used
+      static constexpr std::size_t arena_size(std::size_t max_batch)
+      {
+         return measurement_record_solver::arena_size(max_batch) + solve_arena::size_for<measurement_record>(max_batch)
+            + solve_arena::size_for<position_record>(max_batch);
+      }
+
+      trilaterate_ring_stage(InRing & in, OutRing & out, std::size_t max_batch = 256)
+      : m_in(in), m_out(out), m_buffer{new unsigned char[arena_size(max_batch)]}
+      , m_arena{m_buffer.get(),arena_size(max_batch)}, m_solver{max_batch,m_arena}
+      , m_records{m_arena.allocate<measurement_record>(max_batch)}, m_positions{m_arena.allocate<position_record>(max_batch)}
+      , m_num_records{0}, m_num_batches{0}{}
+
+      // the arrays are from arena, check is_valid for room
+      trilaterate_ring_stage(InRing & in, OutRing & out, solve_arena & arena, std::size_t max_batch = 256)
+      : m_in(in), m_out(out), m_arena{nullptr,0}, m_solver{max_batch,arena}
+      , m_records{arena.allocate<measurement_record>(max_batch)}, m_positions{arena.allocate<position_record>(max_batch)}
+      , m_num_records{0}, m_num_batches{0}{}
+
+      trilaterate_ring_stage(trilaterate_ring_stage const &) = delete;
+      trilaterate_ring_stage& operator = (trilaterate_ring_stage const &) = delete;
+
+      bool is_valid() const { return m_solver.is_valid() && (m_records != nullptr) && (m_positions != nullptr);}
+
+      // solve one batch of the records waiting, returns the number of records
+      std::size_t run_once()
+      {
+         std::size_t const n = m_in.try_pop(m_records,m_solver.max_batch());
+         if ( n == 0){
+            return 0;
+         }
+         m_solver.solve(m_records,n,m_positions);
+         for ( std::size_t r = 0; r < n; ++r){
+            m_out.template push<Overflow>(m_positions[r]);
+         }
+         m_num_records += n;
+         ++m_num_batches;
+         return n;
+      }
+
+      // run_once until stop is set and in is empty
+      void run(std::atomic<bool> const & stop)
+      {
+         ring_backoff backoff;
+         for (;;){
+            if ( run_once() > 0){
+               backoff.reset();
+            }else if ( stop.load(std::memory_order_acquire)){
+               if ( run_once() == 0){
+                  return;
+               }
+            }else{
+               backoff.pause();
+            }
+         }
+      }
+
+      std::uint64_t num_records() const { return m_num_records;}
+      std::uint64_t num_batches() const { return m_num_batches;}
+
+   private:
+      InRing & m_in;
+      OutRing & m_out;
+      // unless from an arena
+      std::unique_ptr<unsigned char[]> m_buffer;
+      solve_arena m_arena;
+      measurement_record_solver m_solver;
+      measurement_record * m_records;
+      position_record * m_positions;
+      std::uint64_t m_num_records;
+      std::uint64_t m_num_batches;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_RING_HPP_INCLUDED
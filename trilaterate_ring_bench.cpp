@@ -0,0 +1,211 @@
+/*
+  spsc_ring and mpsc_ring against a queue behind a mutex, then the whole ring pipeline
+
+  queues   : producers push num_records measurement records, blocking when full,
+             one consumer pops them up to 256 at a time. reports records/s
+  pipeline : producers push random sphere triples to an mpsc_ring, a trilaterate_ring_stage solves them
+             to an spsc_ring and a consumer checks the positions against trilaterate_batch_simd run here.
+             run with each overflow policy at the input, the stage blocking at the output.
+             reports records/s, records dropped, the mean batch and mismatches
+
+  usage : trilaterate_ring_bench.exe [num_records] [num_producers]
+     defaults 4000000 records, 4 producers
+*/
+
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_ring.hpp"
+
+namespace {
+
+   typedef std::chrono::steady_clock clock;
+
+   // the queue the rings replace
+   template <typename T>
+   class mutex_queue{
+   public:
+      explicit mutex_queue(std::size_t capacity) : m_capacity{capacity}{}
+
+      template <ring_overflow Overflow>
+      bool push(T const & item)
+      {
+         static_assert(Overflow == ring_overflow::block,"only block is timed");
+         ring_backoff backoff;
+         for (;;){
+            {
+               std::lock_guard<std::mutex> lock{m_mutex};
+               if ( m_items.size() < m_capacity){
+                  m_items.push_back(item);
+                  return true;
+               }
+            }
+            backoff.pause();
+         }
+      }
+
+      std::size_t try_pop(T * out, std::size_t max)
+      {
+         std::lock_guard<std::mutex> lock{m_mutex};
+         std::size_t const n = std::min(max,m_items.size());
+         std::copy(m_items.begin(),m_items.begin() + n,out);
+         m_items.erase(m_items.begin(),m_items.begin() + n);
+         return n;
+      }
+
+   private:
+      std::mutex m_mutex;
+      std::deque<T> m_items;
+      std::size_t const m_capacity;
+   };
+
+   std::vector<measurement_record> make_records(sphere_triple_arrays const & triples)
+   {
+      std::vector<measurement_record> result(triples.size());
+      for ( std::size_t n = 0; n < triples.size(); ++n){
+         result[n].id = n;
+         for ( int s = 0; s < 3; ++s){
+            result[n].spheres[s] = triples.get(s,n);
+         }
+      }
+      return result;
+   }
+
+   // producer p pushes records p, p + num_producers ..
+   template <ring_overflow Overflow, typename Queue>
+   std::vector<std::thread> start_producers(Queue & queue, std::vector<measurement_record> const & records,
+      std::size_t num_producers, std::size_t num_records)
+   {
+      std::vector<std::thread> producers;
+      for ( std::size_t p = 0; p < num_producers; ++p){
+         producers.emplace_back([&queue,&records,p,num_producers,num_records]{
+            for ( std::size_t n = p; n < num_records; n += num_producers){
+               measurement_record record = records[n % records.size()];
+               record.id = n;
+               queue.template push<Overflow>(record);
+            }
+         });
+      }
+      return producers;
+   }
+
+   template <typename Queue>
+   double records_per_second(std::vector<measurement_record> const & records, std::size_t num_producers, std::size_t num_records)
+   {
+      Queue queue{4096};
+      auto const start = clock::now();
+      auto producers = start_producers<ring_overflow::block>(queue,records,num_producers,num_records);
+      std::vector<measurement_record> out(256);
+      ring_backoff backoff;
+      for ( std::size_t num_popped = 0; num_popped < num_records;){
+         std::size_t const n = queue.try_pop(out.data(),out.size());
+         if ( n > 0){
+            num_popped += n;
+            backoff.reset();
+         }else{
+            backoff.pause();
+         }
+      }
+      for ( auto & t : producers){
+         t.join();
+      }
+      return num_records / std::chrono::duration<double>(clock::now() - start).count();
+   }
+
+   template <ring_overflow Overflow>
+   void run_pipeline(char const * name, sphere_triple_arrays const & triples, point_arrays const & expected,
+      std::size_t num_producers, std::size_t num_records)
+   {
+      auto const records = make_records(triples);
+      mpsc_ring<measurement_record> in{4096};
+      spsc_ring<position_record> out{4096};
+      trilaterate_ring_stage<mpsc_ring<measurement_record>,spsc_ring<position_record> > stage{in,out};
+      std::atomic<bool> stop{false};
+
+      auto const start = clock::now();
+      std::atomic<bool> solver_done{false};
+      std::thread solver{[&]{
+         stage.run(stop);
+         solver_done.store(true,std::memory_order_release);
+      }};
+      auto producers = start_producers<Overflow>(in,records,num_producers,num_records);
+
+      std::uint64_t num_received = 0;
+      std::uint64_t num_solved = 0;
+      std::uint64_t mismatches = 0;
+      std::vector<position_record> positions(256);
+      ring_backoff backoff;
+      auto consume = [&]{
+         std::size_t const n = out.try_pop(positions.data(),positions.size());
+         for ( std::size_t r = 0; r < n; ++r){
+            position_record const & p = positions[r];
+            std::size_t const e = p.id % triples.size();
+            bool const solved = p.status == trilaterate_status::solved;
+            num_solved += solved;
+            if ( p.status != expected.status[e]){
+               ++mismatches;
+            }else if ( solved && (magnitude(p.position - expected.get(e)) > epsilon_km)){
+               ++mismatches;
+            }
+         }
+         num_received += n;
+         return n;
+      };
+      // stop the stage once the producers are done, it then solves what is left in the ring
+      std::thread joiner{[&]{
+         for ( auto & t : producers){
+            t.join();
+         }
+         stop.store(true,std::memory_order_release);
+      }};
+      for (;;){
+         if ( consume() > 0){
+            backoff.reset();
+         }else if ( solver_done.load(std::memory_order_acquire)){
+            while ( consume() > 0){}
+            break;
+         }else{
+            backoff.pause();
+         }
+      }
+      joiner.join();
+      solver.join();
+      double const elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+      std::cout << name << " : records/s = " << num_received / elapsed
+         << ", received = " << num_received << '/' << num_records
+         << ", dropped = " << in.num_dropped()
+         << ", solved = " << num_solved
+         << ", mean batch = " << static_cast<double>(stage.num_records()) / std::max<std::uint64_t>(stage.num_batches(),1)
+         << ", mismatches = " << mismatches << '\n';
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_records = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 4000000;
+   std::size_t const num_producers = (argc > 2) ? std::max(1UL,std::strtoul(argv[2],nullptr,10)) : 4;
+   std::cout << "hardware threads = " << std::thread::hardware_concurrency() << '\n';
+
+   auto const triples = make_random_triples(4096,7);
+   point_arrays expected{triples.size()};
+   trilaterate_batch_simd(triples.soa(),expected.soa(),expected.status.data());
+   auto const records = make_records(triples);
+
+   std::cout << "1 producer, records/s\n";
+   std::cout << "   spsc_ring   = " << records_per_second<spsc_ring<measurement_record> >(records,1,num_records) << '\n';
+   std::cout << "   mpsc_ring   = " << records_per_second<mpsc_ring<measurement_record> >(records,1,num_records) << '\n';
+   std::cout << "   mutex_queue = " << records_per_second<mutex_queue<measurement_record> >(records,1,num_records) << '\n';
+   std::cout << num_producers << " producers, records/s\n";
+   std::cout << "   mpsc_ring   = " << records_per_second<mpsc_ring<measurement_record> >(records,num_producers,num_records) << '\n';
+   std::cout << "   mutex_queue = " << records_per_second<mutex_queue<measurement_record> >(records,num_producers,num_records) << '\n';
+
+   std::cout << "pipeline, " << num_producers << " producers\n";
+   run_pipeline<ring_overflow::block>("   block      ",triples,expected,num_producers,num_records);
+   run_pipeline<ring_overflow::drop_newest>("   drop_newest",triples,expected,num_producers,num_records);
+   run_pipeline<ring_overflow::drop_oldest>("   drop_oldest",triples,expected,num_producers,num_records);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+/*
+  the local solver service, see trilaterate_service.hpp
+  runs until SIGINT or SIGTERM, reporting throughput and latency on stderr
+
+  usage : trilaterate_service.exe [--unix path] [--tcp port] [--max-batch n] [--budget-us n] [--report-s n]
+                                  [--max-queued-kb n]
+     at least one of --unix and --tcp
+     --max-batch  most requests solved together ( default 1024, up to 4096)
+     --budget-us  max latency budget of a request in us ( default 500)
+     --report-s   seconds between reports, 0 for only the report at exit ( default 10)
+     --max-queued-kb  responses waiting on a connection before it is not read ( default 1024)
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "trilaterate_service.hpp"
+
+int main(int argc, char const * argv[])
+{
+   service_options options;
+   for ( int i = 1; i < argc; ++i){
+      bool const has_value = (i + 1) < argc;
+      if ( has_value && (std::strcmp(argv[i],"--unix") == 0)){
+         options.unix_path = argv[++i];
+      }else if ( has_value && (std::strcmp(argv[i],"--tcp") == 0)){
+         options.tcp_port = std::atoi(argv[++i]);
+      }else if ( has_value && (std::strcmp(argv[i],"--max-batch") == 0)){
+         options.max_batch = std::strtoul(argv[++i],nullptr,10);
+      }else if ( has_value && (std::strcmp(argv[i],"--budget-us") == 0)){
+         options.latency_budget = std::chrono::microseconds{std::strtoul(argv[++i],nullptr,10)};
+      }else if ( has_value && (std::strcmp(argv[i],"--report-s") == 0)){
+         options.report_period = std::chrono::seconds{std::strtoul(argv[++i],nullptr,10)};
+      }else if ( has_value && (std::strcmp(argv[i],"--max-queued-kb") == 0)){
+         options.max_queued_bytes = 1024 * std::strtoul(argv[++i],nullptr,10);
+      }else{
+         std::cerr << "usage : trilaterate_service.exe [--unix path] [--tcp port] [--max-batch n] [--budget-us n] [--report-s n]"
+            " [--max-queued-kb n]\n";
+         return EXIT_FAILURE;
+      }
+   }
+   std::unique_ptr<trilaterate_service> service{new trilaterate_service{options}};
+   if ( !service->is_open()){
+      std::cerr << "cant listen, give --unix path and/or --tcp port\n";
+      return EXIT_FAILURE;
+   }
+   std::cerr << "cpu simd level = " << simd_level_name(cpu_simd_level()) << '\n';
+   service->run(std::cerr);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,680 @@
+#ifndef TRILATERATION_TRILATERATE_SERVICE_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_SERVICE_HPP_INCLUDED
+
+/*
+  local solver service
+
+  clients connect to a Unix domain socket or a loopback TCP port and send service_request records,
+  each is answered by a service_response, in order on each connection.
+  records are fixed size in native byte order, since both ends are on one machine
+
+  requests from all connections are coalesced into one batch for trilaterate_batch_simd.
+  a batch is solved when
+     it holds max_batch requests
+     or its oldest request has waited latency_budget, less the expected time to solve the batch
+     or no input is waiting and either the service is busy less than half the time
+        or fewer requests are expected before that deadline than the batch holds
+  so at low rates a request is solved as soon as it arrives, and at high rates batches grow to amortise the solve
+  and the reads and writes. the time between requests, the time handling a request and the time solving it
+  are moving averages
+
+  the latency of a request is from reading it to writing its response to the socket
+
+  a client that sends without reading its responses is not read from while more than max_queued_bytes
+  of responses are waiting for it, so the responses queued for one connection are bounded by that
+  plus one batch
+
+  Linux only ( epoll, timerfd and signalfd)
+*/
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "trilaterate_stream.hpp"
+
+namespace {
+
+   struct service_request{
+      std::uint64_t id;       // returned in the response
+      double sphere[12];      // ax ay az ar bx .. cr in km
+   };
+
+   struct service_response{
+      std::uint64_t id;
+      double position[3];     // x y z in km, 0 unless solved
+      std::uint8_t status;    // trilaterate_status
+      std::uint8_t reserved[7];
+   };
+
+   static_assert(sizeof(service_request) == 104,"service_request is the wire format");
+   static_assert(sizeof(service_response) == 40,"service_response is the wire format");
+
+   struct service_options{
+      char const * unix_path = nullptr;   // nullptr for none
+      int tcp_port = 0;                   // 0 for none, listens on 127.0.0.1 only
+      std::size_t max_batch = 1024;       // up to stream_batch_size
+      std::chrono::nanoseconds latency_budget = std::chrono::microseconds{500};
+      std::chrono::nanoseconds report_period = std::chrono::seconds{10};   // 0 for only the report at exit
+      std::size_t max_queued_bytes = 1 << 20;   // responses waiting on one connection before it is not read
+   };
+
+   // latencies in ns in the log linear buckets of trilaterate_metrics.hpp
+   struct latency_histogram{
+
+      void add(std::uint64_t ns)
+      {
+         ++count;
+         max_ns = std::max(max_ns,ns);
+         ++buckets[latency_bucket(ns)];
+      }
+
+      void add(latency_histogram const & other)
+      {
+         count += other.count;
+         max_ns = std::max(max_ns,other.max_ns);
+         for ( int b = 0; b < latency_num_buckets; ++b){
+            buckets[b] += other.buckets[b];
+         }
+      }
+
+      double quantile_ns(double q) const { return latency_quantile(buckets.data(),count,max_ns,q);}
+
+      std::uint64_t count = 0;
+      std::uint64_t max_ns = 0;
+      std::array<std::uint64_t,latency_num_buckets> buckets = {};
+   };
+
+   // a blocking connection to the service, -1 on failure
+   inline int service_connect_unix(char const * path)
+   {
+      int const fd = ::socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC,0);
+      if ( fd < 0){
+         return -1;
+      }
+      sockaddr_un addr;
+      std::memset(&addr,0,sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      std::strncpy(addr.sun_path,path,sizeof(addr.sun_path) - 1);
+      if ( ::connect(fd,reinterpret_cast<sockaddr const *>(&addr),sizeof(addr)) != 0){
+         ::close(fd);
+         return -1;
+      }
+      return fd;
+   }
+
+   inline int service_connect_tcp(int port)
+   {
+      int const fd = ::socket(AF_INET,SOCK_STREAM | SOCK_CLOEXEC,0);
+      if ( fd < 0){
+         return -1;
+      }
+      sockaddr_in addr;
+      std::memset(&addr,0,sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(static_cast<std::uint16_t>(port));
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      if ( ::connect(fd,reinterpret_cast<sockaddr const *>(&addr),sizeof(addr)) != 0){
+         ::close(fd);
+         return -1;
+      }
+      int const one = 1;
+      ::setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&one,sizeof(one));
+      return fd;
+   }
+
+   class trilaterate_service{
+      typedef std::chrono::steady_clock clock;
+   public:
+
+      explicit trilaterate_service(service_options const & options)
+      : m_options(options), m_epoll{::epoll_create1(EPOLL_CLOEXEC)}, m_unix_fd{-1}, m_unix_dev{0}, m_unix_ino{0}, m_tcp_fd{-1}
+      , m_timer_fd{::timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK | TFD_CLOEXEC)}, m_signal_fd{-1}
+      , m_next_serial{first_connection_key}, m_batch{new measurement_batch}
+      , m_num_read{0}, m_ns_per_request{1e9}, m_busy_ns_per_request{0.0}, m_solve_ns_per_request{20.0}
+      , m_last_arrival{clock::now()}
+      , m_timer_armed{false}, m_stop{false}
+      {
+         m_options.max_batch = std::max(std::size_t{1},std::min(m_options.max_batch,stream_batch_size));
+         watch(m_timer_fd,timer_key,EPOLLIN);
+         if ( m_options.unix_path != nullptr){
+            m_unix_fd = listen_unix(m_options.unix_path,m_unix_dev,m_unix_ino);
+            watch(m_unix_fd,unix_key,EPOLLIN);
+         }
+         if ( m_options.tcp_port != 0){
+            m_tcp_fd = listen_tcp(m_options.tcp_port);
+            watch(m_tcp_fd,tcp_key,EPOLLIN);
+         }
+      }
+
+      ~trilaterate_service()
+      {
+         for ( auto & c : m_connections){
+            ::close(c.second->fd);
+         }
+         for ( int fd : {m_unix_fd,m_tcp_fd,m_timer_fd,m_signal_fd,m_epoll}){
+            if ( fd >= 0){
+               ::close(fd);
+            }
+         }
+         // only the socket this instance bound, not one since put in its place
+         struct stat st;
+         if ( (m_unix_fd >= 0) && (::lstat(m_options.unix_path,&st) == 0) 
+               && S_ISSOCK(st.st_mode) && (st.st_dev == m_unix_dev) && (st.st_ino == m_unix_ino)){
+            ::unlink(m_options.unix_path);
+         }
+      }
+
+      trilaterate_service(trilaterate_service const &) = delete;
+      trilaterate_service& operator = (trilaterate_service const &) = delete;
+
+      // listening on each socket asked for
+      bool is_open() const
+      {
+         return (m_epoll >= 0) && (m_timer_fd >= 0)
+            && ((m_options.unix_path == nullptr) || (m_unix_fd >= 0))
+            && ((m_options.tcp_port == 0) || (m_tcp_fd >= 0))
+            && ((m_unix_fd >= 0) || (m_tcp_fd >= 0));
+      }
+
+      // serve until SIGINT or SIGTERM, writing reports to report
+      void run(std::ostream & report)
+      {
+         sigset_t signals;
+         sigemptyset(&signals);
+         sigaddset(&signals,SIGINT);
+         sigaddset(&signals,SIGTERM);
+         ::sigprocmask(SIG_BLOCK,&signals,nullptr);
+         m_signal_fd = ::signalfd(-1,&signals,SFD_NONBLOCK | SFD_CLOEXEC);
+         watch(m_signal_fd,signal_key,EPOLLIN);
+
+         auto const start = clock::now();
+         m_report_start = start;
+         std::array<epoll_event,64> events;
+         while ( !m_stop){
+            int timeout_ms = -1;
+            if ( m_options.report_period.count() > 0){
+               auto const next_report = m_report_start + m_options.report_period;
+               timeout_ms = static_cast<int>(std::max<std::int64_t>(0,
+                  std::chrono::duration_cast<std::chrono::milliseconds>(next_report - clock::now()).count() + 1));
+            }
+            int const num_events = ::epoll_wait(m_epoll,events.data(),events.size(),timeout_ms);
+            if ( (num_events < 0) && (errno != EINTR)){
+               break;
+            }
+            auto const round_start = clock::now();
+            std::uint64_t const num_read = m_num_read;
+            for ( int e = 0; e < num_events; ++e){
+               handle(events[e]);
+            }
+            // all input read, so decide whether to wait for more
+            if ( m_batch->size > 0){
+               auto const now = clock::now();
+               auto const deadline = batch_deadline();
+               if ( (now >= deadline) || !worth_waiting(now,deadline)){
+                  flush();
+               }else{
+                  arm_timer(deadline);
+               }
+            }
+            if ( m_num_read > num_read){
+               double const busy_ns = std::chrono::duration<double,std::nano>(clock::now() - round_start).count()
+                  / (m_num_read - num_read);
+               m_busy_ns_per_request += (busy_ns - m_busy_ns_per_request) / 16;
+            }
+            if ( (m_options.report_period.count() > 0) && (clock::now() >= (m_report_start + m_options.report_period))){
+               write_report(report,"interval",m_interval,clock::now() - m_report_start);
+               m_total.add(m_interval);
+               m_interval = stats{};
+               m_report_start = clock::now();
+            }
+         }
+         flush();
+         m_total.add(m_interval);
+         write_report(report,"total",m_total,clock::now() - start);
+      }
+
+   private:
+
+      // epoll keys that are not connections
+      enum : std::uint64_t { unix_key, tcp_key, timer_key, signal_key, first_connection_key };
+
+      static std::size_t constexpr in_buffer_size = 64 * sizeof(service_request);
+
+      struct connection{
+         int fd;
+         std::uint64_t serial;
+         std::size_t in_size;
+         std::array<char,in_buffer_size> in;
+         std::vector<char> out;
+         std::size_t out_begin;
+         bool want_write;
+         // false while the responses waiting are over max_queued_bytes
+         bool reading;
+         bool touched;
+      };
+
+      struct stats{
+         void add(stats const & other)
+         {
+            requests += other.requests;
+            batches += other.batches;
+            latency.add(other.latency);
+         }
+         std::uint64_t requests = 0;
+         std::uint64_t batches = 0;
+         latency_histogram latency;
+      };
+
+      void watch(int fd, std::uint64_t key, std::uint32_t flags)
+      {
+         if ( (fd >= 0) && (m_epoll >= 0)){
+            epoll_event ev;
+            ev.events = flags;
+            ev.data.u64 = key;
+            ::epoll_ctl(m_epoll,EPOLL_CTL_ADD,fd,&ev);
+         }
+      }
+
+      // a socket at path that refuses connections, left by a run that did not unlink it
+      static bool is_stale_unix_socket(sockaddr_un const & addr)
+      {
+         struct stat st;
+         if ( (::lstat(addr.sun_path,&st) != 0) || !S_ISSOCK(st.st_mode)){
+            return false;
+         }
+         int const fd = ::socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC,0);
+         if ( fd < 0){
+            return false;
+         }
+         bool const refused = (::connect(fd,reinterpret_cast<sockaddr const *>(&addr),sizeof(addr)) != 0) 
+            && (errno == ECONNREFUSED);
+         ::close(fd);
+         return refused;
+      }
+
+      // dev and ino identify the socket file bound, for the destructor
+      // fails if path is anything but a stale socket, rather than remove a file or take over a live service
+      static int listen_unix(char const * path, dev_t & dev, ino_t & ino)
+      {
+         int const fd = ::socket(AF_UNIX,SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,0);
+         if ( fd < 0){
+            return -1;
+         }
+         sockaddr_un addr;
+         std::memset(&addr,0,sizeof(addr));
+         addr.sun_family = AF_UNIX;
+         if ( std::strlen(path) >= sizeof(addr.sun_path)){
+            ::close(fd);
+            return -1;
+         }
+         std::strcpy(addr.sun_path,path);
+         if ( is_stale_unix_socket(addr)){
+            ::unlink(path);
+         }
+         if ( ::bind(fd,reinterpret_cast<sockaddr const *>(&addr),sizeof(addr)) != 0){
+            ::close(fd);
+            return -1;
+         }
+         struct stat st;
+         if ( (::listen(fd,SOMAXCONN) != 0) || (::lstat(path,&st) != 0)){
+            ::unlink(path);
+            ::close(fd);
+            return -1;
+         }
+         dev = st.st_dev;
+         ino = st.st_ino;
+         return fd;
+      }
+
+      static int listen_tcp(int port)
+      {
+         int const fd = ::socket(AF_INET,SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,0);
+         if ( fd < 0){
+            return -1;
+         }
+         int const one = 1;
+         ::setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,&one,sizeof(one));
+         sockaddr_in addr;
+         std::memset(&addr,0,sizeof(addr));
+         addr.sin_family = AF_INET;
+         addr.sin_port = htons(static_cast<std::uint16_t>(port));
+         addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+         if ( (::bind(fd,reinterpret_cast<sockaddr const *>(&addr),sizeof(addr)) != 0) || (::listen(fd,SOMAXCONN) != 0)){
+            ::close(fd);
+            return -1;
+         }
+         return fd;
+      }
+
+      void handle(epoll_event const & ev)
+      {
+         switch (ev.data.u64){
+            case unix_key:
+               accept_all(m_unix_fd,false);
+               break;
+            case tcp_key:
+               accept_all(m_tcp_fd,true);
+               break;
+            case timer_key:{
+               std::uint64_t expirations;
+               while ( ::read(m_timer_fd,&expirations,sizeof(expirations)) > 0){}
+               m_timer_armed = false;
+               break;
+            }
+            case signal_key:
+               m_stop = true;
+               break;
+            default:{
+               auto const iter = m_connections.find(ev.data.u64);
+               if ( iter == m_connections.end()){
+                  break;
+               }
+               connection & c = *iter->second;
+               if ( (ev.events & EPOLLOUT) != 0){
+                  write_responses(c);
+               }
+               if ( (ev.events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0){
+                  read_requests(c);
+               }
+               break;
+            }
+         }
+      }
+
+      void accept_all(int listen_fd, bool tcp)
+      {
+         for (;;){
+            int const fd = ::accept4(listen_fd,nullptr,nullptr,SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if ( fd < 0){
+               return;
+            }
+            if ( tcp){
+               int const one = 1;
+               ::setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&one,sizeof(one));
+            }
+            std::unique_ptr<connection> c{new connection};
+            c->fd = fd;
+            c->serial = m_next_serial++;
+            c->in_size = 0;
+            c->out_begin = 0;
+            c->want_write = false;
+            c->reading = true;
+            c->touched = false;
+            watch(fd,c->serial,EPOLLIN);
+            m_connections.emplace(c->serial,std::move(c));
+         }
+      }
+
+      void close_connection(connection & c)
+      {
+         ::epoll_ctl(m_epoll,EPOLL_CTL_DEL,c.fd,nullptr);
+         ::close(c.fd);
+         // requests of c still in the batch are dropped when it is solved
+         m_connections.erase(c.serial);
+      }
+
+      // read and batch requests until the socket would block or too many responses are waiting
+      // reads at least once, so a hang up is seen while reading is paused
+      void read_requests(connection & c)
+      {
+         for (;;){
+            ssize_t const num_read = ::recv(c.fd,c.in.data() + c.in_size,in_buffer_size - c.in_size,0);
+            if ( num_read <= 0){
+               if ( (num_read < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))){
+                  return;
+               }
+               if ( (num_read < 0) && (errno == EINTR)){
+                  continue;
+               }
+               close_connection(c);
+               return;
+            }
+            c.in_size += num_read;
+            std::size_t const num_requests = c.in_size / sizeof(service_request);
+            if ( num_requests > 0){
+               note_arrivals(num_requests);
+            }
+            for ( std::size_t r = 0; r < num_requests; ++r){
+               service_request request;
+               std::memcpy(&request,c.in.data() + r * sizeof(service_request),sizeof(request));
+               add_request(c,request);
+            }
+            std::size_t const used = num_requests * sizeof(service_request);
+            std::memmove(c.in.data(),c.in.data() + used,c.in_size - used);
+            c.in_size -= used;
+            if ( !c.reading){
+               // resumed by set_want_write as the responses drain
+               return;
+            }
+         }
+      }
+
+      void note_arrivals(std::size_t num_requests)
+      {
+         auto const now = clock::now();
+         double const ns = std::chrono::duration<double,std::nano>(now - m_last_arrival).count() / num_requests;
+         m_ns_per_request += (ns - m_ns_per_request) / 16;
+         m_last_arrival = now;
+         m_num_read += num_requests;
+      }
+
+      void add_request(connection const & c, service_request const & request)
+      {
+         std::size_t const n = m_batch->size;
+         if ( n == 0){
+            m_first_arrival = m_last_arrival;
+         }
+         for ( int s = 0; s < 3; ++s){
+            double const * const v = request.sphere + 4 * s;
+            m_batch->set(s,sphere{point{quan::length::km{v[0]},quan::length::km{v[1]},quan::length::km{v[2]}},quan::length::km{v[3]}});
+         }
+         m_ids[n] = request.id;
+         m_serials[n] = c.serial;
+         m_arrivals[n] = m_last_arrival;
+         ++m_batch->size;
+         if ( m_batch->size == m_options.max_batch){
+            flush();
+         }
+      }
+
+      // when the oldest request of the batch must be solved to meet the latency budget
+      clock::time_point batch_deadline() const
+      {
+         auto const solve_ns = static_cast<std::int64_t>(m_solve_ns_per_request * m_batch->size);
+         return m_first_arrival + m_options.latency_budget - std::chrono::nanoseconds{solve_ns};
+      }
+
+      // the service is busy at least half the time,
+      // and enough requests are expected before the deadline to at least double the batch
+      bool worth_waiting(clock::time_point now, clock::time_point deadline) const
+      {
+         if ( (2 * m_busy_ns_per_request) < m_ns_per_request){
+            return false;
+         }
+         double const wait_ns = std::chrono::duration<double,std::nano>(deadline - now).count();
+         return (wait_ns / m_ns_per_request) >= m_batch->size;
+      }
+
+      void arm_timer(clock::time_point deadline)
+      {
+         // steady_clock is CLOCK_MONOTONIC on Linux
+         auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+         itimerspec spec;
+         std::memset(&spec,0,sizeof(spec));
+         spec.it_value.tv_sec = ns / 1000000000;
+         spec.it_value.tv_nsec = ns % 1000000000;
+         ::timerfd_settime(m_timer_fd,TFD_TIMER_ABSTIME,&spec,nullptr);
+         m_timer_armed = true;
+      }
+
+      void disarm_timer()
+      {
+         if ( m_timer_armed){
+            itimerspec spec;
+            std::memset(&spec,0,sizeof(spec));
+            ::timerfd_settime(m_timer_fd,0,&spec,nullptr);
+            m_timer_armed = false;
+         }
+      }
+
+      // solve the batch and queue the responses
+      void flush()
+      {
+         std::size_t const size = m_batch->size;
+         if ( size == 0){
+            return;
+         }
+         auto const start = clock::now();
+         trilaterate_batch_simd(m_batch->soa(),m_batch->result(),m_batch->status.data());
+         for ( std::size_t n = 0; n < size; ++n){
+            auto const iter = m_connections.find(m_serials[n]);
+            if ( iter == m_connections.end()){
+               continue;
+            }
+            service_response response;
+            std::memset(&response,0,sizeof(response));
+            response.id = m_ids[n];
+            auto const status = m_batch->status[n];
+            if ( status == trilaterate_status::solved){
+               response.position[0] = m_batch->ox[n].numeric_value();
+               response.position[1] = m_batch->oy[n].numeric_value();
+               response.position[2] = m_batch->oz[n].numeric_value();
+            }
+            response.status = static_cast<std::uint8_t>(status);
+            connection & c = *iter->second;
+            char const * const bytes = reinterpret_cast<char const *>(&response);
+            c.out.insert(c.out.end(),bytes,bytes + sizeof(response));
+            if ( !c.touched){
+               c.touched = true;
+               m_touched.push_back(&c);
+            }
+         }
+         auto const solved = clock::now();
+         double const solve_ns = std::chrono::duration<double,std::nano>(solved - start).count() / size;
+         m_solve_ns_per_request += (solve_ns - m_solve_ns_per_request) / 16;
+
+         for ( connection * c : m_touched){
+            c->touched = false;
+            write_responses(*c);
+         }
+         m_touched.clear();
+
+         auto const written = clock::now();
+         for ( std::size_t n = 0; n < size; ++n){
+            m_interval.latency.add(std::chrono::duration_cast<std::chrono::nanoseconds>(written - m_arrivals[n]).count());
+         }
+         m_interval.requests += size;
+         ++m_interval.batches;
+         m_batch->size = 0;
+         disarm_timer();
+      }
+
+      // write queued responses until done or the socket would block
+      void write_responses(connection & c)
+      {
+         while ( c.out_begin < c.out.size()){
+            ssize_t const num_written = ::send(c.fd,c.out.data() + c.out_begin,c.out.size() - c.out_begin,MSG_NOSIGNAL);
+            if ( num_written < 0){
+               if ( errno == EINTR){
+                  continue;
+               }
+               if ( (errno == EAGAIN) || (errno == EWOULDBLOCK)){
+                  // drop what was sent once it is most of the queue, so a slow reader does not grow it
+                  if ( c.out_begin > (c.out.size() / 2)){
+                     c.out.erase(c.out.begin(),c.out.begin() + c.out_begin);
+                     c.out_begin = 0;
+                  }
+                  set_want_write(c,true);
+               }
+               // other errors are seen as a hang up on the next read
+               return;
+            }
+            c.out_begin += num_written;
+         }
+         c.out.clear();
+         c.out_begin = 0;
+         set_want_write(c,false);
+      }
+
+      // also watches for input only while the responses waiting are under max_queued_bytes
+      void set_want_write(connection & c, bool want_write)
+      {
+         bool const reading = (c.out.size() - c.out_begin) < m_options.max_queued_bytes;
+         if ( (c.want_write != want_write) || (c.reading != reading)){
+            c.want_write = want_write;
+            c.reading = reading;
+            epoll_event ev;
+            ev.events = (reading ? std::uint32_t{EPOLLIN} : 0u) | (want_write ? std::uint32_t{EPOLLOUT} : 0u);
+            ev.data.u64 = c.serial;
+            ::epoll_ctl(m_epoll,EPOLL_CTL_MOD,c.fd,&ev);
+         }
+      }
+
+      void write_report(std::ostream & out, char const * name, stats const & s, clock::duration elapsed) const
+      {
+         double const seconds = std::chrono::duration<double>(elapsed).count();
+         out << name << " : requests = " << s.requests
+            << ", requests/s = " << ((seconds > 0) ? s.requests / seconds : 0.0)
+            << ", batches = " << s.batches
+            << ", mean batch = " << ((s.batches > 0) ? static_cast<double>(s.requests) / s.batches : 0.0)
+            << ", latency us p50 = " << s.latency.quantile_ns(0.5) / 1000
+            << ", p99 = " << s.latency.quantile_ns(0.99) / 1000
+            << ", max = " << s.latency.max_ns / 1000.0
+            << ", connections = " << m_connections.size() << std::endl;
+      }
+
+      service_options m_options;
+      int m_epoll;
+      int m_unix_fd;
+      dev_t m_unix_dev;
+      ino_t m_unix_ino;
+      int m_tcp_fd;
+      int m_timer_fd;
+      int m_signal_fd;
+      std::uint64_t m_next_serial;
+      std::unordered_map<std::uint64_t,std::unique_ptr<connection> > m_connections;
+      // connections with responses queued by flush
+      std::vector<connection *> m_touched;
+
+      // the batch, with the request id, connection and arrival time of each request
+      std::unique_ptr<measurement_batch> m_batch;
+      std::array<std::uint64_t,stream_batch_size> m_ids;
+      std::array<std::uint64_t,stream_batch_size> m_serials;
+      std::array<clock::time_point,stream_batch_size> m_arrivals;
+
+      std::uint64_t m_num_read;
+      // moving averages, of the time between requests, the time handling each request and solving each request
+      double m_ns_per_request;
+      double m_busy_ns_per_request;
+      double m_solve_ns_per_request;
+      clock::time_point m_last_arrival;
+      clock::time_point m_first_arrival;
+
+      bool m_timer_armed;
+      bool m_stop;
+      clock::time_point m_report_start;
+      stats m_interval;
+      stats m_total;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_SERVICE_HPP_INCLUDED
@@ -0,0 +1,215 @@
+#ifndef TRILATERATION_TRILATERATE_SIMD_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_SIMD_HPP_INCLUDED
+
+/*
+  AVX2 and AVX-512 versions of trilaterate_batch
+  the instruction set is picked at runtime, falling back to the scalar trilaterate_batch
+  verify and z failures become lane masks rather than early returns,
+  and the status of a failed lane is the first of its masks to fail, as trilaterate_batch
+  double and float value types are supported, float doubling the lanes per register
+
+  gcc or clang on x86 only
+*/
+
+#include <immintrin.h>
+
+#include "trilaterate_batch.hpp"
+
+namespace {
+
+   static_assert(sizeof(quan::length::km) == sizeof(double),"simd kernel loads quan::length::km as double");
+   static_assert(sizeof(km_<float>) == sizeof(float),"simd kernel loads km_<float> as float");
+
+   enum class simd_level { scalar, avx2, avx512 };
+
+   inline char const * simd_level_name(simd_level level)
+   {
+      switch (level){
+         case simd_level::avx512:
+            return "avx512";
+         case simd_level::avx2:
+            return "avx2";
+         default:
+            return "scalar";
+      }
+   }
+
+   inline simd_level detect_simd_level()
+   {
+      __builtin_cpu_init();
+      if ( __builtin_cpu_supports("avx512f")){
+         return simd_level::avx512;
+      }
+      if ( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+         return simd_level::avx2;
+      }
+      return simd_level::scalar;
+   }
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+   namespace avx2 {
+
+      namespace f64 {
+
+         struct lanes{
+            typedef quan::length::km length;
+            typedef double scalar;
+            typedef __m256d reg;
+            typedef __m256d mask;
+            static constexpr int width = 4;
+            static reg load(double const * p) { return _mm256_loadu_pd(p);}
+            static void store(double * p, mask m, reg v) { _mm256_maskstore_pd(p,_mm256_castpd_si256(m),v);}
+            static reg set1(double v) { return _mm256_set1_pd(v);}
+            static reg zero() { return _mm256_setzero_pd();}
+            static reg add(reg a, reg b) { return _mm256_add_pd(a,b);}
+            static reg sub(reg a, reg b) { return _mm256_sub_pd(a,b);}
+            static reg mul(reg a, reg b) { return _mm256_mul_pd(a,b);}
+            static reg div(reg a, reg b) { return _mm256_div_pd(a,b);}
+            static reg max(reg a, reg b) { return _mm256_max_pd(a,b);}
+            static reg sqrt(reg a) { return _mm256_sqrt_pd(a);}
+            static mask lt(reg a, reg b) { return _mm256_cmp_pd(a,b,_CMP_LT_OQ);}
+            static mask ge(reg a, reg b) { return _mm256_cmp_pd(a,b,_CMP_GE_OQ);}
+            static mask mask_and(mask a, mask b) { return _mm256_and_pd(a,b);}
+            static int bits(mask m) { return _mm256_movemask_pd(m);}
+         };
+
+#include "trilaterate_simd_kernel.ipp"
+
+      } // f64
+
+      namespace f32 {
+
+         struct lanes{
+            typedef km_<float> length;
+            typedef float scalar;
+            typedef __m256 reg;
+            typedef __m256 mask;
+            static constexpr int width = 8;
+            static reg load(float const * p) { return _mm256_loadu_ps(p);}
+            static void store(float * p, mask m, reg v) { _mm256_maskstore_ps(p,_mm256_castps_si256(m),v);}
+            static reg set1(float v) { return _mm256_set1_ps(v);}
+            static reg zero() { return _mm256_setzero_ps();}
+            static reg add(reg a, reg b) { return _mm256_add_ps(a,b);}
+            static reg sub(reg a, reg b) { return _mm256_sub_ps(a,b);}
+            static reg mul(reg a, reg b) { return _mm256_mul_ps(a,b);}
+            static reg div(reg a, reg b) { return _mm256_div_ps(a,b);}
+            static reg max(reg a, reg b) { return _mm256_max_ps(a,b);}
+            static reg sqrt(reg a) { return _mm256_sqrt_ps(a);}
+            static mask lt(reg a, reg b) { return _mm256_cmp_ps(a,b,_CMP_LT_OQ);}
+            static mask ge(reg a, reg b) { return _mm256_cmp_ps(a,b,_CMP_GE_OQ);}
+            static mask mask_and(mask a, mask b) { return _mm256_and_ps(a,b);}
+            static int bits(mask m) { return _mm256_movemask_ps(m);}
+         };
+
+#include "trilaterate_simd_kernel.ipp"
+
+      } // f32
+
+      using f64::trilaterate_batch;
+      using f32::trilaterate_batch;
+
+   } // avx2
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// gcc 12 false positive on _mm512_undefined_pd in the intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+   namespace avx512 {
+
+      namespace f64 {
+
+         struct lanes{
+            typedef quan::length::km length;
+            typedef double scalar;
+            typedef __m512d reg;
+            typedef __mmask8 mask;
+            static constexpr int width = 8;
+            static reg load(double const * p) { return _mm512_loadu_pd(p);}
+            static void store(double * p, mask m, reg v) { _mm512_mask_storeu_pd(p,m,v);}
+            static reg set1(double v) { return _mm512_set1_pd(v);}
+            static reg zero() { return _mm512_setzero_pd();}
+            static reg add(reg a, reg b) { return _mm512_add_pd(a,b);}
+            static reg sub(reg a, reg b) { return _mm512_sub_pd(a,b);}
+            static reg mul(reg a, reg b) { return _mm512_mul_pd(a,b);}
+            static reg div(reg a, reg b) { return _mm512_div_pd(a,b);}
+            static reg max(reg a, reg b) { return _mm512_max_pd(a,b);}
+            static reg sqrt(reg a) { return _mm512_sqrt_pd(a);}
+            static mask lt(reg a, reg b) { return _mm512_cmp_pd_mask(a,b,_CMP_LT_OQ);}
+            static mask ge(reg a, reg b) { return _mm512_cmp_pd_mask(a,b,_CMP_GE_OQ);}
+            static mask mask_and(mask a, mask b) { return a & b;}
+            static int bits(mask m) { return m;}
+         };
+
+#include "trilaterate_simd_kernel.ipp"
+
+      } // f64
+
+      namespace f32 {
+
+         struct lanes{
+            typedef km_<float> length;
+            typedef float scalar;
+            typedef __m512 reg;
+            typedef __mmask16 mask;
+            static constexpr int width = 16;
+            static reg load(float const * p) { return _mm512_loadu_ps(p);}
+            static void store(float * p, mask m, reg v) { _mm512_mask_storeu_ps(p,m,v);}
+            static reg set1(float v) { return _mm512_set1_ps(v);}
+            static reg zero() { return _mm512_setzero_ps();}
+            static reg add(reg a, reg b) { return _mm512_add_ps(a,b);}
+            static reg sub(reg a, reg b) { return _mm512_sub_ps(a,b);}
+            static reg mul(reg a, reg b) { return _mm512_mul_ps(a,b);}
+            static reg div(reg a, reg b) { return _mm512_div_ps(a,b);}
+            static reg max(reg a, reg b) { return _mm512_max_ps(a,b);}
+            static reg sqrt(reg a) { return _mm512_sqrt_ps(a);}
+            static mask lt(reg a, reg b) { return _mm512_cmp_ps_mask(a,b,_CMP_LT_OQ);}
+            static mask ge(reg a, reg b) { return _mm512_cmp_ps_mask(a,b,_CMP_GE_OQ);}
+            static mask mask_and(mask a, mask b) { return a & b;}
+            static int bits(mask m) { return m;}
+         };
+
+#include "trilaterate_simd_kernel.ipp"
+
+      } // f32
+
+      using f64::trilaterate_batch;
+      using f32::trilaterate_batch;
+
+   } // avx512
+
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+   // the best level the cpu supports, detected once
+   inline simd_level cpu_simd_level()
+   {
+      static simd_level const level = detect_simd_level();
+      return level;
+   }
+
+   // as trilaterate_batch but using the simd kernel for level
+   // level must be supported by the cpu
+   // Length is quan::length::km or km_<float>
+   template <typename Length>
+   inline std::size_t trilaterate_batch_simd(basic_sphere_triple_soa<Length> const & in, basic_point_soa<Length> const & out, 
+      trilaterate_status * status, simd_level level = cpu_simd_level())
+   {
+      switch (level){
+         case simd_level::avx512:
+            return avx512::trilaterate_batch(in,out,status);
+         case simd_level::avx2:
+            return avx2::trilaterate_batch(in,out,status);
+         default:
+            return trilaterate_batch(in,out,status);
+      }
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_SIMD_HPP_INCLUDED
@@ -0,0 +1,73 @@
+/*
+  trilaterate_batch_simd at each simd level the cpu supports
+  against the scalar trilaterate_batch over the same random sphere triples,
+  with C on or within epsilon of the line through A and B in every 1000th triple
+  fails on a difference over epsilon or a status mismatch on a collinear triple
+
+  usage : trilaterate_simd_bench.exe [num_triples]
+*/
+
+#include <cstdlib>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_simd.hpp"
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_triples = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+   // results must match the scalar path within this
+   auto constexpr tolerance = epsilon_km;
+
+   auto triples = make_random_triples(num_triples);
+   // every collinear_step th triple has C on the line through A and B, or within epsilon of it
+   std::size_t constexpr collinear_step = 1000;
+   for ( std::size_t n = 0; n < num_triples; n += collinear_step){
+      sphere const A = triples.get(0,n);
+      sphere const B = triples.get(1,n);
+      point const offset = (n % (2 * collinear_step) == 0) ? point{0_km,0_km,0_km} : point{0_km,0_km,epsilon_km / 2};
+      point const centre = A.centre + 0.25 * (B.centre - A.centre) + offset;
+      triples.set(2,n,sphere{centre,magnitude(triples.tag[n] - centre)});
+   }
+
+   point_arrays scalar_result{num_triples};
+   double const scalar_ns = ns_per_item(num_triples,[&]{
+      trilaterate_batch(triples.soa(),scalar_result.soa(),scalar_result.status.data());
+   });
+   std::cout << "cpu simd level = " << simd_level_name(cpu_simd_level()) << '\n';
+   std::cout << "scalar ns/solve = " << scalar_ns << '\n';
+
+   bool success = true;
+   for ( auto level : {simd_level::avx2, simd_level::avx512}){
+      if ( level > cpu_simd_level()){
+         continue;
+      }
+      point_arrays result{num_triples};
+      double const ns = ns_per_item(num_triples,[&]{
+         trilaterate_batch_simd(triples.soa(),result.soa(),result.status.data(),level);
+      });
+      auto max_diff = 0_km;
+      std::size_t status_mismatch = 0;
+      std::size_t collinear_mismatch = 0;
+      for ( std::size_t n = 0; n < num_triples; ++n){
+         if ( scalar_result.status[n] != result.status[n]){
+            ++status_mismatch;
+            collinear_mismatch += (n % collinear_step) == 0;
+         }else if ( result.status[n] == trilaterate_status::solved){
+            auto const diff = magnitude(scalar_result.get(n) - result.get(n));
+            if ( diff > max_diff){
+               max_diff = diff;
+            }
+         }
+      }
+      std::cout << simd_level_name(level) << " ns/solve = " << ns 
+         << ", speedup = " << scalar_ns / ns 
+         << ", max difference = " << max_diff
+         << ", status mismatches = " << status_mismatch 
+         << ", of collinear C = " << collinear_mismatch << '\n';
+      if ( (max_diff > tolerance) || (collinear_mismatch > 0)){
+         success = false;
+      }
+   }
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
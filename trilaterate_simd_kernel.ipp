@@ -0,0 +1,172 @@
+/*
+  lane kernel for trilaterate_simd.hpp
+  included once per instruction set and value type, inside a namespace that defines struct lanes
+  and with the matching #pragma GCC target in effect
+*/
+
+   typedef typename lanes::length length;
+   typedef typename lanes::scalar scalar;
+
+   inline typename lanes::reg load(length const * p)
+   {
+      return lanes::load(reinterpret_cast<scalar const *>(p));
+   }
+
+   inline typename lanes::reg magnitude(typename lanes::reg x, typename lanes::reg y, typename lanes::reg z)
+   {
+      return lanes::sqrt(lanes::add(lanes::add(lanes::mul(x,x),lanes::mul(y,y)),lanes::mul(z,z)));
+   }
+
+   // the failure of each test of trilaterate_element, in the order it makes them
+   constexpr trilaterate_status lane_test_failure[] = {
+      trilaterate_status::coincident_AB, trilaterate_status::no_intersection_AB,
+      trilaterate_status::coincident_BC, trilaterate_status::no_intersection_BC,
+      trilaterate_status::coincident_AC, trilaterate_status::no_intersection_AC,
+      trilaterate_status::no_intersection_AB,   // one of A B inside the other, in ll_trilaterate
+      trilaterate_status::degenerate_C, trilaterate_status::negative_z_squared
+   };
+   constexpr int num_lane_tests = sizeof(lane_test_failure) / sizeof(lane_test_failure[0]);
+
+   // status[0 .. width) from the lanes passing each test and the failure of each test
+   // a lane passing every test is solved, otherwise it has the failure of the first test it did not pass
+   // returns the mask of lanes solved
+   template <int NumTests>
+   inline typename lanes::mask lane_status(typename lanes::mask const (&pass)[NumTests], trilaterate_status const (&failure)[NumTests],
+      trilaterate_status * status)
+   {
+      typename lanes::mask ok = pass[0];
+      for ( int t = 1; t < NumTests; ++t){
+         ok = lanes::mask_and(ok,pass[t]);
+      }
+      int const solved = lanes::bits(ok);
+      for ( int l = 0; l < lanes::width; ++l){
+         status[l] = trilaterate_status::solved;
+      }
+      // only failed lanes look for their first failed test
+      int const all = (1 << lanes::width) - 1;
+      if ( solved != all){
+         int pass_bits[NumTests];
+         for ( int t = 0; t < NumTests; ++t){
+            pass_bits[t] = lanes::bits(pass[t]);
+         }
+         for ( int l = 0; l < lanes::width; ++l){
+            if ( (solved & (1 << l)) == 0){
+               int t = 0;
+               while ( (t < NumTests - 1) && ((pass_bits[t] & (1 << l)) != 0)){
+                  ++t;
+               }
+               status[l] = failure[t];
+            }
+         }
+      }
+      return ok;
+   }
+
+   // trilaterate_verify and ll_trilaterate over lanes::width triples at n
+   // the normalised frame is the basis ex, ey, ez from the translated centres
+   // so the result maps back as A + x * ex + y * ey + z * ez
+   // status[0 .. width) is set to the status of each lane, the first test it failed as trilaterate_element
+   // returns the mask of lanes solved
+   inline int trilaterate_lanes(basic_sphere_triple_soa<length> const & in, std::size_t n, basic_point_soa<length> const & out,
+      trilaterate_status * status)
+   {
+      typedef typename lanes::reg reg;
+      typedef typename lanes::mask mask;
+
+      reg const ax = load(in.A.x + n);
+      reg const ay = load(in.A.y + n);
+      reg const az = load(in.A.z + n);
+      reg const ar = load(in.A.radius + n);
+      reg const br = load(in.B.radius + n);
+      reg const cr = load(in.C.radius + n);
+
+      // translate so that A is at origin
+      reg const bx = lanes::sub(load(in.B.x + n),ax);
+      reg const by = lanes::sub(load(in.B.y + n),ay);
+      reg const bz = lanes::sub(load(in.B.z + n),az);
+      reg const cx = lanes::sub(load(in.C.x + n),ax);
+      reg const cy = lanes::sub(load(in.C.y + n),ay);
+      reg const cz = lanes::sub(load(in.C.z + n),az);
+
+      // verify
+      reg const eps = lanes::set1(epsilon<length>().numeric_value());
+      reg const distAB = magnitude(bx,by,bz);
+      reg const distAC = magnitude(cx,cy,cz);
+      reg const distBC = magnitude(lanes::sub(cx,bx),lanes::sub(cy,by),lanes::sub(cz,bz));
+
+      // normalised frame
+      reg const d = distAB;
+      reg const exx = lanes::div(bx,d);
+      reg const exy = lanes::div(by,d);
+      reg const exz = lanes::div(bz,d);
+      reg const i = lanes::add(lanes::add(lanes::mul(exx,cx),lanes::mul(exy,cy)),lanes::mul(exz,cz));
+      reg const tx = lanes::sub(cx,lanes::mul(i,exx));
+      reg const ty = lanes::sub(cy,lanes::mul(i,exy));
+      reg const tz = lanes::sub(cz,lanes::mul(i,exz));
+      reg const j = magnitude(tx,ty,tz);
+      reg const eyx = lanes::div(tx,j);
+      reg const eyy = lanes::div(ty,j);
+      reg const eyz = lanes::div(tz,j);
+      reg const ezx = lanes::sub(lanes::mul(exy,eyz),lanes::mul(exz,eyy));
+      reg const ezy = lanes::sub(lanes::mul(exz,eyx),lanes::mul(exx,eyz));
+      reg const ezz = lanes::sub(lanes::mul(exx,eyy),lanes::mul(exy,eyx));
+
+      // ll_trilaterate
+      reg const two = lanes::set1(scalar{2});
+      reg const ar2 = lanes::mul(ar,ar);
+      reg const x = lanes::div(
+         lanes::add(lanes::sub(ar2,lanes::mul(br,br)),lanes::mul(d,d)),
+         lanes::mul(two,d)
+      );
+      reg const y = lanes::sub(
+         lanes::div(
+            lanes::add(lanes::add(lanes::sub(ar2,lanes::mul(cr,cr)),lanes::mul(i,i)),lanes::mul(j,j)),
+            lanes::mul(two,j)
+         ),
+         lanes::mul(lanes::div(i,j),x)
+      );
+      reg const z_2 = lanes::sub(lanes::sub(ar2,lanes::mul(x,x)),lanes::mul(y,y));
+      reg const z = lanes::sqrt(lanes::max(z_2,lanes::zero()));
+
+      // the lanes passing each test of lane_test_failure
+      mask const pass[num_lane_tests] = {
+         lanes::ge(distAB,eps), lanes::lt(distAB,lanes::add(ar,br)),
+         lanes::ge(distBC,eps), lanes::lt(distBC,lanes::add(br,cr)),
+         lanes::ge(distAC,eps), lanes::lt(distAC,lanes::add(ar,cr)),
+         lanes::lt(br,lanes::add(d,ar)),
+         lanes::ge(j,eps), lanes::ge(z_2,lanes::zero())
+      };
+      mask const ok = lane_status(pass,lane_test_failure,status);
+
+      // A + x * ex + y * ey + z * ez
+      lanes::store(reinterpret_cast<scalar *>(out.x + n),ok,
+         lanes::add(lanes::add(lanes::add(ax,lanes::mul(x,exx)),lanes::mul(y,eyx)),lanes::mul(z,ezx)));
+      lanes::store(reinterpret_cast<scalar *>(out.y + n),ok,
+         lanes::add(lanes::add(lanes::add(ay,lanes::mul(x,exy)),lanes::mul(y,eyy)),lanes::mul(z,ezy)));
+      lanes::store(reinterpret_cast<scalar *>(out.z + n),ok,
+         lanes::add(lanes::add(lanes::add(az,lanes::mul(x,exz)),lanes::mul(y,eyz)),lanes::mul(z,ezz)));
+
+      return lanes::bits(ok);
+   }
+
+   inline std::size_t trilaterate_batch(basic_sphere_triple_soa<length> const & in, basic_point_soa<length> const & out, 
+      trilaterate_status * status)
+   {
+      std::size_t num_solved = 0;
+      std::size_t n = 0;
+      for ( ; (n + lanes::width) <= in.size; n += lanes::width){
+         num_solved += __builtin_popcount(trilaterate_lanes(in,n,out,status + n));
+      }
+      // remainder
+      for ( ; n < in.size; ++n){
+         quan::three_d::vect<length> ip;
+         status[n] = trilaterate_element(get_sphere(in.A,n),get_sphere(in.B,n),get_sphere(in.C,n),ip);
+         if ( status[n] == trilaterate_status::solved){
+            out.x[n] = ip.x;
+            out.y[n] = ip.y;
+            out.z[n] = ip.z;
+            ++num_solved;
+         }
+      }
+      return num_solved;
+   }
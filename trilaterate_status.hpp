@@ -0,0 +1,71 @@
+#ifndef TRILATERATION_TRILATERATE_STATUS_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_STATUS_HPP_INCLUDED
+
+/*
+  result codes of trilaterate
+*/
+
+#include <cstdint>
+
+namespace {
+
+   // result of a solve, a failure gives the first test that failed
+   enum class trilaterate_status : std::uint8_t {
+      solved,
+      coincident_AB,
+      no_intersection_AB,
+      coincident_BC,
+      no_intersection_BC,
+      coincident_AC,
+      no_intersection_AC,
+      degenerate_C,          // C is on the line through A and B
+      negative_z_squared,    // the spheres intersect in pairs but not all three together
+      out_of_range,          // a centre or radius is outside the fixed point working volume
+      ambiguous,             // two positions fit the measurements about as well ( tdoa with 4 anchors)
+      no_fit                 // least squares did not converge or left a residual over the limit
+   };
+
+   constexpr int num_trilaterate_status = 12;
+
+   inline char const * trilaterate_status_message(trilaterate_status status)
+   {
+      switch (status){
+         case trilaterate_status::solved:             return "solved";
+         case trilaterate_status::coincident_AB:      return "A and B are coincident";
+         case trilaterate_status::no_intersection_AB: return "A and B dont intersect";
+         case trilaterate_status::coincident_BC:      return "B and C are coincident";
+         case trilaterate_status::no_intersection_BC: return "B and C dont intersect";
+         case trilaterate_status::coincident_AC:      return "A and C are coincident";
+         case trilaterate_status::no_intersection_AC: return "A and C dont intersect";
+         case trilaterate_status::degenerate_C:       return "C is on the line through A and B";
+         case trilaterate_status::negative_z_squared: return "z : no solution";
+         case trilaterate_status::out_of_range:       return "outside the working volume";
+         case trilaterate_status::ambiguous:          return "two positions fit";
+         case trilaterate_status::no_fit:             return "no position fits the ranges";
+         default:                                     return "unknown status";
+      }
+   }
+
+   // status as an identifier for metrics
+   inline char const * trilaterate_status_name(trilaterate_status status)
+   {
+      switch (status){
+         case trilaterate_status::solved:             return "solved";
+         case trilaterate_status::coincident_AB:      return "coincident_AB";
+         case trilaterate_status::no_intersection_AB: return "no_intersection_AB";
+         case trilaterate_status::coincident_BC:      return "coincident_BC";
+         case trilaterate_status::no_intersection_BC: return "no_intersection_BC";
+         case trilaterate_status::coincident_AC:      return "coincident_AC";
+         case trilaterate_status::no_intersection_AC: return "no_intersection_AC";
+         case trilaterate_status::degenerate_C:       return "degenerate_C";
+         case trilaterate_status::negative_z_squared: return "negative_z_squared";
+         case trilaterate_status::out_of_range:       return "out_of_range";
+         case trilaterate_status::ambiguous:          return "ambiguous";
+         case trilaterate_status::no_fit:             return "no_fit";
+         default:                                     return "unknown";
+      }
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_STATUS_HPP_INCLUDED
@@ -0,0 +1,80 @@
+/*
+  streaming trilateration
+  reads range measurement records from a file or stdin and writes positions to stdout
+  see trilaterate_stream.hpp for the record formats
+
+  usage : 
+     trilaterate_stream.exe [input_file]     solve records, report throughput on stderr
+     trilaterate_stream.exe --generate n     write n random records to stdout
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_stream.hpp"
+
+namespace {
+
+   // 16 anchors, then n records, alternating centres and anchor ids
+   void generate(std::size_t num_records, std::FILE * out)
+   {
+      std::size_t constexpr num_anchors = 16;
+      auto const anchors = make_random_triples(num_anchors,3);
+      for ( std::size_t id = 0; id < num_anchors; ++id){
+         auto const c = anchors.get(0,id).centre;
+         std::fprintf(out,"a,%zu,%.6f,%.6f,%.6f\n",id,c.x.numeric_value(),c.y.numeric_value(),c.z.numeric_value());
+      }
+      std::size_t constexpr block = 65536;
+      for ( std::size_t start = 0; start < num_records; start += block){
+         std::size_t const count = std::min(block,num_records - start);
+         auto const triples = make_random_triples(count,static_cast<unsigned>(start + 1));
+         for ( std::size_t n = 0; n < count; ++n){
+            if ( n % 2 == 0){
+               for ( int s = 0; s < 3; ++s){
+                  auto const sp = triples.get(s,n);
+                  std::fprintf(out,"%.6f,%.6f,%.6f,%.6f%s",sp.centre.x.numeric_value(),sp.centre.y.numeric_value(),
+                     sp.centre.z.numeric_value(),sp.radius.numeric_value(), (s < 2) ? "," : "\n");
+               }
+            }else{
+               std::size_t const id = n % num_anchors;
+               std::size_t const ids[] = {id, (id + 5) % num_anchors, (id + 11) % num_anchors};
+               std::fprintf(out,"r");
+               for ( auto i : ids){
+                  std::fprintf(out,",%zu,%.6f",i,magnitude(triples.tag[n] - anchors.get(0,i).centre).numeric_value());
+               }
+               std::fprintf(out,"\n");
+            }
+         }
+      }
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   if ( (argc > 2) && (std::strcmp(argv[1],"--generate") == 0)){
+      generate(std::strtoul(argv[2],nullptr,10),stdout);
+      return EXIT_SUCCESS;
+   }
+
+   std::FILE * in = stdin;
+   if ( argc > 1){
+      in = std::fopen(argv[1],"rb");
+      if ( in == nullptr){
+         std::cerr << "cant open \"" << argv[1] << "\"\n";
+         return EXIT_FAILURE;
+      }
+   }
+   auto const start = std::chrono::steady_clock::now();
+   std::size_t const num_records = trilaterate_stream(in,stdout);
+   std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+   if ( in != stdin){
+      std::fclose(in);
+   }
+   std::cerr << num_records << " records in " << elapsed.count() << " s, " 
+      << num_records / elapsed.count() << " records/s\n";
+   return EXIT_SUCCESS;
+}
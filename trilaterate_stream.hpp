@@ -0,0 +1,500 @@
+#ifndef TRILATERATION_TRILATERATE_STREAM_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_STREAM_HPP_INCLUDED
+
+/*
+  streaming text input of range measurements and output of positions
+
+  input is one record per line, fields separated by commas and/or spaces, lengths in km
+     ax ay az ar bx by bz br cx cy cz cr    centres and ranges of spheres A B C 
+     a id x y z                             centre of anchor id ( 0 <= id < max_anchors)
+     r idA rA idB rB idC rC                 ranges from anchors defined earlier
+     # ...                                  comment
+  blank lines are ignored
+
+  output is one line per measurement record in input order
+     x,y,z,status,reason
+  with x y z empty unless status is stream_solved
+  and reason empty unless status is stream_no_solution, when it is the trilaterate_status_name of the failure
+
+  all buffers are fixed size and allocated up front,
+  so memory use does not depend on the length of the input
+*/
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "trilaterate_simd.hpp"
+
+namespace {
+
+   // status in the output
+   enum stream_status : std::uint8_t { 
+      stream_solved = 0, 
+      stream_no_solution = 1, 
+      stream_bad_record = 2
+   };
+
+   std::size_t constexpr stream_batch_size = 4096;
+   std::size_t constexpr max_anchors = 1024;
+
+   // complete lines from a file through a fixed buffer
+   class line_reader{
+   public:
+      static std::size_t constexpr buffer_size = 1 << 20;
+
+      explicit line_reader(std::FILE * in)
+      : m_in{in}, m_buffer{new char[buffer_size]}, m_begin{0}, m_end{0}, m_eof{false}{}
+
+      // the next line without the end of line
+      // lines longer than buffer_size are split
+      // returns false at end of input
+      bool next(char const * & begin, char const * & end)
+      {
+         for (;;){
+            char * const start = m_buffer.get() + m_begin;
+            auto const nl = static_cast<char *>(std::memchr(start,'\n',m_end - m_begin));
+            if ( nl != nullptr){
+               begin = start;
+               end = nl;
+               m_begin = (nl - m_buffer.get()) + 1;
+               strip_cr(begin,end);
+               return true;
+            }
+            if ( m_eof || ((m_begin == 0) && (m_end == buffer_size)) ){
+               // last line without newline, or a line too long for the buffer
+               if ( m_begin == m_end){
+                  return false;
+               }
+               begin = start;
+               end = m_buffer.get() + m_end;
+               m_begin = m_end;
+               strip_cr(begin,end);
+               return true;
+            }
+            refill();
+         }
+      }
+
+   private:
+
+      static void strip_cr(char const * begin, char const * & end)
+      {
+         if ( (end != begin) && (end[-1] == '\r')){
+            --end;
+         }
+      }
+
+      void refill()
+      {
+         std::memmove(m_buffer.get(),m_buffer.get() + m_begin,m_end - m_begin);
+         m_end -= m_begin;
+         m_begin = 0;
+         std::size_t const num_read = std::fread(m_buffer.get() + m_end,1,buffer_size - m_end,m_in);
+         m_end += num_read;
+         if ( num_read == 0){
+            m_eof = true;
+         }
+      }
+
+      std::FILE * m_in;
+      std::unique_ptr<char[]> m_buffer;
+      std::size_t m_begin;
+      std::size_t m_end;
+      bool m_eof;
+   };
+
+   inline bool is_separator(char c)
+   {
+      return (c == ',') || (c == ' ') || (c == '\t');
+   }
+
+   inline void skip_separators(char const * & p, char const * end)
+   {
+      while ( (p != end) && is_separator(*p)){
+         ++p;
+      }
+   }
+
+   /*
+     appends the run of decimal digits at p to mantissa
+     up to 18 significant digits are kept, which is more than a double holds,
+     the number of digits dropped after that is added to num_dropped
+     8 digits at a time where possible
+     returns the number of digits in the run
+   */
+   inline int parse_digits(char const * & p, char const * end, std::uint64_t & mantissa, int & num_dropped)
+   {
+      static std::uint64_t constexpr pow10[] = {1,10,100,1000,10000,100000,1000000,10000000,100000000};
+      char const * const start = p;
+      while ( ((end - p) >= 8) && (mantissa < 10000000000ULL)){
+         std::uint64_t word;
+         std::memcpy(&word,p,8);
+         // high bit set in bytes that are not '0' to '9'
+         std::uint64_t const non_digits = 
+            ((word + 0x4646464646464646ULL) | (word - 0x3030303030303030ULL)) & 0x8080808080808080ULL;
+         int const num_digits = (non_digits != 0) ? (__builtin_ctzll(non_digits) / 8) : 8;
+         if ( num_digits == 0){
+            return static_cast<int>(p - start);
+         }
+         // the digits as leading zero padded 8 digit number, first digit in the lowest byte
+         std::uint64_t v = ((word - 0x3030303030303030ULL) << (8 * (8 - num_digits))) & 0x0F0F0F0F0F0F0F0FULL;
+         v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFULL;
+         v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFULL;
+         v = (v * 10000 + (v >> 32)) & 0xFFFFFFFFULL;
+         mantissa = mantissa * pow10[num_digits] + v;
+         p += num_digits;
+         if ( num_digits < 8){
+            return static_cast<int>(p - start);
+         }
+      }
+      for ( ; p != end; ++p){
+         unsigned const digit = static_cast<unsigned char>(*p) - static_cast<unsigned>('0');
+         if ( digit >= 10){
+            break;
+         }
+         if ( mantissa < 100000000000000000ULL){
+            mantissa = mantissa * 10 + digit;
+         }else{
+            ++num_dropped;
+         }
+      }
+      return static_cast<int>(p - start);
+   }
+
+   // decimal number with optional sign, fraction and exponent
+   // faster than strtod, but may be out by an ulp
+   inline bool parse_number(char const * & p, char const * end, double & out)
+   {
+      static double constexpr pow10[] = {
+         1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+         1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+      skip_separators(p,end);
+      bool negative = false;
+      if ( (p != end) && ((*p == '-') || (*p == '+'))){
+         negative = (*p == '-');
+         ++p;
+      }
+      std::uint64_t mantissa = 0;
+      int num_dropped = 0;
+      int const num_int_digits = parse_digits(p,end,mantissa,num_dropped);
+      int exponent = num_dropped;
+      int num_fraction_digits = 0;
+      if ( (p != end) && (*p == '.')){
+         ++p;
+         int num_fraction_dropped = 0;
+         num_fraction_digits = parse_digits(p,end,mantissa,num_fraction_dropped);
+         exponent -= num_fraction_digits - num_fraction_dropped;
+      }
+      if ( (num_int_digits + num_fraction_digits) == 0){
+         return false;
+      }
+      if ( (p != end) && ((*p == 'e') || (*p == 'E'))){
+         ++p;
+         bool negative_exponent = false;
+         if ( (p != end) && ((*p == '-') || (*p == '+'))){
+            negative_exponent = (*p == '-');
+            ++p;
+         }
+         if ( (p == end) || (*p < '0') || (*p > '9')){
+            return false;
+         }
+         int e = 0;
+         for ( ; (p != end) && (*p >= '0') && (*p <= '9'); ++p){
+            if ( e < 10000){
+               e = e * 10 + (*p - '0');
+            }
+         }
+         exponent += negative_exponent ? -e : e;
+      }
+      if ( (p != end) && !is_separator(*p)){
+         return false;
+      }
+      double value = static_cast<double>(mantissa);
+      if ( (exponent >= -22) && (exponent <= 22)){
+         value = (exponent < 0) ? value / pow10[-exponent] : value * pow10[exponent];
+      }else{
+         value *= std::pow(10.0,exponent);
+      }
+      out = negative ? -value : value;
+      return true;
+   }
+
+   inline bool parse_km(char const * & p, char const * end, quan::length::km & out)
+   {
+      double v;
+      if ( !parse_number(p,end,v)){
+         return false;
+      }
+      out = quan::length::km{v};
+      return true;
+   }
+
+   inline bool parse_anchor_id(char const * & p, char const * end, std::size_t & id)
+   {
+      double v;
+      if ( !parse_number(p,end,v) || (v < 0) || (v >= max_anchors) || (v != std::floor(v))){
+         return false;
+      }
+      id = static_cast<std::size_t>(v);
+      return true;
+   }
+
+   inline bool at_end(char const * p, char const * end)
+   {
+      skip_separators(p,end);
+      return p == end;
+   }
+
+   // parsed measurements waiting to be solved in one batch
+   struct measurement_batch{
+
+      measurement_batch() : size{0}{}
+
+      sphere_triple_soa soa() const
+      {
+         auto view = [this](int s){ 
+            return sphere_soa{x[4*s].data(),x[4*s+1].data(),x[4*s+2].data(),x[4*s+3].data()};
+         };
+         return sphere_triple_soa{size,view(0),view(1),view(2)};
+      }
+
+      point_soa result() { return point_soa{ox.data(),oy.data(),oz.data()};}
+
+      void set(int s, sphere const & in)
+      {
+         x[4*s][size] = in.centre.x;
+         x[4*s+1][size] = in.centre.y;
+         x[4*s+2][size] = in.centre.z;
+         x[4*s+3][size] = in.radius;
+      }
+
+      bool full() const { return size == stream_batch_size;}
+
+      std::size_t size;
+      // ax,ay,az,ar, bx .. cr
+      std::array<std::array<quan::length::km,stream_batch_size>,12> x;
+      std::array<std::uint8_t,stream_batch_size> bad;
+      std::array<trilaterate_status,stream_batch_size> status;
+      std::array<quan::length::km,stream_batch_size> ox;
+      std::array<quan::length::km,stream_batch_size> oy;
+      std::array<quan::length::km,stream_batch_size> oz;
+   };
+
+   // parses records into a measurement_batch, keeping the anchor table
+   class record_parser{
+   public:
+
+      record_parser() : m_anchor_defined{} {}
+
+      // returns true if the line was a measurement record, good or bad, added to batch
+      bool parse(char const * p, char const * end, measurement_batch & batch)
+      {
+         skip_separators(p,end);
+         if ( (p == end) || (*p == '#')){
+            return false;
+         }
+         std::size_t const n = batch.size;
+         if ( (*p == 'a') || (*p == 'A')){
+            ++p;
+            std::size_t id;
+            point centre;
+            if ( parse_anchor_id(p,end,id) && parse_km(p,end,centre.x) && parse_km(p,end,centre.y) 
+                  && parse_km(p,end,centre.z) && at_end(p,end)){
+               m_anchors[id] = centre;
+               m_anchor_defined[id] = true;
+               return false;
+            }
+            // a bad anchor record is reported in the output
+            add_bad_record(batch);
+            return true;
+         }
+         bool good = true;
+         if ( (*p == 'r') || (*p == 'R')){
+            ++p;
+            for ( int s = 0; (s < 3) && good; ++s){
+               std::size_t id;
+               sphere sp;
+               good = parse_anchor_id(p,end,id) && m_anchor_defined[id] && parse_km(p,end,sp.radius);
+               if ( good){
+                  sp.centre = m_anchors[id];
+                  batch.set(s,sp);
+               }
+            }
+         }else{
+            for ( int s = 0; (s < 3) && good; ++s){
+               sphere sp;
+               good = parse_km(p,end,sp.centre.x) && parse_km(p,end,sp.centre.y) 
+                  && parse_km(p,end,sp.centre.z) && parse_km(p,end,sp.radius);
+               if ( good){
+                  batch.set(s,sp);
+               }
+            }
+         }
+         if ( good && at_end(p,end)){
+            batch.bad[n] = false;
+            ++batch.size;
+         }else{
+            add_bad_record(batch);
+         }
+         return true;
+      }
+
+   private:
+
+      static void add_bad_record(measurement_batch & batch)
+      {
+         for ( int s = 0; s < 3; ++s){
+            batch.set(s,sphere{point{0_km,0_km,0_km},0_km});
+         }
+         batch.bad[batch.size] = true;
+         ++batch.size;
+      }
+
+      std::array<point,max_anchors> m_anchors;
+      std::array<bool,max_anchors> m_anchor_defined;
+   };
+
+   // formatted lines to a file through a fixed buffer
+   class position_writer{
+   public:
+      static std::size_t constexpr buffer_size = 1 << 16;
+
+      explicit position_writer(std::FILE * out)
+      : m_out{out}, m_buffer{new char[buffer_size]}, m_size{0}{}
+
+      ~position_writer() { flush();}
+
+      position_writer(position_writer const &) = delete;
+      position_writer& operator = (position_writer const &) = delete;
+
+      // reason may be nullptr
+      void write(point const * p, stream_status status, char const * reason = nullptr)
+      {
+         // longest line is 3 numbers of 20 digits + point + sign and separators and status and reason
+         if ( (buffer_size - m_size) < 160){
+            flush();
+         }
+         if ( p != nullptr){
+            write_km(p->x);
+            put(',');
+            write_km(p->y);
+            put(',');
+            write_km(p->z);
+            put(',');
+         }else{
+            put(',');
+            put(',');
+            put(',');
+         }
+         put(static_cast<char>('0' + status));
+         put(',');
+         if ( reason != nullptr){
+            std::size_t const len = std::strlen(reason);
+            std::memcpy(&m_buffer[m_size],reason,len);
+            m_size += len;
+         }
+         put('\n');
+      }
+
+      void flush()
+      {
+         if ( m_size > 0){
+            std::fwrite(m_buffer.get(),1,m_size,m_out);
+            m_size = 0;
+         }
+      }
+
+   private:
+
+      void put(char c) { m_buffer[m_size++] = c;}
+
+      // fixed point with 6 decimal places ( mm resolution)
+      void write_km(quan::length::km const & v)
+      {
+         static char constexpr digit_pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+         double const scaled = v.numeric_value() * 1e6;
+         if ( !(std::abs(scaled) < 9e18)){
+            std::memcpy(&m_buffer[m_size],"nan",3);
+            m_size += 3;
+            return;
+         }
+         std::int64_t const rounded = static_cast<std::int64_t>( scaled + ((scaled < 0) ? -0.5 : 0.5));
+         if ( rounded < 0){
+            put('-');
+         }
+         auto mm = static_cast<std::uint64_t>( (rounded < 0) ? -rounded : rounded);
+         // digits from the right, fraction then point then at least one integer digit
+         char digits[24];
+         char * p = digits + sizeof(digits);
+         for ( int n = 0; n < 3; ++n){
+            p -= 2;
+            std::memcpy(p,&digit_pairs[2 * (mm % 100)],2);
+            mm /= 100;
+         }
+         *--p = '.';
+         do {
+            *--p = static_cast<char>('0' + mm % 10);
+            mm /= 10;
+         } while ( mm != 0);
+         std::size_t const len = digits + sizeof(digits) - p;
+         std::memcpy(&m_buffer[m_size],p,len);
+         m_size += len;
+      }
+
+      std::FILE * m_out;
+      std::unique_ptr<char[]> m_buffer;
+      std::size_t m_size;
+   };
+
+   // solve the batch, write the results in order and empty the batch
+   inline void solve_and_write(measurement_batch & batch, position_writer & writer)
+   {
+      trilaterate_batch_simd(batch.soa(),batch.result(),batch.status.data());
+      for ( std::size_t n = 0; n < batch.size; ++n){
+         if ( batch.bad[n]){
+            writer.write(nullptr,stream_bad_record);
+         }else if ( batch.status[n] == trilaterate_status::solved){
+            point const p{batch.ox[n],batch.oy[n],batch.oz[n]};
+            writer.write(&p,stream_solved);
+         }else{
+            writer.write(nullptr,stream_no_solution,trilaterate_status_name(batch.status[n]));
+         }
+      }
+      batch.size = 0;
+   }
+
+   // read records from in until end of input and write positions to out
+   // returns the number of measurement records
+   inline std::size_t trilaterate_stream(std::FILE * in, std::FILE * out)
+   {
+      line_reader reader{in};
+      position_writer writer{out};
+      std::unique_ptr<measurement_batch> batch{new measurement_batch};
+      std::unique_ptr<record_parser> parser{new record_parser};
+      std::size_t num_records = 0;
+      char const * begin;
+      char const * end;
+      while ( reader.next(begin,end)){
+         if ( parser->parse(begin,end,*batch)){
+            ++num_records;
+            if ( batch->full()){
+               solve_and_write(*batch,writer);
+            }
+         }
+      }
+      solve_and_write(*batch,writer);
+      writer.flush();
+      return num_records;
+   }
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_STREAM_HPP_INCLUDED
@@ -0,0 +1,247 @@
+/*
+  benchmark of every solver variant in the repo on the same random geometry
+
+  for each variant and geometry set prints one JSON object per line with
+  ns per solve, solves per second, TSC cycles per solve 
+  and the max distance of the solution from a long double reference solution
+
+  trilateration.cpp only has the normalised frame calc in main, so "2d" is that calc 
+  after a translate and rotate of the circles, on a set of circles in the xy plane
+
+  diagnostic output from the variants is discarded
+
+  usage : trilaterate_suite.exe [num_solves]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <x86intrin.h>
+
+#include <quan/two_d/out/vect.hpp>
+
+#include "trilaterate_bench.hpp"
+#include "trilaterate_simd.hpp"
+#include "trilaterate_suite.hpp"
+
+namespace {
+
+   // high precision reference by Gram-Schmidt basis in long double
+   // in 2D the circles must have z == 0 and the result has z == 0
+   bool reference_solve(double const * in, long double * out, bool two_d)
+   {
+      typedef long double real;
+      real a[3], b[3], c[3];
+      for ( int k = 0; k < 3; ++k){
+         a[k] = in[k];
+         b[k] = real{in[4 + k]} - a[k];
+         c[k] = real{in[8 + k]} - a[k];
+      }
+      real const ra = in[3], rb = in[7], rc = in[11];
+      auto dot = [](real const * u, real const * v){ return u[0]*v[0] + u[1]*v[1] + u[2]*v[2];};
+      real const d = std::sqrt(dot(b,b));
+      real const ex[3] = {b[0] / d, b[1] / d, b[2] / d};
+      real const i = dot(ex,c);
+      real t[3] = {c[0] - i * ex[0], c[1] - i * ex[1], c[2] - i * ex[2]};
+      real const j = std::sqrt(dot(t,t));
+      real const ey[3] = {t[0] / j, t[1] / j, t[2] / j};
+      real const ez[3] = {ex[1]*ey[2] - ex[2]*ey[1], ex[2]*ey[0] - ex[0]*ey[2], ex[0]*ey[1] - ex[1]*ey[0]};
+      real const x = (ra*ra - rb*rb + d*d) / (2 * d);
+      real const y = (ra*ra - rc*rc + i*i + j*j) / (2 * j) - (i / j) * x;
+      real z = 0;
+      if ( !two_d){
+         real const z_2 = ra*ra - x*x - y*y;
+         if ( z_2 < 0){
+            return false;
+         }
+         z = std::sqrt(z_2);
+      }
+      for ( int k = 0; k < 3; ++k){
+         out[k] = a[k] + x * ex[k] + y * ey[k] + z * ez[k];
+      }
+      return true;
+   }
+
+   // the calc from trilateration.cpp, translated and rotated so pA is at origin and pB on the x axis
+   bool solve_2d(double const * in, double * out)
+   {
+      typedef quan::two_d::vect<quan::length::km> point2d;
+      point2d const pA{quan::length::km{in[0]},quan::length::km{in[1]}};
+      point2d const pB1 = point2d{quan::length::km{in[4]},quan::length::km{in[5]}} - pA;
+      point2d const pC1 = point2d{quan::length::km{in[8]},quan::length::km{in[9]}} - pA;
+      auto const rA = quan::length::km{in[3]};
+      auto const rB = quan::length::km{in[7]};
+      auto const rC = quan::length::km{in[11]};
+
+      auto const ux = unit_vector(pB1);
+      // the side of the x axis with pC, so that j is positive
+      auto const uy = ( (ux.x * pC1.y - ux.y * pC1.x) < 0_km)
+         ? decltype(ux){ux.y,-ux.x}
+         : decltype(ux){-ux.y,ux.x};
+      // normalised
+      point2d const pB{dot_product(ux,pB1),0_km};
+      point2d const pC{dot_product(ux,pC1),dot_product(uy,pC1)};
+
+      auto const ex = unit_vector(pB);
+      auto const i = dot_product(ex,pC);
+      auto const ey = unit_vector(pC - i * ex) ;
+      auto const d = magnitude(pB);
+      auto const j = dot_product(ey,pC);
+      auto const x = (quan::pow<2>(rA) - quan::pow<2>(rB) + quan::pow<2>(d)) / ( 2 * d);
+      if ( ((d - rA) >= rB ) || (rB >= (d + rA))){
+         return false;
+      }
+      auto const y =  (
+         ( quan::pow<2>(rA) - quan::pow<2>(rC) + quan::pow<2>(i) + quan::pow<2>(j))
+               / ( 2 * j) 
+                  ) - ( i / j) * x;
+      point2d const p = pA + x * ux + y * uy;
+      out[0] = p.x.numeric_value();
+      out[1] = p.y.numeric_value();
+      out[2] = 0.0;
+      return true;
+   }
+
+   struct geometry_set{
+      char const * name;
+      bool two_d;
+      sphere_triple_arrays triples;
+      // ax ay az ar bx .. cr per solve
+      std::vector<double> aos;
+      std::vector<std::uint8_t> ref_solved;
+      std::vector<long double> ref;
+   };
+
+   geometry_set make_geometry_set(char const * name, std::size_t n, quan::length::km const & noise, bool two_d)
+   {
+      geometry_set set{name,two_d,make_random_triples(n,1,20_km,noise),
+         std::vector<double>(12 * n),std::vector<std::uint8_t>(n),std::vector<long double>(3 * n)};
+      for ( std::size_t k = 0; k < n; ++k){
+         if ( two_d){
+            // project to the xy plane
+            point const tag{set.triples.tag[k].x,set.triples.tag[k].y,0_km};
+            set.triples.tag[k] = tag;
+            for ( int s = 0; s < 3; ++s){
+               point const c = set.triples.get(s,k).centre;
+               point const centre{c.x,c.y,0_km};
+               set.triples.set(s,k,sphere{centre,magnitude(tag - centre)});
+            }
+         }
+         for ( int s = 0; s < 3; ++s){
+            sphere const sp = set.triples.get(s,k);
+            double * const p = &set.aos[12 * k + 4 * s];
+            p[0] = sp.centre.x.numeric_value();
+            p[1] = sp.centre.y.numeric_value();
+            p[2] = sp.centre.z.numeric_value();
+            p[3] = sp.radius.numeric_value();
+         }
+         set.ref_solved[k] = reference_solve(&set.aos[12 * k],&set.ref[3 * k],two_d);
+      }
+      return set;
+   }
+
+   // prints the json line for results in out, solved in status
+   void report(char const * variant, geometry_set const & set, double ns, double cycles,
+      std::vector<double> const & out, std::vector<std::uint8_t> const & status)
+   {
+      std::size_t const n = status.size();
+      std::size_t num_solved = 0;
+      long double max_error = 0;
+      for ( std::size_t k = 0; k < n; ++k){
+         if ( status[k]){
+            ++num_solved;
+            if ( set.ref_solved[k]){
+               long double sum = 0;
+               for ( int c = 0; c < 3; ++c){
+                  long double const diff = out[3 * k + c] - set.ref[3 * k + c];
+                  sum += diff * diff;
+               }
+               max_error = std::max(max_error,std::sqrt(sum));
+            }
+         }
+      }
+      std::printf("{\"variant\":\"%s\",\"geometry\":\"%s\",\"solves\":%zu,\"solved\":%zu,"
+         "\"ns_per_solve\":%.3f,\"solves_per_sec\":%.0f,\"cycles_per_solve\":%.1f,\"max_error_km\":%.3Le}\n",
+         variant,set.name,n,num_solved,ns,1.e9 / ns,cycles,max_error);
+   }
+
+   // time f() over n solves, returns ns and TSC cycles per solve
+   template <typename F>
+   void time_solves(std::size_t n, F f, double & ns, double & cycles)
+   {
+      unsigned long long const start_cycles = __rdtsc();
+      ns = ns_per_item(n,f);
+      cycles = static_cast<double>(__rdtsc() - start_cycles) / n;
+   }
+
+   void run_scalar(char const * variant, suite_solve_fn solve, geometry_set const & set)
+   {
+      std::size_t const n = set.ref_solved.size();
+      std::vector<double> out(3 * n);
+      std::vector<std::uint8_t> status(n);
+      double ns, cycles;
+      time_solves(n,[&]{
+         for ( std::size_t k = 0; k < n; ++k){
+            status[k] = solve(&set.aos[12 * k],&out[3 * k]);
+         }
+      },ns,cycles);
+      report(variant,set,ns,cycles,out,status);
+   }
+
+   template <typename Batch>
+   void run_batch(char const * variant, Batch batch, geometry_set const & set)
+   {
+      std::size_t const n = set.ref_solved.size();
+      point_arrays result{n};
+      double ns, cycles;
+      time_solves(n,[&]{ batch(set.triples.soa(),result.soa(),result.status.data());},ns,cycles);
+      std::vector<double> out(3 * n);
+      std::vector<std::uint8_t> solved(n);
+      for ( std::size_t k = 0; k < n; ++k){
+         out[3 * k] = result.x[k].numeric_value();
+         out[3 * k + 1] = result.y[k].numeric_value();
+         out[3 * k + 2] = result.z[k].numeric_value();
+         solved[k] = result.status[k] == trilaterate_status::solved;
+      }
+      report(variant,set,ns,cycles,out,solved);
+   }
+}
+
+int main(int argc, char const * argv[])
+{
+   std::size_t const num_solves = (argc > 1) ? std::strtoul(argv[1],nullptr,10) : 1000000;
+
+   // discard diagnostic output from the variants
+   std::cout.rdbuf(nullptr);
+
+   std::printf("{\"suite\":\"trilaterate\",\"version\":1,\"simd_level\":\"%s\",\"solves\":%zu}\n",
+      simd_level_name(cpu_simd_level()),num_solves);
+
+   geometry_set const sets[] = {
+      make_geometry_set("exact",num_solves,0_km,false),
+      make_geometry_set("noise_10m",num_solves,0.01_km,false)
+   };
+   for ( auto const & set : sets){
+      run_scalar("transform",suite_solve_transform,set);
+      run_scalar("transform_matrix",suite_solve_transform_matrix,set);
+      run_scalar("minimal_matrix",suite_solve_minimal_matrix,set);
+      run_scalar("minimal_affine",suite_solve_minimal_affine,set);
+      run_scalar("minimal_vect",suite_solve_minimal_vect,set);
+      run_scalar("minimal_basis",suite_solve_minimal_basis,set);
+      run_scalar("minimal_quaternion",suite_solve_minimal_quaternion,set);
+      run_batch("batch",[](sphere_triple_soa const & in, point_soa const & out, trilaterate_status * status){
+         trilaterate_batch(in,out,status);
+      },set);
+      for ( auto level : {simd_level::avx2, simd_level::avx512}){
+         if ( level <= cpu_simd_level()){
+            char variant[32];
+            std::snprintf(variant,sizeof(variant),"simd_%s",simd_level_name(level));
+            run_batch(variant,[level](sphere_triple_soa const & in, point_soa const & out, trilaterate_status * status){
+               trilaterate_batch_simd(in,out,status,level);
+            },set);
+         }
+      }
+   }
+   run_scalar("2d",solve_2d,make_geometry_set("plane_exact",num_solves,0_km,true));
+   return EXIT_SUCCESS;
+}
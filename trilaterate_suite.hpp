@@ -0,0 +1,26 @@
+#ifndef TRILATERATION_TRILATERATE_SUITE_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_SUITE_HPP_INCLUDED
+
+/*
+  solver variants built in their own translation units for trilaterate_suite.cpp
+  each variant has its own point and sphere types, so they are called on plain numbers
+
+  in  : ax ay az ar bx by bz br cx cy cz cr in km
+  out : x y z in km
+  returns false if there is no solution
+*/
+
+typedef bool (*suite_solve_fn)(double const * in, double * out);
+
+// trilateration_transform.cpp
+bool suite_solve_transform(double const * in, double * out);
+// trilateration_transform_matrix.cpp
+bool suite_solve_transform_matrix(double const * in, double * out);
+// trilaterate.hpp with each calc
+bool suite_solve_minimal_matrix(double const * in, double * out);
+bool suite_solve_minimal_affine(double const * in, double * out);
+bool suite_solve_minimal_vect(double const * in, double * out);
+bool suite_solve_minimal_basis(double const * in, double * out);
+bool suite_solve_minimal_quaternion(double const * in, double * out);
+
+#endif // TRILATERATION_TRILATERATE_SUITE_HPP_INCLUDED
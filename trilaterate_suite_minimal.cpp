@@ -0,0 +1,34 @@
+/*
+  trilaterate.hpp with each calc policy as suite variants
+*/
+
+#include "trilaterate.hpp"
+#include "trilaterate_suite.hpp"
+
+namespace {
+
+   template <typename Calc>
+   bool suite_solve_minimal(double const * in, double * out)
+   {
+      auto const get_sphere = [in](int s){
+         return sphere{
+            {quan::length::km{in[4*s]},quan::length::km{in[4*s+1]},quan::length::km{in[4*s+2]}},
+            quan::length::km{in[4*s+3]}
+         };
+      };
+      point p;
+      if ( trilaterate<Calc>(get_sphere(0),get_sphere(1),get_sphere(2),p) != trilaterate_status::solved){
+         return false;
+      }
+      out[0] = p.x.numeric_value();
+      out[1] = p.y.numeric_value();
+      out[2] = p.z.numeric_value();
+      return true;
+   }
+}
+
+bool suite_solve_minimal_matrix(double const * in, double * out) { return suite_solve_minimal<matrix_calc>(in,out);}
+bool suite_solve_minimal_affine(double const * in, double * out) { return suite_solve_minimal<affine_calc>(in,out);}
+bool suite_solve_minimal_vect(double const * in, double * out) { return suite_solve_minimal<vect_calc>(in,out);}
+bool suite_solve_minimal_basis(double const * in, double * out) { return suite_solve_minimal<basis_calc>(in,out);}
+bool suite_solve_minimal_quaternion(double const * in, double * out) { return suite_solve_minimal<quaternion_calc>(in,out);}
@@ -0,0 +1,30 @@
+/*
+  trilateration_transform.cpp as a suite variant
+  its main and output_scad_preamble are renamed out of the way
+*/
+
+#define main trilateration_transform_main
+#define output_scad_preamble trilateration_transform_output_scad_preamble
+#include "trilateration_transform.cpp"
+#undef output_scad_preamble
+#undef main
+
+#include "trilaterate_suite.hpp"
+
+bool suite_solve_transform(double const * in, double * out)
+{
+   auto const get_sphere = [in](int s){
+      return sphere{
+         {quan::length::km{in[4*s]},quan::length::km{in[4*s+1]},quan::length::km{in[4*s+2]}},
+         quan::length::km{in[4*s+3]}
+      };
+   };
+   point p;
+   if ( !trilaterate(get_sphere(0),get_sphere(1),get_sphere(2),p)){
+      return false;
+   }
+   out[0] = p.x.numeric_value();
+   out[1] = p.y.numeric_value();
+   out[2] = p.z.numeric_value();
+   return true;
+}
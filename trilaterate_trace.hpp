@@ -0,0 +1,155 @@
+#ifndef TRILATERATION_TRILATERATE_TRACE_HPP_INCLUDED
+#define TRILATERATION_TRILATERATE_TRACE_HPP_INCLUDED
+
+/*
+  tracers for trilaterate(A,B,C,p,tracer)
+
+  ostream_tracer prints each intermediate value as it is calculated
+  recording_tracer copies each intermediate value into a buffer allocated up front,
+  so a sampled solve in production can be traced and the trace printed later
+
+     recording_tracer tracer;   // one per thread
+     ...
+     if ( sample_this_one){
+        tracer.clear();
+        status = trilaterate(A,B,C,p,tracer);
+        if ( status != trilaterate_status::solved){ keep a copy of tracer}
+     }else{
+        status = trilaterate(A,B,C,p);
+     }
+*/
+
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include <quan/two_d/vect.hpp>
+
+#include "trilaterate.hpp"
+
+namespace {
+
+   class ostream_tracer{
+   public:
+      explicit ostream_tracer(std::ostream & out) : m_out(out){}
+
+      template <typename T>
+      void trace(char const * name, T const & value)
+      {
+         m_out << name << " = " << value << '\n';
+      }
+
+      void trace(char const * name, quan::angle::rad const & value)
+      {
+         m_out << name << " = " << quan::angle::deg{value} << '\n';
+      }
+
+      void status(trilaterate_status status)
+      {
+         m_out << "status = " << trilaterate_status_message(status) << '\n';
+      }
+   private:
+      std::ostream & m_out;
+   };
+
+   class recording_tracer{
+   public:
+
+      enum class value_kind : std::uint8_t { point, direction, angle };
+
+      struct entry{
+         char const * name;
+         value_kind kind;
+         // x y z of a point in km or a direction, or the angle in rad in value[0]
+         double value[3];
+      };
+
+      // a basis or matrix solve traces up to 20 values
+      explicit recording_tracer(std::size_t capacity = 32)
+      : m_entries(capacity), m_size(0), m_overflow(false), m_status(trilaterate_status::solved){}
+
+      void clear()
+      {
+         m_size = 0;
+         m_overflow = false;
+         m_status = trilaterate_status::solved;
+      }
+
+      // a point in km of any value type, or a direction
+      template <typename T>
+      void trace(char const * name, quan::three_d::vect<T> const & v)
+      {
+         push({name,std::is_arithmetic<T>::value ? value_kind::direction : value_kind::point,
+            {numeric(v.x),numeric(v.y),numeric(v.z)}});
+      }
+
+      // a point of trilaterate_2d, with z 0
+      template <typename T>
+      void trace(char const * name, quan::two_d::vect<T> const & v)
+      {
+         push({name,value_kind::point,{numeric(v.x),numeric(v.y),0.0}});
+      }
+
+      void trace(char const * name, quan::angle::rad const & a)
+      {
+         push({name,value_kind::angle,{a.numeric_value(),0.0,0.0}});
+      }
+
+      void status(trilaterate_status status) { m_status = status;}
+
+      std::size_t size() const { return m_size;}
+      entry const & operator[](std::size_t n) const { return m_entries[n];}
+      // true if values were dropped since the buffer was full
+      bool overflow() const { return m_overflow;}
+      trilaterate_status get_status() const { return m_status;}
+
+      void print(std::ostream & out) const
+      {
+         for ( std::size_t n = 0; n < m_size; ++n){
+            entry const & e = m_entries[n];
+            out << e.name << " = ";
+            switch (e.kind){
+               case value_kind::point:
+                  out << point{quan::length::km{e.value[0]},quan::length::km{e.value[1]},quan::length::km{e.value[2]}};
+                  break;
+               case value_kind::direction:
+                  out << quan::three_d::vect<double>{e.value[0],e.value[1],e.value[2]};
+                  break;
+               default:
+                  out << quan::angle::deg{quan::angle::rad{e.value[0]}};
+                  break;
+            }
+            out << '\n';
+         }
+         if ( m_overflow){
+            out << "...\n";
+         }
+         out << "status = " << trilaterate_status_message(m_status) << '\n';
+      }
+
+   private:
+
+      template <typename Q>
+      static double numeric(Q const & q) { return q.numeric_value();}
+      static double numeric(double v) { return v;}
+      static double numeric(float v) { return v;}
+
+      void push(entry const & e)
+      {
+         if ( m_size < m_entries.size()){
+            m_entries[m_size++] = e;
+         }else{
+            m_overflow = true;
+         }
+      }
+
+      std::vector<entry> m_entries;
+      std::size_t m_size;
+      bool m_overflow;
+      trilaterate_status m_status;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_TRILATERATE_TRACE_HPP_INCLUDED
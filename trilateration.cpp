@@ -31,12 +31,7 @@ int main()
 
    // we use 2d points here. 3D points could be used, but their z values must be 0
    // point pA must be at the origin
-   // TODO
-   // Translate by V all points so that pA is at origin
-   // rotate  all points by alpha until pB is on the x axis
-   // do calc
-   // rotate result by - alpha
-   // translate result by -V
+   // see trilaterate_2d.hpp for circles at any position
    point constexpr pA{0.0_km,0.0_km};
 
    assert( (pA == point{0.0_km, 0.0_km}));
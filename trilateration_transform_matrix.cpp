@@ -25,8 +25,10 @@
 #include <quan/fun/display_matrix.hpp>
 #include <fstream>
 
-// calc diagnostic output
+// calc diagnostic output ( define NO_DEBUG_PRINT to turn off)
+#if ! defined NO_DEBUG_PRINT
 #define DEBUG_PRINT
+#endif
 // to remove unnecessary calcs ( otherwise useful for exposition )
 #define MINIMAL_VECT_CALCS
 
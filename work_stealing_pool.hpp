@@ -0,0 +1,230 @@
+#ifndef TRILATERATION_WORK_STEALING_POOL_HPP_INCLUDED
+#define TRILATERATION_WORK_STEALING_POOL_HPP_INCLUDED
+
+/*
+  thread pool for splitting a range of work into chunks over all cores
+
+  parallel_for divides the chunks evenly between the threads
+  each thread works through its own chunks from the front,
+  and once out of work steals the back half of the remaining chunks of another thread
+  the calling thread takes part as thread 0
+
+  the work function is passed by reference so nothing is allocated per call
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+   class work_stealing_pool{
+   public:
+
+      // num_threads includes the calling thread, 0 for one per core
+      // pin_threads binds worker thread n to core n modulo the number of cores
+      // the calling thread is left unpinned, as it outlives the pool, leaving core 0 for it
+      explicit work_stealing_pool(unsigned num_threads = 0, bool pin_threads = false)
+      : m_num_threads{ (num_threads > 0) ? num_threads : std::max(1U,std::thread::hardware_concurrency())}
+      , m_ranges{new padded_range[m_num_threads]}
+      , m_generation{0}
+      , m_num_busy{0}
+      , m_stop{false}
+      , m_work{nullptr}
+      , m_work_fn{nullptr}
+      , m_size{0}
+      , m_chunk_size{1}
+      {
+         for ( unsigned t = 1; t < m_num_threads; ++t){
+            m_threads.emplace_back([this,t,pin_threads]{
+               if ( pin_threads){
+                  pin_to_core(t);
+               }
+               worker(t);
+            });
+         }
+      }
+
+      ~work_stealing_pool()
+      {
+         {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+         }
+         m_start.notify_all();
+         for ( auto & t : m_threads){
+            t.join();
+         }
+      }
+
+      work_stealing_pool(work_stealing_pool const &) = delete;
+      work_stealing_pool& operator = (work_stealing_pool const &) = delete;
+
+      unsigned num_threads() const { return m_num_threads;}
+
+      /*
+        calls f(begin,end) over [0,size) in chunks of chunk_size ( the last may be shorter)
+        each chunk is done once, by any thread, so f must only write to its own chunk
+        returns when all the chunks are done
+        not to be called concurrently on the same pool
+      */
+      template <typename F>
+      void parallel_for(std::size_t size, std::size_t chunk_size, F const & f)
+      {
+         if ( size == 0){
+            return;
+         }
+         chunk_size = std::max<std::size_t>(chunk_size,1);
+         std::uint64_t const num_chunks = (size + chunk_size - 1) / chunk_size;
+         for ( unsigned t = 0; t < m_num_threads; ++t){
+            m_ranges[t].range.store(
+               make_range(num_chunks * t / m_num_threads, num_chunks * (t + 1) / m_num_threads),
+               std::memory_order_relaxed);
+         }
+         {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_work = &f;
+            m_work_fn = [](void const * work, std::size_t begin, std::size_t end){
+               (*static_cast<F const *>(work))(begin,end);
+            };
+            m_size = size;
+            m_chunk_size = chunk_size;
+            m_num_busy = m_num_threads - 1;
+            ++m_generation;
+         }
+         m_start.notify_all();
+         run_chunks(0);
+         std::unique_lock<std::mutex> lock{m_mutex};
+         m_done.wait(lock,[this]{ return m_num_busy == 0;});
+         m_work = nullptr;
+      }
+
+   private:
+
+      // chunk range [begin,end) of one thread packed for compare and swap
+      static std::uint64_t make_range(std::uint64_t begin, std::uint64_t end) { return (begin << 32) | end;}
+      static std::uint64_t range_begin(std::uint64_t r) { return r >> 32;}
+      static std::uint64_t range_end(std::uint64_t r) { return r & 0xFFFFFFFF;}
+
+      // own cache line so threads taking chunks dont contend
+      struct alignas(64) padded_range{
+         std::atomic<std::uint64_t> range{0};
+      };
+
+      static void pin_to_core(unsigned t)
+      {
+#if defined(__linux__)
+         cpu_set_t cpus;
+         CPU_ZERO(&cpus);
+         CPU_SET(t % std::max(1U,std::thread::hardware_concurrency()),&cpus);
+         pthread_setaffinity_np(pthread_self(),sizeof(cpus),&cpus);
+#else
+         (void)t;
+#endif
+      }
+
+      void do_chunk(std::uint64_t chunk)
+      {
+         std::size_t const begin = chunk * m_chunk_size;
+         m_work_fn(m_work,begin,std::min(begin + m_chunk_size,m_size));
+      }
+
+      // take the first chunk of thread t
+      bool take_own(unsigned t, std::uint64_t & chunk)
+      {
+         auto & range = m_ranges[t].range;
+         std::uint64_t r = range.load(std::memory_order_acquire);
+         while ( range_begin(r) < range_end(r)){
+            if ( range.compare_exchange_weak(r,make_range(range_begin(r) + 1,range_end(r)),std::memory_order_acq_rel)){
+               chunk = range_begin(r);
+               return true;
+            }
+         }
+         return false;
+      }
+
+      // move the back half of the chunks of victim to thief
+      bool steal(unsigned thief, unsigned victim)
+      {
+         auto & range = m_ranges[victim].range;
+         std::uint64_t r = range.load(std::memory_order_acquire);
+         while ( range_begin(r) < range_end(r)){
+            std::uint64_t const mid = range_begin(r) + (range_end(r) - range_begin(r)) / 2;
+            if ( range.compare_exchange_weak(r,make_range(range_begin(r),mid),std::memory_order_acq_rel)){
+               m_ranges[thief].range.store(make_range(mid,range_end(r)),std::memory_order_release);
+               return true;
+            }
+         }
+         return false;
+      }
+
+      void run_chunks(unsigned t)
+      {
+         for (;;){
+            std::uint64_t chunk;
+            while ( take_own(t,chunk)){
+               do_chunk(chunk);
+            }
+            bool stolen = false;
+            for ( unsigned n = 1; (n < m_num_threads) && !stolen; ++n){
+               stolen = steal(t,(t + n) % m_num_threads);
+            }
+            if ( !stolen){
+               return;
+            }
+         }
+      }
+
+      void worker(unsigned t)
+      {
+         std::uint64_t generation = 0;
+         for (;;){
+            {
+               std::unique_lock<std::mutex> lock{m_mutex};
+               m_start.wait(lock,[&]{ return m_stop || (m_generation != generation);});
+               if ( m_stop){
+                  return;
+               }
+               generation = m_generation;
+            }
+            run_chunks(t);
+            {
+               std::lock_guard<std::mutex> lock{m_mutex};
+               --m_num_busy;
+            }
+            m_done.notify_one();
+         }
+      }
+
+      unsigned const m_num_threads;
+      std::unique_ptr<padded_range[]> m_ranges;
+      std::vector<std::thread> m_threads;
+
+      std::mutex m_mutex;
+      std::condition_variable m_start;
+      std::condition_variable m_done;
+      std::uint64_t m_generation;
+      unsigned m_num_busy;
+      bool m_stop;
+
+      // current parallel_for
+      void const * m_work;
+      void (*m_work_fn)(void const *, std::size_t, std::size_t);
+      std::size_t m_size;
+      std::size_t m_chunk_size;
+   };
+
+} // namespace
+
+#endif // TRILATERATION_WORK_STEALING_POOL_HPP_INCLUDED